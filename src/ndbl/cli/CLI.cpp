@@ -2,6 +2,8 @@
 
 #include <iostream>
 
+#include "ndbl/core/Bytecode.h"
+#include "ndbl/core/Profiler.h"
 #include "ndbl/core/language/Nodlang.h"
 #include "tools/core/TaskManager.h"
 #include "tools/core/reflection/reflection"
@@ -13,6 +15,7 @@ using namespace tools;
 void CLI::init()
 {
     NodableHeadless::init();
+    m_interpreter->set_trace(&m_trace);
     std::cout <<
         "== Nodable CLI == command line interface =="
         << std::endl <<
@@ -36,11 +39,18 @@ void CLI::init()
         .add_method(&API::compile          , "compile")
         .add_method(&API::set_verbose      , "set_verbose")
         .add_method(&API::print_program    , "print program" )
+        .add_method(&API::print_cache      , "print cache" )
+        .add_method(&API::profile          , "profile" )
+        .add_method(&API::print_trace      , "print trace" )
+        .add_method(&API::jit              , "jit" )
+        .add_method(&API::save_bytecode    , "save bytecode" )
+        .add_method(&API::run_bytecode     , "run bytecode" )
         .add_method(&API::run              , "run");
 }
 
 void CLI::shutdown()
 {
+    m_interpreter->set_trace(nullptr);
     // TODO: implement tools::registration::pop_class<CLI::PublicApi>
     NodableHeadless::shutdown();
     std::cout << "Good bye!" << std::endl;
@@ -164,11 +174,108 @@ bool CLI::PublicApi::parse()
 {
     // ask for user input
     std::cout << ">>> ";
-    std::string parse_in = get_line();
-    Graph* graph = m_cli->parse(parse_in);
+    m_cli->m_source_code = get_line(); // kept alive for the tokens (cf. profile())
+    Graph* graph = m_cli->parse(m_cli->m_source_code);
     return graph;
 }
 
+void CLI::PublicApi::print_cache()
+{
+    const CodeCache& cache = m_cli->get_code_cache();
+    printf("Code cache: %zu code(s), %zu/%zu bytes, %zu hit(s), %zu miss(es), %zu eviction(s)\n",
+           cache.size(),
+           cache.get_memory_usage(),
+           cache.get_memory_budget(),
+           cache.get_hit_count(),
+           cache.get_miss_count(),
+           cache.get_eviction_count());
+}
+
+bool CLI::PublicApi::profile()
+{
+    if( m_cli->get_graph()->root() == nullptr )
+    {
+        LOG_WARNING("CLI", "unable to profile! Are you sure you entered an expression earlier?\n");
+        return false;
+    }
+
+    // debug info are required to map the instructions to their node
+    const Code* code = m_cli->compile(m_cli->get_graph(), CompilerFlag_DEBUG_INFO);
+    if( code == nullptr )
+    {
+        LOG_ERROR("CLI", "unable to compile!\n");
+        return false;
+    }
+
+    Profiler profiler;
+    m_cli->get_interpreter()->set_profiler(&profiler);
+    const bool success = m_cli->load_program(code) && m_cli->run_program();
+    m_cli->release_program();
+    m_cli->get_interpreter()->set_profiler(nullptr);
+
+    if( success )
+    {
+        std::cout << profiler.to_string(&m_cli->get_language()->_state.tokens()) << std::endl;
+    }
+    else
+    {
+        LOG_ERROR("CLI", "Unable to run program!\n");
+    }
+    delete code;
+    return success;
+}
+
+void CLI::PublicApi::print_trace()
+{
+    std::cout << m_cli->m_trace.to_string(m_cli->m_asm_code) << std::endl;
+}
+
+void CLI::PublicApi::jit()
+{
+    if ( !Jit::is_supported() )
+    {
+        printf("JIT is not supported on this platform\n");
+        return;
+    }
+    // the machine code does not record the instructions run, the trace is detached while the JIT is ON
+    const bool enabled = !m_cli->is_jit_enabled();
+    m_cli->set_jit_enabled(enabled);
+    m_cli->get_interpreter()->set_trace(enabled ? nullptr : &m_cli->m_trace);
+    printf("JIT %s\n", enabled ? "ON (trace disabled)" : "OFF");
+}
+
+bool CLI::PublicApi::save_bytecode()
+{
+    const Code* code = m_cli->compile();
+    if( code == nullptr )
+    {
+        LOG_ERROR("CLI", "unable to compile!\n");
+        return false;
+    }
+
+    std::cout << "path: ";
+    return Bytecode::save(code, get_line());
+}
+
+bool CLI::PublicApi::run_bytecode()
+{
+    std::cout << "path: ";
+    Code* code = Bytecode::load(get_line());
+    if( code == nullptr )
+    {
+        return false;
+    }
+
+    const bool success = m_cli->load_program(code) && m_cli->run_program();
+    m_cli->release_program();
+    if( !success )
+    {
+        LOG_ERROR("CLI", "Unable to run program!\n");
+    }
+    delete code;
+    return success;
+}
+
 void CLI::PublicApi::help()
 {
     std::vector<std::string> command_names;
@@ -216,7 +323,7 @@ bool CLI::run()
 
     if( !run_program() )
     {
-        LOG_ERROR("CLI", "Unable to run program!\n");
+        LOG_ERROR("CLI", "Unable to run program! Last instructions:\n%s\n", m_trace.to_string(m_asm_code, 16).c_str());
         return false;
     }
 
@@ -33,6 +33,12 @@ namespace ndbl
             bool          serialize();
             void          set_verbose();
             int           print_program();
+            void          print_cache();
+            bool          profile();
+            void          print_trace();
+            void          jit();
+            bool          save_bytecode();
+            bool          run_bytecode();
         private:
             CLI*          m_cli;
         };
@@ -52,6 +58,8 @@ namespace ndbl
         tools::variant invoke_static(const tools::FunctionDescriptor* _func_type, std::vector<tools::variant>&& _args) const;
         tools::variant invoke_method(const tools::FunctionDescriptor* _func_type, std::vector<tools::variant>&& _args) const;
 
+        Trace              m_trace; // last instructions run, kept for post-mortems (cf. print_trace())
+
         static std::string get_line() ;
         static void log_function_call(const tools::variant &result, const tools::FunctionDescriptor *type) ;
     };
@@ -0,0 +1,145 @@
+#include "AotProgram.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#if NDBL_AOT
+#   include <dlfcn.h>
+#   include <spawn.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+#endif
+#include "tools/core/assertions.h"
+#include "tools/core/log.h"
+#include "CEmitter.h"
+
+using namespace ndbl;
+#if NDBL_AOT
+extern char** environ; // passed to the compiler
+#endif
+
+bool AotProgram::build(const std::string& _source, const std::string& _path)
+{
+    release();
+    m_error.clear();
+#if NDBL_AOT
+    const std::string source_path = _path + ".cpp";
+    {
+        std::ofstream file(source_path, std::ios::binary);
+        file << _source;
+        if ( !file )
+        {
+            m_error = "Unable to write " + source_path;
+            LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+            return false;
+        }
+    }
+
+    const char* compiler = std::getenv("NDBL_AOT_CXX");
+    if ( compiler == nullptr ) compiler = std::getenv("CXX");
+    if ( compiler == nullptr ) compiler = "c++";
+
+    // the compiler is spawned with an argument array (no shell, the paths are never interpreted), its output is read from a pipe
+    const char* args[] = { compiler, "-std=c++17", "-O2", "-shared", "-fPIC", "-o", _path.c_str(), source_path.c_str(), nullptr };
+    LOG_VERBOSE("AotProgram", "%s -std=c++17 -O2 -shared -fPIC -o %s %s\n", compiler, _path.c_str(), source_path.c_str());
+
+    int output[2];
+    if ( pipe(output) != 0 )
+    {
+        m_error = "Unable to create a pipe";
+        LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+        return false;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, output[0]);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose(&actions, output[1]);
+
+    pid_t pid;
+    const int spawned = posix_spawnp(&pid, compiler, &actions, nullptr, const_cast<char* const*>(args), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(output[1]);
+    if ( spawned != 0 )
+    {
+        close(output[0]);
+        m_error = std::string("Unable to run ") + compiler + ": " + strerror(spawned);
+        LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+        return false;
+    }
+    char    buffer[256];
+    ssize_t count;
+    while ( (count = read(output[0], buffer, sizeof(buffer))) > 0 || (count < 0 && errno == EINTR) )
+    {
+        if ( count > 0 )
+            m_error.append(buffer, (size_t)count);
+    }
+    close(output[0]);
+
+    int   status = 0;
+    pid_t waited;
+    while ( (waited = waitpid(pid, &status, 0)) == -1 && errno == EINTR ) {}
+    if ( waited == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+    {
+        m_error = "Unable to build " + source_path + ":\n" + m_error;
+        LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+        return false;
+    }
+    m_error.clear(); // warnings
+
+    return load(_path);
+#else
+    m_error = "Ahead-of-time compilation is not supported on this platform";
+    LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+    return false;
+#endif
+}
+
+bool AotProgram::load(const std::string& _path)
+{
+    release();
+    m_error.clear();
+#if NDBL_AOT
+    m_handle = dlopen(_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if ( m_handle == nullptr )
+    {
+        m_error = dlerror();
+        LOG_ERROR("AotProgram", "Unable to load %s: %s\n", _path.c_str(), m_error.c_str());
+        return false;
+    }
+    m_entry = (Entry)dlsym(m_handle, CEmitter::ENTRY_POINT);
+    if ( m_entry == nullptr )
+    {
+        m_error = _path + " has no " + CEmitter::ENTRY_POINT + "() function";
+        LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+        release();
+        return false;
+    }
+    return true;
+#else
+    m_error = "Ahead-of-time compilation is not supported on this platform";
+    LOG_ERROR("AotProgram", "%s\n", m_error.c_str());
+    return false;
+#endif
+}
+
+void AotProgram::release()
+{
+#if NDBL_AOT
+    if ( m_handle != nullptr )
+    {
+        dlclose(m_handle);
+    }
+#endif
+    m_handle = nullptr;
+    m_entry  = nullptr;
+}
+
+bool AotProgram::run(AotResult& _result) const
+{
+    VERIFY(m_entry != nullptr, "No program is loaded");
+    return m_entry(&_result) == 0;
+}
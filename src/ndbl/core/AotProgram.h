@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include "tools/core/types.h"
+#include "tools/core/reflection/qword.h"
+
+// An AotProgram is a shared object built by the system compiler and loaded with dlopen, it is available on POSIX systems only.
+#if defined(__unix__) || defined(__APPLE__)
+#   define NDBL_AOT 1
+#else
+#   define NDBL_AOT 0
+#endif
+
+namespace ndbl
+{
+    // Type of an AotResult's value
+    enum AotType
+    {
+        AotType_NONE = 0,
+        AotType_BOOL,
+        AotType_I32,
+        AotType_DOUBLE,
+        AotType_STRING,
+    };
+
+    // Result of a program compiled ahead-of-time, same layout as the struct declared by the emitted code (cf. CEmitter).
+    // The value is the last statement's (as Interpreter::get_last_result() would return it).
+    struct AotResult
+    {
+        i32_t        type   = AotType_NONE;
+        tools::qword value;
+        const char*  string = nullptr; // AotType_STRING only, valid until the next run
+        const char*  error  = nullptr; // message of the exception which stopped the program, if any (valid until the next run)
+    };
+
+    /**
+     * @class Program compiled ahead-of-time: the C++ translation unit emitted by a CEmitter, built into a shared object.
+     * The shared object exports a single function (cf. CEmitter::ENTRY_POINT), each run() calls it once.
+     * The system compiler is "c++", it can be changed with the NDBL_AOT_CXX (or CXX) environment variable (a program name or path, it is run without a shell).
+     */
+    class AotProgram
+    {
+    public:
+        typedef int (*Entry)(AotResult*); // Returns 0, or 1 when an exception stopped the program (cf. AotResult::error).
+
+        AotProgram() = default;
+        AotProgram(const AotProgram&) = delete;
+        AotProgram& operator=(const AotProgram&) = delete;
+        ~AotProgram() { release(); }
+
+        static bool         is_supported() { return NDBL_AOT; }  // Check if a shared object can be built and loaded on this platform.
+        bool                build(const std::string& _source, const std::string& _path); // Write a given source to "<_path>.cpp", build it to a shared object at _path, and load it (the previous one is released).
+        bool                load(const std::string& _path);      // Load a shared object built previously (the previous one is released).
+        void                release();                           // Unload the shared object.
+        bool                is_loaded() const { return m_entry != nullptr; }
+        bool                run(AotResult&) const;               // Run the program once, returns false when an exception stopped it.
+        const std::string&  get_error() const { return m_error; } // Get the last build/load error (compiler output included).
+    private:
+        void*       m_handle = nullptr;
+        Entry       m_entry  = nullptr;
+        std::string m_error;
+    };
+} // namespace ndbl
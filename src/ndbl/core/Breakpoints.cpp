@@ -0,0 +1,102 @@
+#include "Breakpoints.h"
+
+#include <algorithm>
+#include "tools/core/assertions.h"
+#include "Code.h"
+
+using namespace ndbl;
+
+void Breakpoints::bind(const Code* _code)
+{
+    m_code      = _code;
+    m_bit_count = _code != nullptr ? _code->size() : 0;
+    m_bits.assign((m_bit_count + 63) / 64, 0);
+    m_ranges.clear();
+    if ( _code == nullptr )
+    {
+        return;
+    }
+
+    // consecutive instructions of the same node form a range
+    for ( size_t i = 0; i < _code->size(); ++i )
+    {
+        const Code::DebugInfo* debug_info = _code->get_debug_info(i);
+        if ( debug_info == nullptr || debug_info->node == nullptr )
+        {
+            continue;
+        }
+        std::vector<Range>& ranges = m_ranges[debug_info->node];
+        if ( !ranges.empty() && ranges.back().end == i )
+        {
+            ranges.back().end++;
+        }
+        else
+        {
+            ranges.push_back({ i, i + 1 });
+        }
+    }
+
+    for ( const Node* each : m_nodes )
+    {
+        const std::vector<Range>& ranges = get_ranges(each);
+        if ( !ranges.empty() )
+        {
+            set_bit(ranges.front().begin, true);
+        }
+    }
+}
+
+void Breakpoints::set(const Node* _node, bool _enabled)
+{
+    if ( _enabled )
+    {
+        m_nodes.insert(_node);
+    }
+    else
+    {
+        m_nodes.erase(_node);
+    }
+
+    const std::vector<Range>& ranges = get_ranges(_node);
+    if ( !ranges.empty() )
+    {
+        set_bit(ranges.front().begin, _enabled);
+    }
+}
+
+void Breakpoints::clear()
+{
+    m_nodes.clear();
+    std::fill(m_bits.begin(), m_bits.end(), 0);
+}
+
+const std::vector<Breakpoints::Range>& Breakpoints::get_ranges(const Node* _node) const
+{
+    static const std::vector<Range> no_range;
+    auto found = m_ranges.find(_node);
+    return found != m_ranges.end() ? found->second : no_range;
+}
+
+const Node* Breakpoints::get_node(size_t _index) const
+{
+    if ( m_code == nullptr || _index >= m_code->size() )
+    {
+        return nullptr;
+    }
+    const Code::DebugInfo* debug_info = m_code->get_debug_info(_index);
+    return debug_info != nullptr ? debug_info->node : nullptr;
+}
+
+void Breakpoints::set_bit(size_t _index, bool _value)
+{
+    ASSERT(_index < m_bit_count);
+    const u64_t mask = u64_t(1) << (_index % 64);
+    if ( _value )
+    {
+        m_bits[_index / 64] |= mask;
+    }
+    else
+    {
+        m_bits[_index / 64] &= ~mask;
+    }
+}
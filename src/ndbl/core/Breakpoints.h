@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "tools/core/types.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+    class Node;
+
+    /**
+     * @class Breakpoints of a debugged program (cf. Interpreter::set_breakpoint()).
+     * A bitset tells which instructions are breakpoints, and each Node is mapped to the ranges of instructions compiled from it
+     * (this requires the code to have debug info, cf. CompilerFlag_DEBUG_INFO).
+     * Breakpoints are set on nodes, they survive a recompilation: they are resolved to instructions each time a code is bound.
+     * A node breaks at its first instruction.
+     */
+    class Breakpoints
+    {
+    public:
+        // A range of instructions [begin, end[
+        struct Range
+        {
+            size_t begin;
+            size_t end;
+        };
+
+        void                      bind(const Code*);                       // Map the nodes to the instructions of a given code (nullptr to unbind), and resolve the breakpoints.
+        void                      set(const Node*, bool _enabled = true);  // Set (or unset) a breakpoint on a given node.
+        bool                      has(const Node* _node) const { return m_nodes.find(_node) != m_nodes.end(); }
+        void                      clear();                                 // Remove all the breakpoints.
+        bool                      empty() const { return m_nodes.empty(); }
+        bool                      has_instruction(size_t _index) const     // Check if a given instruction is a breakpoint (of the code bound).
+        { return _index < m_bit_count && ( m_bits[_index / 64] >> (_index % 64) ) & 1; }
+        const std::vector<Range>& get_ranges(const Node*) const;          // Get the instructions compiled from a given node (in the code bound), ordered.
+        const Node*               get_node(size_t _index) const;           // Get the node a given instruction was compiled from (in the code bound), nullptr when unknown.
+        const std::unordered_set<const Node*>&
+                                  get_nodes() const { return m_nodes; }
+    private:
+        void                      set_bit(size_t _index, bool _value);
+        std::unordered_set<const Node*>                      m_nodes;      // nodes having a breakpoint.
+        const Code*                                          m_code = nullptr;
+        std::vector<u64_t>                                   m_bits;       // one per instruction of the code bound.
+        size_t                                               m_bit_count = 0;
+        std::unordered_map<const Node*, std::vector<Range>> m_ranges;     // instructions of each node of the code bound.
+    };
+} // namespace ndbl
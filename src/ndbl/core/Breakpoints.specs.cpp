@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "fixtures/core.h"
+#include "ndbl/core/Breakpoints.h"
+
+using namespace ndbl;
+typedef ::testing::Core Breakpoints_;
+
+static const char* PROGRAM = "int sum = 1; for(int i = 0; i < 10; i = i + 1) { sum = sum * 2; } return(sum);";
+
+TEST_F(Breakpoints_, maps_each_node_to_its_instructions)
+{
+    Graph*      graph    = app.parse(PROGRAM);
+    const Code* code     = app.compile(graph, CompilerFlag_DEBUG_INFO);
+    const Node* multiply = find_node(graph, "*");
+    ASSERT_TRUE(multiply != nullptr);
+
+    Breakpoints breakpoints;
+    breakpoints.set(multiply);
+    breakpoints.bind(code);
+
+    const std::vector<Breakpoints::Range>& ranges = breakpoints.get_ranges(multiply);
+    ASSERT_FALSE(ranges.empty());
+    for ( const Breakpoints::Range& range : ranges )
+        for ( size_t i = range.begin; i < range.end; ++i )
+            EXPECT_EQ(breakpoints.get_node(i), multiply);
+
+    EXPECT_TRUE(breakpoints.has_instruction(ranges.front().begin));
+    breakpoints.set(multiply, false);
+    EXPECT_FALSE(breakpoints.has_instruction(ranges.front().begin));
+    delete code;
+}
+
+TEST_F(Breakpoints_, debug_continue_stops_at_each_breakpoint)
+{
+    Graph*       graph       = app.parse(PROGRAM);
+    const Code*  code        = app.compile(graph, CompilerFlag_DEBUG_INFO);
+    Interpreter* interpreter = app.get_interpreter();
+    const Node*  multiply    = find_node(graph, "*");
+    ASSERT_TRUE(multiply != nullptr);
+
+    interpreter->set_breakpoint(multiply);
+    ASSERT_TRUE(app.load_program(code));
+
+    // run_program() ignores them
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 1024);
+
+    interpreter->debug_program();
+    size_t hit_count = 0;
+    while ( interpreter->debug_continue() )
+    {
+        ++hit_count;
+        EXPECT_EQ(interpreter->get_next_node(), multiply);
+    }
+    EXPECT_EQ(hit_count, 10);
+    EXPECT_TRUE(interpreter->is_program_stopped());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 1024);
+
+    interpreter->clear_breakpoints();
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Breakpoints_, survive_a_recompilation)
+{
+    Graph*       graph       = app.parse(PROGRAM);
+    Interpreter* interpreter = app.get_interpreter();
+    const Node*  multiply    = find_node(graph, "*");
+    ASSERT_TRUE(multiply != nullptr);
+    interpreter->set_breakpoint(multiply);
+
+    for ( int i = 0; i < 2; ++i )
+    {
+        const Code* code = app.compile(graph, CompilerFlag_DEBUG_INFO);
+        ASSERT_TRUE(app.load_program(code));
+        interpreter->debug_program();
+        EXPECT_TRUE(interpreter->debug_continue());
+        EXPECT_EQ(interpreter->get_next_node(), multiply);
+        app.release_program();
+        delete code;
+    }
+    interpreter->clear_breakpoints();
+}
+
+TEST_F(Breakpoints_, debug_step_over_runs_the_whole_program)
+{
+    const Code*  code        = app.compile(app.parse(PROGRAM), CompilerFlag_DEBUG_INFO);
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    interpreter->debug_program();
+    while ( interpreter->debug_step_over() ) {}
+    EXPECT_TRUE(interpreter->is_program_stopped());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 1024);
+
+    app.release_program();
+    delete code;
+}
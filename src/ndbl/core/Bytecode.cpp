@@ -0,0 +1,854 @@
+#include "Bytecode.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#if NDBL_BYTECODE_MMAP
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+#include "tools/core/Hash.h"
+#include "tools/core/log.h"
+#include "tools/core/reflection/Invokable.h"
+#include "tools/core/reflection/TypeRegister.h"
+#include "ndbl/core/language/Nodlang.h"
+#include "Code.h"
+
+using namespace ndbl;
+using namespace tools;
+
+namespace // anonymous, accessible only in that file
+{
+    constexpr char   MAGIC[4]  = { 'N', 'D', 'B', 'C' };
+    constexpr size_t ALIGNMENT = 64;        // instructions start on a cache line
+    constexpr u32_t  NO_INDEX  = (u32_t)-1; // index of a nullptr
+
+    typedef u32_t FileFlags;
+    enum FileFlag_ : u32_t
+    {
+        FileFlag_NONE       = 0,
+        FileFlag_DEBUG_INFO = 1 << 0, // the debug table is present
+    };
+
+    // Records of a section (offset is in bytes from the beginning of the file, count is in records)
+    struct Section
+    {
+        u64_t offset;
+        u64_t count;
+    };
+
+    // A string of the string pool
+    struct StringRef
+    {
+        u32_t offset;
+        u32_t size;
+    };
+
+    struct Header
+    {
+        char      magic[4];
+        u32_t     version;
+        u32_t     instruction_size;
+        u32_t     opcode_count;
+        FileFlags flags;
+        u32_t     reserved;
+        u64_t     file_size;
+        u64_t     stack_size;
+        Section   instructions;       // Instruction[], their pointers are replaced by table indexes
+        Section   strings;            // char[]
+        Section   types;              // TypeRecord[]
+        Section   functions;          // FunctionRecord[]
+        Section   constants;          // ConstantRecord[], the Code's constant pool
+        Section   inputs;             // StringRef[], identifiers of the input variables
+        Section   dataflows;          // DataflowRecord[]
+        Section   dataflow_constants; // ConstantRecord[]
+        Section   tasks;              // TaskRecord[]
+        Section   operands;           // OperandRecord[]
+        Section   debug_info;         // StringRef[], a comment per instruction (empty without FileFlag_DEBUG_INFO)
+    };
+
+    struct TypeRecord
+    {
+        StringRef name; // compiler name (cf. TypeDescriptor::compiler_name())
+    };
+
+    struct FunctionRecord
+    {
+        u64_t     hash;      // hash of the signature (cf. Nodlang::find_function(u64_t))
+        StringRef signature; // serialized signature (cf. Nodlang::serialize_func_sig())
+    };
+
+    struct ConstantRecord
+    {
+        qword     value;     // bool, numbers
+        u32_t     type;      // index in the type table
+        StringRef string;    // std::string only
+        u32_t     reserved;
+    };
+
+    struct DataflowRecord
+    {
+        u32_t input_count;
+        u32_t first_constant; // index in the dataflow constants
+        u32_t constant_count;
+        u32_t first_task;
+        u32_t task_count;
+    };
+
+    struct TaskRecord
+    {
+        u32_t function;       // index in the function table
+        u32_t first_operand;
+        u32_t operand_count;
+        u32_t is_expensive;
+    };
+
+    struct OperandRecord
+    {
+        u32_t type;           // Dataflow::OperandType
+        u32_t index;
+    };
+
+    static_assert(sizeof(Header) == 216 && sizeof(ConstantRecord) == 24, "Records are written as is, they must have no padding");
+
+    // Append some records to a buffer (aligned), returns their section
+    template<typename T>
+    Section append(std::string& _buffer, const T* _records, size_t _count, size_t _alignment = alignof(T))
+    {
+        _buffer.resize( (_buffer.size() + _alignment - 1) / _alignment * _alignment, '\0' );
+        const Section section{ _buffer.size(), _count };
+        _buffer.append( reinterpret_cast<const char*>(_records), _count * sizeof(T) );
+        return section;
+    }
+
+    template<typename T>
+    Section append(std::string& _buffer, const std::vector<T>& _records)
+    {
+        return append(_buffer, _records.data(), _records.size());
+    }
+
+    // Tables of a file being saved (pointers are saved as indexes in these)
+    struct Tables
+    {
+        std::string                                            strings;
+        std::vector<TypeRecord>                                types;
+        std::vector<FunctionRecord>                            functions;
+        std::unordered_map<const TypeDescriptor*, u32_t>       type_index;
+        std::unordered_map<const IInvokable*, u32_t>           function_index;
+
+        StringRef add_string(std::string_view _string)
+        {
+            const StringRef ref{ (u32_t)strings.size(), (u32_t)_string.size() };
+            strings.append(_string);
+            return ref;
+        }
+
+        u32_t add_type(const TypeDescriptor* _type)
+        {
+            if ( _type == nullptr )
+            {
+                return NO_INDEX;
+            }
+            if ( _type->compiler_name() == nullptr )
+            {
+                throw std::runtime_error(std::string("Type has no compiler name: ") + _type->name());
+            }
+            auto [it, inserted] = type_index.emplace(_type, (u32_t)types.size());
+            if ( inserted )
+            {
+                types.push_back({ add_string(_type->compiler_name()) });
+            }
+            return it->second;
+        }
+
+        u32_t add_function(const IInvokable* _invokable)
+        {
+            auto found = function_index.find(_invokable);
+            if ( found != function_index.end() )
+            {
+                return found->second;
+            }
+            std::string signature;
+            get_language()->serialize_func_sig(signature, _invokable->get_sig());
+            const u64_t hash = Hash::hash(signature.c_str());
+            if ( get_language()->find_function(hash) == nullptr )
+            {
+                throw std::runtime_error("Function is not declared: " + signature);
+            }
+            function_index.emplace(_invokable, (u32_t)functions.size());
+            functions.push_back({ hash, add_string(signature) });
+            return (u32_t)functions.size() - 1;
+        }
+
+        ConstantRecord add_constant(const variant& _value)
+        {
+            const TypeDescriptor* type = _value.get_type();
+            ConstantRecord record{};
+            record.type = add_type(type);
+            if ( type->is<std::string>() )
+                record.string = add_string( _value.to<std::string>() );
+            else if ( type->is<bool>() || type->is<i16_t>() || type->is<i32_t>() || type->is<double>() )
+                record.value = *_value.data();
+            else if ( !type->is<null>() )
+                throw std::runtime_error(std::string("Unable to save a constant of type ") + type->name());
+            return record;
+        }
+    };
+
+    // Pointer fields of the instructions are saved as indexes in the tables (cf. Tables)
+    template<typename T>
+    void set_index(const T*& _field, u32_t _index)
+    {
+        _field = reinterpret_cast<const T*>( (uintptr_t)_index );
+    }
+
+    template<typename T>
+    u64_t get_index(const T* _field)
+    {
+        return (u64_t)reinterpret_cast<uintptr_t>(_field);
+    }
+
+    std::string serialize(const Code* _code)
+    {
+        const std::span<const Instruction> code_instructions = _code->get_instructions();
+        const bool has_debug_info = _code->get_meta_data().has_debug_info;
+        Tables     tables;
+
+        // instructions, pointers are replaced by indexes
+        std::vector<Instruction> instructions(code_instructions.begin(), code_instructions.end());
+        for ( Instruction& instr : instructions )
+        {
+            switch ( instr.opcode )
+            {
+                case OpCode_push_stack_frame:
+                case OpCode_pop_stack_frame:
+                    instr.push.scope = nullptr; // only used at compile time
+                    break;
+                case OpCode_push_var:
+                    set_index( instr.push.type, tables.add_type(instr.push.type) );
+                    break;
+                case OpCode_load:
+                case OpCode_load_ref:
+                case OpCode_store:
+                    set_index( instr.slot.type, tables.add_type(instr.slot.type) );
+                    break;
+                case OpCode_load_reg:
+                case OpCode_store_reg:
+                    set_index( instr.reg.type, tables.add_type(instr.reg.type) );
+                    break;
+                case OpCode_call:
+                case OpCode_call_native:
+                    set_index( instr.call.invokable, tables.add_function(instr.call.invokable) );
+                    break;
+                case OpCode_deref_qword:
+                case OpCode_trap:
+                    throw std::runtime_error(std::string("Unable to save an instruction ") + OpCode_to_string(instr.opcode));
+                default:
+                    break;
+            }
+        }
+
+        std::vector<ConstantRecord> constants;
+        for ( const variant& each : _code->get_constants() )
+        {
+            constants.push_back( tables.add_constant(each) );
+        }
+
+        std::vector<StringRef> inputs;
+        for ( const std::string& each : _code->get_meta_data().inputs )
+        {
+            inputs.push_back( tables.add_string(each) );
+        }
+
+        std::vector<DataflowRecord> dataflows;
+        std::vector<ConstantRecord> dataflow_constants;
+        std::vector<TaskRecord>     tasks;
+        std::vector<OperandRecord>  operands;
+        for ( const Dataflow& dataflow : _code->get_dataflows() )
+        {
+            dataflows.push_back({ (u32_t)dataflow.get_input_count(),
+                                  (u32_t)dataflow_constants.size(), (u32_t)dataflow.get_constants().size(),
+                                  (u32_t)tasks.size(), (u32_t)dataflow.get_task_count() });
+            for ( const variant& each : dataflow.get_constants() )
+            {
+                dataflow_constants.push_back( tables.add_constant(each) );
+            }
+            for ( size_t i = 0; i < dataflow.get_task_count(); ++i )
+            {
+                const Dataflow::Task& task = dataflow.get_task(i);
+                tasks.push_back({ tables.add_function(task.invokable), (u32_t)operands.size(), (u32_t)task.args.size(), task.is_expensive });
+                for ( const Dataflow::Operand& operand : task.args )
+                {
+                    operands.push_back({ operand.type, operand.index });
+                }
+            }
+        }
+
+        std::vector<StringRef> debug_info;
+        if ( has_debug_info )
+        {
+            for ( size_t i = 0; i < instructions.size(); ++i )
+            {
+                debug_info.push_back( tables.add_string(_code->get_debug_info(i)->comment) );
+            }
+        }
+
+        if ( tables.strings.size() > std::numeric_limits<u32_t>::max() )
+        {
+            throw std::runtime_error("String pool is too large");
+        }
+
+        Header header{};
+        std::string buffer(sizeof(Header), '\0'); // header is written last
+        header.instructions       = append(buffer, instructions.data(), instructions.size(), ALIGNMENT);
+        header.strings            = append(buffer, tables.strings.data(), tables.strings.size());
+        header.types              = append(buffer, tables.types);
+        header.functions          = append(buffer, tables.functions);
+        header.constants          = append(buffer, constants);
+        header.inputs             = append(buffer, inputs);
+        header.dataflows          = append(buffer, dataflows);
+        header.dataflow_constants = append(buffer, dataflow_constants);
+        header.tasks              = append(buffer, tasks);
+        header.operands           = append(buffer, operands);
+        header.debug_info         = append(buffer, debug_info);
+
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version          = Bytecode::VERSION;
+        header.instruction_size = sizeof(Instruction);
+        header.opcode_count     = OpCode_COUNT;
+        header.flags            = has_debug_info ? FileFlag_DEBUG_INFO : FileFlag_NONE;
+        header.file_size        = buffer.size();
+        header.stack_size       = _code->get_meta_data().stack_size;
+        memcpy(buffer.data(), &header, sizeof(Header));
+        return buffer;
+    }
+
+    // Map a given file to memory (copy on write), the mapping is released with the last reference to it
+    std::shared_ptr<void> map_file(const std::string& _path, size_t& _size)
+    {
+#if NDBL_BYTECODE_MMAP
+        const int file = open(_path.c_str(), O_RDONLY);
+        if ( file == -1 )
+        {
+            throw std::runtime_error(std::strerror(errno));
+        }
+        struct stat status{};
+        if ( fstat(file, &status) == -1 || (size_t)status.st_size < sizeof(Header) )
+        {
+            close(file);
+            throw std::runtime_error("File is not a bytecode file");
+        }
+        _size = (size_t)status.st_size;
+        void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0); // writable to relocate the pointers in place (the instruction pages are copied on write)
+        close(file); // the mapping keeps a reference to the file
+        if ( data == MAP_FAILED )
+        {
+            throw std::runtime_error(std::strerror(errno));
+        }
+        return { data, [size = _size](void* _data) { munmap(_data, size); } };
+#else
+        std::ifstream file(_path, std::ios::binary | std::ios::ate);
+        if ( !file )
+        {
+            throw std::runtime_error("Unable to open the file");
+        }
+        _size = (size_t)file.tellg();
+        if ( _size < sizeof(Header) )
+        {
+            throw std::runtime_error("File is not a bytecode file");
+        }
+        std::shared_ptr<void> data( ::operator new(_size, std::align_val_t(ALIGNMENT)),
+                                    [](void* _data) { ::operator delete(_data, std::align_val_t(ALIGNMENT)); } );
+        file.seekg(0);
+        if ( !file.read((char*)data.get(), (std::streamsize)_size) )
+        {
+            throw std::runtime_error("Unable to read the file");
+        }
+        return data;
+#endif
+    }
+
+    // A file being loaded, each access is checked (throws when out of bounds)
+    class Reader
+    {
+    public:
+        Reader(char* _data, size_t _size)
+        : m_data(_data)
+        , m_size(_size)
+        {
+            memcpy(&m_header, m_data, sizeof(Header));
+        }
+
+        const Header& header() const { return m_header; }
+
+        template<typename T>
+        std::span<T> section(const Section& _section, size_t _alignment = alignof(T)) const
+        {
+            if ( _section.offset > m_size || _section.offset % _alignment != 0 || _section.count > (m_size - _section.offset) / sizeof(T) )
+            {
+                throw std::runtime_error("A section is out of the file bounds");
+            }
+            return { reinterpret_cast<T*>(m_data + _section.offset), (size_t)_section.count };
+        }
+
+        std::string_view string(const StringRef& _ref) const
+        {
+            const std::span<const char> strings = section<const char>(m_header.strings);
+            if ( _ref.offset > strings.size() || _ref.size > strings.size() - _ref.offset )
+            {
+                throw std::runtime_error("A string is out of the string pool");
+            }
+            return { strings.data() + _ref.offset, _ref.size };
+        }
+
+    private:
+        char*  m_data;
+        size_t m_size;
+        Header m_header;
+    };
+
+    template<typename T>
+    T at(const std::vector<T>& _table, u64_t _index, const char* _table_name)
+    {
+        if ( _index >= _table.size() )
+        {
+            throw std::runtime_error(std::string("An index is out of the ") + _table_name + " table");
+        }
+        return _table[_index];
+    }
+
+    const TypeDescriptor* find_type(std::string_view _compiler_name)
+    {
+        for ( const auto& [index, type] : TypeRegister::by_index() )
+        {
+            if ( type->compiler_name() != nullptr && _compiler_name == type->compiler_name() )
+            {
+                return type;
+            }
+        }
+        throw std::runtime_error("Type is not registered: " + std::string(_compiler_name));
+    }
+
+    const IInvokable* find_function(const Reader& _reader, const FunctionRecord& _record)
+    {
+        const std::string_view saved     = _reader.string(_record.signature);
+        const IInvokable*      invokable = get_language()->find_function(_record.hash);
+        std::string            signature;
+        if ( invokable != nullptr )
+        {
+            get_language()->serialize_func_sig(signature, invokable->get_sig());
+        }
+        if ( signature != saved )
+        {
+            throw std::runtime_error("Function is not declared: " + std::string(saved));
+        }
+        return invokable;
+    }
+
+    variant to_variant(const Reader& _reader, const ConstantRecord& _record, const std::vector<const TypeDescriptor*>& _types)
+    {
+        const TypeDescriptor* type = at(_types, _record.type, "type");
+        if ( type->is<std::string>() ) return std::string(_reader.string(_record.string));
+        if ( type->is<bool>() )        return _record.value.b;
+        if ( type->is<i16_t>() )       return _record.value.i16;
+        if ( type->is<i32_t>() )       return _record.value.i32;
+        if ( type->is<double>() )      return _record.value.d;
+        if ( type->is<null>() )        return {};
+        throw std::runtime_error(std::string("Unable to load a constant of type ") + type->name());
+    }
+
+    void check_register(Register _register, bool _allow_undefined = false)
+    {
+        if ( _register >= Register_COUNT && !(_allow_undefined && _register == Register_undefined) )
+        {
+            throw std::runtime_error("A register is invalid");
+        }
+    }
+
+    void check_slot(u32_t _index, size_t _depth)
+    {
+        if ( _index >= _depth )
+        {
+            throw std::runtime_error("A slot is out of the stack");
+        }
+    }
+
+    // Stack state before an instruction runs (cf. check_stack())
+    struct StackState
+    {
+        size_t              depth = 0; // slot count
+        std::vector<size_t> frames;    // depth when each frame was pushed
+        bool operator==(const StackState&) const = default;
+    };
+
+    // Get the slot count a (relocated) instruction pops from the stack top, and the slot count it pushes in their place
+    std::pair<size_t, size_t> get_stack_effect(const Code& _code, const Instruction& _instr)
+    {
+        switch ( _instr.opcode )
+        {
+            case OpCode_push_const:
+            case OpCode_load:
+            case OpCode_load_ref:
+            case OpCode_load_reg:
+            case OpCode_load_input:
+                return { 0, 1 };
+            case OpCode_store:
+            case OpCode_store_reg:
+            case OpCode_pop:
+            case OpCode_pop_jne:
+                return { 1, 0 };
+            case OpCode_call:
+            {
+                const FunctionDescriptor* sig = _instr.call.invokable->get_sig();
+                return { sig->arg_count(), sig->return_type()->is<void>() ? 0 : 1 };
+            }
+            case OpCode_call_native:
+            {
+                const NativeCall& native = _instr.call.invokable->get_native();
+                return { native.arg_count, native.has_result ? 1 : 0 };
+            }
+            case OpCode_dataflow:
+                return { _code.get_dataflows()[_instr.dataflow.index].get_input_count(), 1 };
+            case OpCode_neg_i32:
+            case OpCode_neg_f64:
+            case OpCode_not_bool:
+                return { 1, 1 };
+            default:
+                if ( _instr.is_operator() )
+                    return { 2, 1 };
+                return { 0, 0 };
+        }
+    }
+
+    /**
+     * Simulate the stack over each path of a (relocated) instruction array, the Stack only asserts its bounds:
+     * - a frame is never pushed past the stack size, nor popped when none is pushed,
+     * - a value is never pushed past the stack size, nor popped below the current frame,
+     * - a slot is only accessed once reserved,
+     * - each path reaching an instruction has the same stack state (ex: a loop leaves its frames balanced).
+     */
+    void check_stack(const Code& _code, std::span<const Instruction> _instructions, size_t _stack_size)
+    {
+        std::vector<std::unique_ptr<StackState>> state_at(_instructions.size());
+        std::vector<size_t>                      pending{ 0 };
+        state_at[0] = std::make_unique<StackState>();
+
+        auto reach = [&](i64_t _index, const StackState& _state)
+        {
+            if ( _index >= (i64_t)_instructions.size() )
+                throw std::runtime_error("An instruction runs past the code");
+            std::unique_ptr<StackState>& known = state_at[_index];
+            if ( known == nullptr )
+            {
+                known = std::make_unique<StackState>(_state);
+                pending.push_back(_index);
+            }
+            else if ( *known != _state )
+            {
+                throw std::runtime_error("The stack is unbalanced where two paths meet");
+            }
+        };
+
+        while ( !pending.empty() )
+        {
+            const size_t       i     = pending.back();
+            const Instruction& instr = _instructions[i];
+            StackState         state = *state_at[i];
+            pending.pop_back();
+
+            switch ( instr.opcode )
+            {
+                case OpCode_push_stack_frame:
+                    if ( instr.push.size > _stack_size - state.depth )
+                        throw std::runtime_error("A stack frame overflows the stack");
+                    state.frames.push_back(state.depth);
+                    state.depth += instr.push.size;
+                    break;
+                case OpCode_pop_stack_frame:
+                    if ( state.frames.empty() )
+                        throw std::runtime_error("A stack frame is popped but was never pushed");
+                    state.depth = state.frames.back();
+                    state.frames.pop_back();
+                    break;
+                case OpCode_push_var:
+                    check_slot(instr.push.index, state.depth);
+                    break;
+                case OpCode_load:
+                case OpCode_load_ref:
+                case OpCode_store:
+                    check_slot(instr.slot.index, state.depth);
+                    break;
+                default:
+                    break;
+            }
+
+            const auto [popped, pushed] = get_stack_effect(_code, instr);
+            const size_t frame_base = state.frames.empty() ? 0 : state.frames.back();
+            if ( popped > state.depth - frame_base )
+                throw std::runtime_error("A value is popped but was never pushed");
+            state.depth -= popped;
+            if ( pushed > _stack_size - state.depth )
+                throw std::runtime_error("A value overflows the stack");
+            state.depth += pushed;
+
+            switch ( instr.opcode )
+            {
+                case OpCode_ret:
+                    break;
+                case OpCode_jmp:
+                    reach((i64_t)i + instr.get_jump_offset(), state);
+                    break;
+                case OpCode_jne:
+                case OpCode_pop_jne:
+                    reach((i64_t)i + instr.get_jump_offset(), state);
+                    reach((i64_t)i + 1, state);
+                    break;
+                default:
+                    reach((i64_t)i + 1, state);
+            }
+        }
+    }
+
+    // Rebuild the dataflows (the tasks are checked as Dataflow::push_task() would)
+    void load_dataflows(const Reader& _reader, Code& _code, const std::vector<const TypeDescriptor*>& _types, const std::vector<const IInvokable*>& _functions)
+    {
+        const Header& header = _reader.header();
+        const auto    constants = _reader.section<const ConstantRecord>(header.dataflow_constants);
+        const auto    tasks     = _reader.section<const TaskRecord>(header.tasks);
+        const auto    operands  = _reader.section<const OperandRecord>(header.operands);
+
+        for ( const DataflowRecord& record : _reader.section<const DataflowRecord>(header.dataflows) )
+        {
+            if ( record.first_constant > constants.size() || record.constant_count > constants.size() - record.first_constant
+                 || record.first_task > tasks.size() || record.task_count > tasks.size() - record.first_task || record.task_count == 0 )
+            {
+                throw std::runtime_error("A dataflow is out of the file bounds");
+            }
+
+            Dataflow dataflow;
+            for ( u32_t i = 0; i < record.input_count; ++i )
+            {
+                dataflow.push_input();
+            }
+            for ( const ConstantRecord& constant : constants.subspan(record.first_constant, record.constant_count) )
+            {
+                dataflow.push_constant( to_variant(_reader, constant, _types) );
+            }
+
+            std::vector<bool> is_used(record.task_count, false);
+            for ( u32_t index = 0; index < record.task_count; ++index )
+            {
+                const TaskRecord& task = tasks[record.first_task + index];
+                if ( task.first_operand > operands.size() || task.operand_count > operands.size() - task.first_operand )
+                {
+                    throw std::runtime_error("A task is out of the file bounds");
+                }
+                std::vector<Dataflow::Operand> args;
+                for ( const OperandRecord& operand : operands.subspan(task.first_operand, task.operand_count) )
+                {
+                    const bool is_valid = ( operand.type == Dataflow::OperandType_INPUT    && operand.index < record.input_count )
+                                       || ( operand.type == Dataflow::OperandType_CONSTANT && operand.index < record.constant_count )
+                                       || ( operand.type == Dataflow::OperandType_TASK     && operand.index < index && !is_used[operand.index] );
+                    if ( !is_valid )
+                    {
+                        throw std::runtime_error("An operand is invalid");
+                    }
+                    if ( operand.type == Dataflow::OperandType_TASK )
+                    {
+                        is_used[operand.index] = true;
+                    }
+                    args.push_back({ (Dataflow::OperandType)operand.type, operand.index });
+                }
+                dataflow.push_task( at(_functions, task.function, "function"), std::move(args), task.is_expensive != 0 );
+            }
+            if ( std::find(is_used.begin(), is_used.end() - 1, false) != is_used.end() - 1 )
+            {
+                throw std::runtime_error("A task is not used, only the last one can be the root");
+            }
+            _code.push_dataflow( std::move(dataflow) );
+        }
+    }
+} // namespace
+
+bool Bytecode::save(const Code* _code, const std::string& _path)
+{
+    ASSERT(_code != nullptr);
+    std::string buffer;
+    try
+    {
+        buffer = serialize(_code);
+    }
+    catch ( const std::exception& error )
+    {
+        LOG_ERROR("Bytecode", "Unable to save %s: %s\n", _path.c_str(), error.what());
+        return false;
+    }
+
+    std::ofstream file(_path, std::ios::binary);
+    file.write(buffer.data(), (std::streamsize)buffer.size());
+    if ( !file )
+    {
+        LOG_ERROR("Bytecode", "Unable to write %s\n", _path.c_str());
+        return false;
+    }
+    return true;
+}
+
+Code* Bytecode::load(const std::string& _path)
+{
+    try
+    {
+        size_t                size    = 0;
+        std::shared_ptr<void> storage = map_file(_path, size);
+        const Reader          reader((char*)storage.get(), size);
+        const Header&         header  = reader.header();
+
+        if ( memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.file_size != size )
+        {
+            throw std::runtime_error("File is not a bytecode file");
+        }
+        if ( header.version != VERSION || header.instruction_size != sizeof(Instruction) || header.opcode_count != OpCode_COUNT )
+        {
+            throw std::runtime_error("File version is " + std::to_string(header.version) + ", expecting " + std::to_string(VERSION) + " (it must be compiled again)");
+        }
+
+        // tables
+        std::vector<const TypeDescriptor*> types;
+        for ( const TypeRecord& each : reader.section<const TypeRecord>(header.types) )
+        {
+            types.push_back( find_type(reader.string(each.name)) );
+        }
+        std::vector<const IInvokable*> functions;
+        for ( const FunctionRecord& each : reader.section<const FunctionRecord>(header.functions) )
+        {
+            functions.push_back( find_function(reader, each) );
+        }
+
+        const bool            has_debug_info = header.flags & FileFlag_DEBUG_INFO;
+        std::unique_ptr<Code> code           = std::make_unique<Code>(nullptr, has_debug_info);
+        code->set_stack_size(header.stack_size);
+
+        for ( const ConstantRecord& each : reader.section<const ConstantRecord>(header.constants) )
+        {
+            code->push_constant( to_variant(reader, each, types) );
+        }
+        std::vector<std::string> inputs;
+        for ( const StringRef& each : reader.section<const StringRef>(header.inputs) )
+        {
+            inputs.emplace_back( reader.string(each) );
+        }
+        code->set_inputs(inputs);
+        load_dataflows(reader, *code, types, functions);
+
+        // instructions are run in place, their indexes are checked and relocated to pointers, then their stack use is checked
+        const std::span<Instruction> instructions = reader.section<Instruction>(header.instructions, ALIGNMENT);
+        if ( instructions.empty() )
+        {
+            throw std::runtime_error("Code is empty");
+        }
+        auto get_type = [&](const TypeDescriptor* _field) -> const TypeDescriptor*
+        {
+            return get_index(_field) == NO_INDEX ? nullptr : at(types, get_index(_field), "type");
+        };
+        for ( size_t i = 0; i < instructions.size(); ++i )
+        {
+            Instruction& instr = instructions[i];
+            switch ( instr.opcode )
+            {
+                case OpCode_jmp:
+                case OpCode_jne:
+                case OpCode_pop_jne:
+                {
+                    const i64_t offset = instr.get_jump_offset();
+                    if ( offset < -(i64_t)i || offset >= (i64_t)(instructions.size() - i) )
+                        throw std::runtime_error("A jump is out of the code");
+                    break;
+                }
+                case OpCode_mov:
+                    check_register(instr.mov.dst);
+                    break;
+                case OpCode_cmp:
+                    check_register(instr.cmp.left);
+                    check_register(instr.cmp.right);
+                    break;
+                case OpCode_pop:
+                    check_register(instr.pop_reg.dst);
+                    break;
+                case OpCode_push_stack_frame:
+                case OpCode_pop_stack_frame:
+                    break; // cf. check_stack()
+                case OpCode_push_var:
+                    check_register(instr.push.reg, true);
+                    instr.push.type = get_type(instr.push.type);
+                    break;
+                case OpCode_load:
+                case OpCode_load_ref:
+                case OpCode_store:
+                    instr.slot.type = get_type(instr.slot.type);
+                    break;
+                case OpCode_load_reg:
+                case OpCode_store_reg:
+                    check_register(instr.reg.reg);
+                    instr.reg.type = get_type(instr.reg.type);
+                    break;
+                case OpCode_push_const:
+                    if ( instr.constant.index >= code->get_constants().size() )
+                        throw std::runtime_error("An index is out of the constant pool");
+                    break;
+                case OpCode_call:
+                case OpCode_call_native:
+                    instr.call.invokable = at(functions, get_index(instr.call.invokable), "function");
+                    if ( instr.opcode == OpCode_call_native && !instr.call.invokable->get_native().valid() )
+                        throw std::runtime_error("A function has no native call");
+                    break;
+                case OpCode_dataflow:
+                    if ( instr.dataflow.index >= code->get_dataflows().size() )
+                        throw std::runtime_error("An index is out of the dataflows");
+                    break;
+                case OpCode_load_input:
+                    if ( instr.input.index >= inputs.size() )
+                        throw std::runtime_error("An index is out of the inputs");
+                    break;
+                case OpCode_ret:
+                    break;
+                default:
+                    if ( !instr.is_operator() )
+                        throw std::runtime_error("An instruction is not supported (opcode " + std::to_string(instr.opcode) + ")");
+            }
+        }
+        check_stack(*code, instructions, header.stack_size);
+
+        if ( has_debug_info )
+        {
+            const auto comments = reader.section<const StringRef>(header.debug_info);
+            if ( comments.size() != instructions.size() )
+            {
+                throw std::runtime_error("Debug table has not an entry per instruction");
+            }
+            for ( const StringRef& each : comments )
+            {
+                code->m_debug_info.push_back({ std::string(reader.string(each)), nullptr });
+            }
+        }
+
+        code->m_view    = instructions;
+        code->m_storage = std::move(storage);
+        return code.release();
+    }
+    catch ( const std::exception& error )
+    {
+        LOG_ERROR("Bytecode", "Unable to load %s: %s\n", _path.c_str(), error.what());
+        return nullptr;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include "tools/core/types.h"
+
+// A bytecode file is memory mapped on POSIX systems, it is read to the heap otherwise.
+#if defined(__unix__) || defined(__APPLE__)
+#   define NDBL_BYTECODE_MMAP 1
+#else
+#   define NDBL_BYTECODE_MMAP 0
+#endif
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+
+    /**
+     * @class Versioned on-disk format of a Code.
+     * A file is a header followed by sections: the instruction array (stored as is, cache line aligned), a string pool,
+     * the type and function tables, the constant pool, the input identifiers, the dataflows, and an optional debug table
+     * (the comment of each instruction, cf. Code::DebugInfo).
+     * The pointers of the instructions are stored as indexes in the type/function tables and relocated when loading:
+     * types are resolved by their compiler name, functions by the hash of their signature (cf. Nodlang::find_function()).
+     * A loaded Code runs its instructions in place, from the file mapping (there is no allocation per instruction).
+     * The mapping is private: relocating writes nearly every instruction, so the whole instruction array is copied on write
+     * (loading costs a copy of the array, but no parsing, and the pages holding the other sections stay shared with the file).
+     * Since the Stack only asserts its bounds, loading simulates the stack over each path and rejects a code overflowing it or unbalancing its frames.
+     * The version is incremented each time the format or the instruction set changes, a file of another version is rejected.
+     */
+    class Bytecode
+    {
+    public:
+        static constexpr u32_t VERSION = 2;
+
+        static bool  save(const Code*, const std::string& _path); // Save a given code to a file, returns false when it can't be (an error is logged).
+        static Code* load(const std::string& _path);             // Load a code from a file (caller owns it), returns nullptr when it can't be (an error is logged).
+    };
+} // namespace ndbl
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "fixtures/core.h"
+#include "ndbl/core/Bytecode.h"
+
+using namespace ndbl;
+using namespace tools;
+typedef ::testing::Core Bytecode_;
+
+// Save a given code to a file, and load it back
+static Code* save_and_load(const Code* _code)
+{
+    const std::string path = testing::Core::get_temp_path(".ndbc");
+    EXPECT_TRUE(Bytecode::save(_code, path));
+    Code* loaded = Bytecode::load(path);
+    std::filesystem::remove(path); // the mapping is still valid
+    return loaded;
+}
+
+// Get a file's bytes
+static std::string read_file(const std::string& _path)
+{
+    std::ifstream file(_path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+// Run a given code, and return its last result
+static qword run(NodableHeadless& _app, const Code* _code)
+{
+    EXPECT_TRUE(_app.load_program(_code));
+    EXPECT_TRUE(_app.run_program());
+    const qword result = _app.get_last_result();
+    _app.release_program();
+    return result;
+}
+
+TEST_F(Bytecode_, runs_the_programs_as_the_compiled_code_does)
+{
+    std::vector<std::string> programs = PROGRAMS;
+    for ( const char* example : { "arithmetic.cpp", "for-loop.cpp", "multi-instructions.cpp" } ) // if-else.cpp's result is a string (cf. keeps_the_string_constants)
+        programs.push_back( load_example(example) );
+
+    for ( CompilerFlags flags : { CompilerFlags(CompilerFlag_NONE), CompilerFlag_DEBUG_INFO | CompilerFlag_PARALLEL } )
+    {
+        for ( const std::string& program : programs )
+        {
+            const Code* code   = app.compile(app.parse(program), flags);
+            Code*       loaded = save_and_load(code);
+            ASSERT_NE(loaded, nullptr) << program;
+
+            EXPECT_EQ(run(app, loaded).u64, run(app, code).u64) << program;
+            delete loaded;
+            delete code;
+        }
+    }
+}
+
+TEST_F(Bytecode_, saves_a_loaded_code_as_the_compiled_one)
+{
+    std::vector<std::string> programs = PROGRAMS;
+    programs.push_back( load_example("if-else.cpp") );
+
+    for ( const std::string& program : programs )
+    {
+        const Code*       code   = app.compile(app.parse(program), CompilerFlag_DEBUG_INFO | CompilerFlag_PARALLEL);
+        const std::string path   = get_temp_path(".ndbc");
+        ASSERT_TRUE(Bytecode::save(code, path));
+        Code*             loaded = Bytecode::load(path);
+        ASSERT_NE(loaded, nullptr) << program;
+
+        // each pointer was relocated to the same type/function
+        const std::string other_path = get_temp_path(".ndbc");
+        ASSERT_TRUE(Bytecode::save(loaded, other_path));
+        EXPECT_EQ(read_file(other_path), read_file(path)) << program;
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(other_path);
+        delete loaded;
+        delete code;
+    }
+}
+
+TEST_F(Bytecode_, runs_the_instructions_from_the_file_mapping)
+{
+    const Code* code   = app.compile(app.parse(PROGRAMS[1]), CompilerFlag_DEBUG_INFO);
+    Code*       loaded = save_and_load(code);
+    ASSERT_NE(loaded, nullptr);
+
+    EXPECT_FALSE(code->is_mapped());
+    EXPECT_TRUE(loaded->is_mapped());
+    EXPECT_EQ((uintptr_t)loaded->data() % 64, 0); // cache line aligned
+    EXPECT_EQ(loaded->get_meta_data().stack_size, code->get_meta_data().stack_size);
+    ASSERT_EQ(loaded->size(), code->size());
+    for ( size_t i = 0; i < code->size(); ++i )
+    {
+        EXPECT_EQ(loaded->get_instruction_at(i)->opcode, code->get_instruction_at(i)->opcode);
+        EXPECT_EQ(loaded->get_debug_info(i)->comment, code->get_debug_info(i)->comment);
+        EXPECT_EQ(loaded->get_debug_info(i)->node, nullptr); // the graph is not saved
+    }
+    delete loaded;
+    delete code;
+}
+
+TEST_F(Bytecode_, refuses_to_debug_a_loaded_code)
+{
+    const Code* code   = app.compile(app.parse(PROGRAMS[1]), CompilerFlag_DEBUG_INFO);
+    Code*       loaded = save_and_load(code);
+    ASSERT_NE(loaded, nullptr);
+
+    // the graph is not saved, there is no node to step through
+    ASSERT_TRUE(app.load_program(loaded));
+    app.get_interpreter()->debug_program();
+    EXPECT_FALSE(app.get_interpreter()->is_debugging());
+    EXPECT_TRUE(app.run_program());
+    app.release_program();
+    delete loaded;
+    delete code;
+}
+
+TEST_F(Bytecode_, keeps_the_string_constants)
+{
+    const Code* code   = app.compile(app.parse("string s = \"a\"; for(int i = 0; i < 3; i = i + 1) { s = s + \"b\"; } return(s);"));
+    Code*       loaded = save_and_load(code);
+    ASSERT_NE(loaded, nullptr);
+
+    ASSERT_TRUE(app.load_program(loaded));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<std::string>(), "abbb");
+    app.release_program();
+    delete loaded;
+    delete code;
+}
+
+TEST_F(Bytecode_, rejects_invalid_files)
+{
+    const Code*       code = app.compile(app.parse(PROGRAMS[1]));
+    const std::string path = get_temp_path(".ndbc");
+    ASSERT_TRUE(Bytecode::save(code, path));
+    delete code;
+
+    const std::string bytes = read_file(path);
+    auto load = [&](const std::string& _bytes) -> Code*
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(_bytes.data(), (std::streamsize)_bytes.size());
+        return Bytecode::load(path);
+    };
+
+    std::string other_version = bytes;
+    other_version[4]++; // version is the second u32
+    EXPECT_EQ(load(other_version), nullptr);
+
+    std::string other_magic = bytes;
+    other_magic[0] = 'X';
+    EXPECT_EQ(load(other_magic), nullptr);
+
+    EXPECT_EQ(load(bytes.substr(0, bytes.size() - 1)), nullptr);
+    EXPECT_EQ(load(bytes.substr(0, 8)), nullptr);
+
+    std::string corrupted = bytes;
+    for ( size_t i = 216; i < corrupted.size(); ++i ) // after the header, any index or offset becomes invalid
+        corrupted[i] = (char)0xff;
+    EXPECT_EQ(load(corrupted), nullptr);
+
+    Code* loaded = load(bytes);
+    EXPECT_NE(loaded, nullptr);
+    delete loaded;
+
+    std::filesystem::remove(path);
+    EXPECT_EQ(Bytecode::load(path), nullptr);
+}
+
+TEST_F(Bytecode_, rejects_a_code_misusing_the_stack)
+{
+    // Build a code: push a frame of a given slot count, push a given constant count, pop a given frame count, and return
+    auto make_code = [](u32_t _frame_size, size_t _constant_count, size_t _frame_pop_count) -> Code*
+    {
+        Code* code = new Code(nullptr);
+        code->set_stack_size(2);
+        code->push_constant( variant(1.0) );
+        code->push_instr(OpCode_push_stack_frame)->push.size = _frame_size;
+        for ( size_t i = 0; i < _constant_count; ++i )
+            code->push_instr(OpCode_push_const)->constant.index = 0;
+        for ( size_t i = 0; i < _frame_pop_count; ++i )
+            code->push_instr(OpCode_pop_stack_frame);
+        code->push_instr(OpCode_ret);
+        return code;
+    };
+
+    struct Case { u32_t frame_size; size_t constant_count; size_t frame_pop_count; bool is_valid; };
+    for ( const Case& each : std::vector<Case>{
+            { 1, 1, 1, true  },
+            { 3, 0, 1, false }, // frame overflows the stack
+            { 1, 2, 1, false }, // value overflows the stack
+            { 0, 0, 2, false }, // frame popped but never pushed
+          } )
+    {
+        Code* code   = make_code(each.frame_size, each.constant_count, each.frame_pop_count);
+        Code* loaded = save_and_load(code);
+        EXPECT_EQ(loaded != nullptr, each.is_valid) << each.frame_size << " " << each.constant_count << " " << each.frame_pop_count;
+        delete loaded;
+        delete code;
+    }
+
+    // a loop jumping back with one more value on the stack
+    Code* code = new Code(nullptr);
+    code->set_stack_size(8);
+    code->push_constant( variant(true) );
+    code->push_instr(OpCode_push_const)->constant.index = 0;
+    code->push_instr(OpCode_push_const)->constant.index = 0;
+    code->push_instr(OpCode_pop_jne)->jmp.offset        = -2;
+    code->push_instr(OpCode_ret);
+    Code* loaded = save_and_load(code);
+    EXPECT_EQ(loaded, nullptr);
+    delete loaded;
+    delete code;
+}
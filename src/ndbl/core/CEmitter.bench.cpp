@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "tools/core/FileSystem.h"
+#include "ndbl/core/AotProgram.h"
+#include "ndbl/core/CEmitter.h"
+#include "ndbl/core/NodableHeadless.h"
+#include "ndbl/core/Interpreter.h"
+
+using namespace ndbl;
+using namespace tools;
+
+// Programs of assets/examples, the benchmark's argument is an index in this array
+static const char* EXAMPLES[] = {
+    "arithmetic.cpp",
+    "for-loop.cpp",
+    "if-else.cpp",
+    "multi-instructions.cpp",
+};
+
+// Fixture running an example interpreted and compiled ahead-of-time
+class CEmitterFixture : public benchmark::Fixture {
+public:
+    NodableHeadless app;
+    const Code*     code{};
+    AotProgram      aot;
+
+    void SetUp(::benchmark::State& state) override
+    {
+        app.init();
+        log::set_verbosity(log::Verbosity_Error);
+
+        const char*   example = EXAMPLES[state.range(0)];
+        Path          path    = Path::get_executable_path().parent_path() / "assets" / "examples" / example;
+        std::ifstream file_stream( path.c_str() );
+        VERIFY(file_stream.is_open(), "Unable to open file!" );
+        const std::string program((std::istreambuf_iterator<char>(file_stream)), std::istreambuf_iterator<char>());
+
+        Graph* graph = app.parse(program);
+        code = app.compile( graph );
+        if ( !app.load_program(code) )
+        {
+            state.SkipWithError("Unable to load program");
+        }
+
+        if ( AotProgram::is_supported() )
+        {
+            const std::string so_path = ( std::filesystem::temp_directory_path() / (std::string("ndbl-bench-") + example + ".so") ).string();
+            aot.build( CEmitter().emit(graph), so_path );
+            std::filesystem::remove(so_path);
+            std::filesystem::remove(so_path + ".cpp");
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state)
+    {
+        aot.release();
+        app.release_program();
+        delete code;
+        app.shutdown();
+    }
+};
+
+BENCHMARK_DEFINE_F(CEmitterFixture, run_example__interpreted)(benchmark::State& state) {
+    state.SetLabel(EXAMPLES[state.range(0)]);
+    Interpreter* interpreter = app.get_interpreter();
+    for (auto _ : state)
+    {
+        interpreter->run_program();
+        benchmark::DoNotOptimize( interpreter->get_last_result() );
+    }
+}
+
+BENCHMARK_DEFINE_F(CEmitterFixture, run_example__aot)(benchmark::State& state) {
+    state.SetLabel(EXAMPLES[state.range(0)]);
+    if ( !aot.is_loaded() )
+    {
+        state.SkipWithError("Unable to build the program ahead-of-time");
+        return;
+    }
+    AotResult result;
+    for (auto _ : state)
+    {
+        aot.run(result);
+        benchmark::DoNotOptimize( result.value );
+    }
+}
+
+BENCHMARK_REGISTER_F(CEmitterFixture, run_example__interpreted)->DenseRange(0, 3);
+BENCHMARK_REGISTER_F(CEmitterFixture, run_example__aot)->DenseRange(0, 3);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,514 @@
+#include "CEmitter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "tools/core/assertions.h"
+#include "tools/core/log.h"
+#include "ndbl/core/ForLoopNode.h"
+#include "ndbl/core/FunctionNode.h"
+#include "ndbl/core/Graph.h"
+#include "ndbl/core/IfNode.h"
+#include "ndbl/core/LiteralNode.h"
+#include "ndbl/core/Scope.h"
+#include "ndbl/core/VariableNode.h"
+#include "ndbl/core/VariableRefNode.h"
+#include "ndbl/core/WhileLoopNode.h"
+#include "ndbl/core/language/Nodlang.h"
+#include "Compiler.h"
+
+using namespace ndbl;
+using namespace tools;
+
+namespace // anonymous, accessible only in that file
+{
+    // Beginning of each emitted source: the result struct (same layout as AotResult), the conversions (as tools::variant::to<T>()),
+    // and the math library, stringified from the implementations Nodlang_math.cpp registers (cf. Nodlang_math.inl).
+    constexpr const char* PRELUDE = R"(// Program compiled ahead-of-time, emitted by ndbl::CEmitter.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+typedef int32_t i32_t;
+
+struct ndbl_result
+{
+    i32_t type;
+    union { bool b; i32_t i32; double d; uint64_t u64; } value;
+    const char* string;
+    const char* error;
+};
+
+namespace
+{
+    std::string _string; // last string result
+    std::string _error;
+
+    // tools::format::number()
+    std::string _number(double d)
+    {
+        std::string str {std::to_string(d)};
+        size_t first_zero_to_remove = str.find_last_not_of('0', str.find_last_of('.')) + 1 + 1;
+        str.erase( std::min( first_zero_to_remove , std::string::npos), std::string::npos);
+        return str;
+    }
+
+    // tools::variant::to<T>()
+    inline bool        _as_bool(i32_t i) { return (bool)i; }
+    inline bool        _as_bool(double d) { return (bool)d; }
+    inline bool        _as_bool(const std::string& s) { return !s.empty(); }
+    inline i32_t       _as_i32(bool b) { return i32_t(b); }
+    inline i32_t       _as_i32(double d) { return i32_t(d); }
+    inline i32_t       _as_i32(const std::string& s) { return std::stoi(s); }
+    inline double      _as_double(bool b) { return double(b); }
+    inline double      _as_double(i32_t i) { return double(i); }
+    inline double      _as_double(const std::string& s) { return std::stod(s); }
+    inline std::string _as_string(bool b) { return b ? "true" : "false"; }
+    inline std::string _as_string(i32_t i) { return std::to_string(i); }
+    inline std::string _as_string(double d) { return _number(d); }
+
+    // last result (cf. Interpreter::get_last_result())
+    inline void _set(ndbl_result& r, bool b) { r.type = 1; r.value.u64 = 0; r.value.b = b; }
+    inline void _set(ndbl_result& r, i32_t i) { r.type = 2; r.value.u64 = 0; r.value.i32 = i; }
+    inline void _set(ndbl_result& r, double d) { r.type = 3; r.value.d = d; }
+    inline void _set(ndbl_result& r, const std::string& s) { r.type = 4; r.value.u64 = 0; _string = s; }
+    inline bool _test(ndbl_result& r, bool b) { _set(r, b); return b; }
+
+    // math library
+)"
+#define NDBL_MATH_LIBRARY(...) #__VA_ARGS__
+#include "ndbl/core/language/Nodlang_math.inl"
+#undef NDBL_MATH_LIBRARY
+R"(
+}
+
+)";
+
+    // Name of the implementation (in PRELUDE) of each function identifier of the math library
+    const char* get_function_name(const char* _identifier)
+    {
+        static const std::pair<const char*, const char*> NAMES[] = {
+            { "+",   "_plus" },        { "plus", "_plus" },
+            { "-",   "_minus" },       { "*",    "_multiply" },     { "/",   "_divide" },
+            { "=",   "_assign" },
+            { "||",  "_or" },          { "or",   "_or" },
+            { "&&",  "_and" },         { "and",  "_and" },
+            { "!",   "_not" },         { "not",  "_not" },
+            { "=>",  "_implies" },     { "implies", "_implies" },
+            { "==",  "_equals" },      { "<=>",  "_equals" },       { "!=",  "_not_equals" },
+            { ">",   "_greater" },     { ">=",   "_greater_or_eq" },
+            { "<",   "_lower" },       { "<=",   "_lower_or_eq" },
+            { "return", "_return" },   { "sin",  "_sin" },          { "cos", "_cos" },
+            { "sqrt", "_sqrt" },       { "pow",  "_pow" },          { "mod", "_mod" },
+            { "to_bool", "_to_bool" }, { "to_string", "_to_string" },
+            { "secondDegreePolynomial", "_secondDegreePolynomial" },
+        };
+        for ( const auto& [identifier, name] : NAMES )
+        {
+            if ( strcmp(identifier, _identifier) == 0 )
+            {
+                return name;
+            }
+        }
+        return nullptr;
+    }
+
+    // Suffix of the conversion to a given type (cf. _as_bool(), _as_i32(), etc.)
+    const char* get_conversion_suffix(const TypeDescriptor* _type)
+    {
+        if ( _type->is<bool>() )        return "bool";
+        if ( _type->is<i32_t>() )       return "i32";
+        if ( _type->is<double>() )      return "double";
+        if ( _type->is<std::string>() ) return "string";
+        return nullptr;
+    }
+}
+
+std::string CEmitter::emit(const Graph* _graph)
+{
+    m_source.clear();
+    m_indent = 0;
+    m_variable_name.clear();
+    m_invokables.clear();
+
+    if ( _graph->is_empty() )
+    {
+        LOG_ERROR("CEmitter", "Unable to emit an empty graph\n");
+        return {};
+    }
+
+    try
+    {
+        m_source.append(PRELUDE);
+        m_source.append("extern \"C\" int ").append(ENTRY_POINT).append("(ndbl_result* _out)\n{\n");
+        m_indent = 1;
+        line("ndbl_result _result = {};");
+        line("int _status = 0;");
+        line("try");
+        emit_scope(_graph->root()->internal_scope());
+        line("catch (const std::exception& e)");
+        line("{");
+        line("    _error = e.what();");
+        line("    _result.error = _error.c_str();");
+        line("    _status = 1;");
+        line("}");
+        line("if ( _result.type == 4 ) _result.string = _string.c_str();");
+        line("*_out = _result;");
+        line("return _status;");
+        m_source.append("}\n");
+    }
+    catch ( const std::exception& error )
+    {
+        LOG_ERROR("CEmitter", "%s\n", error.what());
+        m_source.clear();
+    }
+
+    std::string source;
+    source.swap(m_source);
+    return source;
+}
+
+void CEmitter::line(const std::string& _line)
+{
+    m_source.append(4 * m_indent, ' ').append(_line).push_back('\n');
+}
+
+void CEmitter::emit_scope(const Scope* scope)
+{
+    emit_scope_begin( scope );
+    for ( const Node* each_node : scope->child() )
+    {
+        emit_node( each_node );
+    }
+    emit_scope_end();
+}
+
+void CEmitter::emit_scope_begin(const Scope* scope)
+{
+    line("{");
+    ++m_indent;
+
+    // sorted by identifier, for the source to be the same from an emission to the next
+    std::vector<const VariableNode*> variables(scope->variable().begin(), scope->variable().end());
+    std::sort(variables.begin(), variables.end(), [](const VariableNode* a, const VariableNode* b) { return a->get_identifier() < b->get_identifier(); });
+    for ( const VariableNode* each_variable : variables )
+    {
+        line( std::string(get_type_name(each_variable->get_type())) + " " + get_variable_name(each_variable) + "{};" );
+    }
+}
+
+void CEmitter::emit_scope_end()
+{
+    ASSERT( m_indent > 0 );
+    --m_indent;
+    line("}");
+}
+
+void CEmitter::emit_node(const Node* _node)
+{
+    switch ( _node->type() )
+    {
+        case NodeType_BLOCK_FOR_LOOP:
+            emit_for_loop(static_cast<const ForLoopNode*>(_node));
+            break;
+        case NodeType_BLOCK_WHILE_LOOP:
+            emit_while_loop(static_cast<const WhileLoopNode*>(_node));
+            break;
+        case NodeType_BLOCK_IF:
+            emit_conditional_struct(static_cast<const IfNode*>(_node));
+            break;
+        case NodeType_VARIABLE:
+        {
+            auto variable = static_cast<const VariableNode*>(_node);
+            if ( variable->decl_out()->empty() && !variable->value_in()->empty() ) // otherwise declaration is emitted where it is used
+            {
+                // a store writes the value to rax (cf. OpCode_store)
+                const std::string value = convert( emit_input_slot(variable->value_in()), variable->get_type() );
+                line( "_set(_result, " + get_variable_name(variable) + " = " + value + ");" );
+            }
+            break;
+        }
+        case NodeType_VARIABLE_REF:
+        case NodeType_LITERAL:
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+        {
+            const Expression expression = emit_output_slot( _node->value_out() );
+            if ( expression.type->is<void>() )
+                line( expression.code + ";" );
+            else
+                line( "_set(_result, " + expression.code + ");" );
+            break;
+        }
+        default:
+            break; // nothing to emit (ex: empty instruction)
+    }
+}
+
+void CEmitter::emit_statement_slot(const Slot* slot)
+{
+    if ( slot->empty() )
+    {
+        return;
+    }
+
+    // evaluate the expression, its result (if any) is stored in rax
+    const Expression expression = emit_input_slot( slot );
+    if ( expression.type->is<void>() )
+        line( expression.code + ";" );
+    else
+        line( "_set(_result, " + expression.code + ");" );
+}
+
+void CEmitter::emit_for_loop(const ForLoopNode* for_loop)
+{
+    // variables declared in for's parenthesis are stored in its internal scope
+    const Scope* scope = for_loop->internal_scope();
+    emit_scope_begin( scope );
+    emit_statement_slot( for_loop->initialization_slot() );
+    line( "while ( " + emit_condition(for_loop->condition_in()) + " )" );
+    line( "{" );
+    ++m_indent;
+    emit_scope( scope->partition().at(Branch_TRUE) );
+    emit_statement_slot( for_loop->iteration_slot() );
+    --m_indent;
+    line( "}" );
+    emit_scope_end();
+}
+
+void CEmitter::emit_while_loop(const WhileLoopNode* while_loop)
+{
+    const Scope* scope = while_loop->internal_scope();
+    emit_scope_begin( scope );
+    line( "while ( " + emit_condition(while_loop->condition_in()) + " )" );
+    emit_scope( scope->partition().at(Branch_TRUE) );
+    emit_scope_end();
+}
+
+void CEmitter::emit_conditional_struct(const IfNode* _cond_node)
+{
+    const Scope* scope = _cond_node->internal_scope();
+    emit_scope_begin( scope );
+    line( "if ( " + emit_condition(_cond_node->condition_in()) + " )" );
+    emit_scope( scope->partition().at(Branch_TRUE) );
+
+    // the false branch may contain a single IfNode (ex: "else if(...) {...}"), it is emitted as any other node
+    const Scope* false_scope = scope->partition().at(Branch_FALSE);
+    if ( !false_scope->empty() )
+    {
+        line( "else" );
+        emit_scope( false_scope );
+    }
+    emit_scope_end();
+}
+
+std::string CEmitter::emit_condition(const Slot* _condition_in)
+{
+    // the condition is written to rax (cf. OpCode_pop_jne), an empty one is always true (ex: "for(;;)")
+    if ( Compiler::is_empty_condition(_condition_in) )
+    {
+        return "_test(_result, true)";
+    }
+
+    const Expression condition = emit_input_slot( _condition_in );
+    if ( condition.type == nullptr || !condition.type->is<bool>() )
+    {
+        throw std::runtime_error("A condition must be a boolean: " + condition.code);
+    }
+    return "_test(_result, " + condition.code + ")";
+}
+
+CEmitter::Expression CEmitter::emit_input_slot(const Slot* slot)
+{
+    ASSERT( slot->has_flags(SlotFlag_INPUT) );
+
+    // an empty input has a constant value stored in its property's token
+    if ( slot->empty() )
+    {
+        return emit_constant( Compiler::get_constant_value(slot->property) );
+    }
+    ASSERT( slot->adjacent_count() == 1 );
+    return emit_output_slot( slot->first_adjacent() );
+}
+
+CEmitter::Expression CEmitter::emit_output_slot(const Slot* slot)
+{
+    ASSERT( slot->has_flags(SlotFlag_OUTPUT) );
+    const Node* node = slot->node;
+
+    switch ( node->type() )
+    {
+        case NodeType_VARIABLE:
+        {
+            auto variable = static_cast<const VariableNode*>(node);
+            Expression expression{ get_variable_name(variable), variable->get_type() };
+            if ( slot == variable->decl_out() && !variable->value_in()->empty() )
+            {
+                // ex: "for( int i = 0; ...)", the declaration is an expression (an lvalue, as the variable).
+                const std::string value = convert( emit_input_slot(variable->value_in()), variable->get_type() );
+                expression.code = "(" + expression.code + " = " + value + ")";
+            }
+            get_type_name( expression.type );
+            return expression;
+        }
+
+        case NodeType_VARIABLE_REF:
+        {
+            auto variable = static_cast<const VariableRefNode*>(node)->get_variable();
+            if ( variable == nullptr )
+            {
+                throw std::runtime_error("\"" + node->name() + "\" should reference a variable");
+            }
+            return { get_variable_name(variable), variable->get_type() };
+        }
+
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+            return emit_function_call( static_cast<const FunctionNode*>(node) );
+
+        case NodeType_LITERAL:
+            return emit_constant( Compiler::get_constant_value(node->value()) );
+
+        default:
+            throw std::runtime_error("Unable to emit \"" + node->name() + "\" as an expression");
+    }
+}
+
+CEmitter::Expression CEmitter::emit_function_call(const FunctionNode* _node)
+{
+    const IInvokable* invokable = Compiler::find_invokable( _node, &m_invokables );
+    if ( invokable == nullptr )
+    {
+        std::string signature;
+        get_language()->serialize_func_sig(signature, &_node->get_func_type());
+        throw std::runtime_error("Function is not declared: " + signature);
+    }
+
+    const FunctionDescriptor* sig  = invokable->get_sig();
+    const char*               name = get_function_name( sig->get_identifier() );
+    if ( name == nullptr )
+    {
+        throw std::runtime_error(std::string("Function has no source to emit (only the math library has one): ") + sig->get_identifier());
+    }
+
+    // arguments are converted to the signature's types (cf. Interpreter::exec_call())
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    VERIFY( arg_slots.size() == sig->arg_count(), "Argument count mismatch" );
+    std::string call = std::string(name) + "(";
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        const FuncArg&   arg      = sig->arg_at(i);
+        const Expression argument = emit_input_slot( arg_slots[i] );
+        if ( i != 0 )
+        {
+            call.append(", ");
+        }
+        if ( arg.pass_by_ref )
+        {
+            // ex: "a = 42", only a variable of the exact type can be passed by reference
+            const NodeType type = arg_slots[i]->empty() ? NodeType_DEFAULT : arg_slots[i]->first_adjacent()->node->type();
+            if ( (type != NodeType_VARIABLE && type != NodeType_VARIABLE_REF) || !argument.type->equals(arg.type) )
+            {
+                throw std::runtime_error("Unable to pass by reference: " + argument.code);
+            }
+            call.append( argument.code );
+        }
+        else
+        {
+            call.append( convert(argument, arg.type) );
+        }
+    }
+    call.push_back(')');
+
+    return { call, sig->return_type() };
+}
+
+CEmitter::Expression CEmitter::emit_constant(const variant& _value)
+{
+    char str[64];
+    const TypeDescriptor* type = _value.get_type();
+    if ( type->is<bool>() )
+    {
+        return { _value.to<bool>() ? "true" : "false", type };
+    }
+    if ( type->is<i32_t>() )
+    {
+        snprintf(str, sizeof(str), "i32_t(%d)", _value.to<i32_t>());
+        return { str, type };
+    }
+    if ( type->is<double>() )
+    {
+        snprintf(str, sizeof(str), "double(%.17g)", _value.to<double>()); // 17 significant digits are enough to get the same double back
+        return { str, type };
+    }
+    if ( type->is<std::string>() )
+    {
+        const std::string value = _value.to<std::string>();
+        std::string literal = "std::string(\"";
+        for ( char c : value )
+        {
+            if ( c == '"' || c == '\\' )
+            {
+                literal.push_back('\\');
+                literal.push_back(c);
+            }
+            else if ( c < ' ' || c > '~' )
+            {
+                snprintf(str, sizeof(str), "\\%03o", (unsigned char)c);
+                literal.append(str);
+            }
+            else
+            {
+                literal.push_back(c);
+            }
+        }
+        literal.append("\", ").append(std::to_string(value.size())).append(")");
+        return { literal, type };
+    }
+    throw std::runtime_error(std::string("Unable to emit a constant of this type: ") + type->name());
+}
+
+std::string CEmitter::convert(const Expression& _expression, const TypeDescriptor* _type)
+{
+    if ( _expression.type == nullptr )
+    {
+        throw std::runtime_error("Unable to convert an expression of unknown type: " + _expression.code);
+    }
+    if ( _expression.type->equals(_type) )
+    {
+        return _expression.code;
+    }
+    get_type_name( _expression.type );
+    get_type_name( _type );
+    return std::string("_as_") + get_conversion_suffix(_type) + "(" + _expression.code + ")";
+}
+
+const char* CEmitter::get_type_name(const TypeDescriptor* _type)
+{
+    if ( _type->is<bool>() )        return "bool";
+    if ( _type->is<i32_t>() )       return "i32_t";
+    if ( _type->is<double>() )      return "double";
+    if ( _type->is<std::string>() ) return "std::string";
+    throw std::runtime_error(std::string("Unable to emit a value of this type: ") + _type->name());
+}
+
+const std::string& CEmitter::get_variable_name(const VariableNode* _variable)
+{
+    auto found = m_variable_name.find( _variable );
+    if ( found != m_variable_name.end() )
+    {
+        return found->second;
+    }
+
+    // identifiers are prefixed by a unique index (no clash with a C++ keyword, or with a variable shadowed in a nested scope)
+    std::string name = "v" + std::to_string(m_variable_name.size()) + "_";
+    for ( char c : _variable->get_identifier() )
+    {
+        name.push_back( isalnum((unsigned char)c) ? c : '_' );
+    }
+    return m_variable_name.emplace(_variable, name).first->second;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "tools/core/types.h"
+#include "tools/core/reflection/Type.h"
+#include "tools/core/reflection/variant.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class ForLoopNode;
+    class FunctionNode;
+    class Graph;
+    class IfNode;
+    class Node;
+    class Scope;
+    class Slot;
+    class VariableNode;
+    class WhileLoopNode;
+
+    /**
+     * @class Backend emitting a self-contained C++ translation unit from a syntax tree (Graph), to compile a program ahead-of-time (cf. AotProgram).
+     * Scopes, conditional structures and loops are emitted as their C++ equivalent, variables are native locals, and the
+     * functions of the math library (cf. Nodlang_math) are direct calls to a copy of their implementation emitted with the program.
+     * The functions are resolved as the Compiler does, and their arguments are converted as the Interpreter would (cf. tools::variant::convert()),
+     * so the program computes the same values. Its result is the last statement's value, as Interpreter::get_last_result() (cf. AotResult).
+     * Only the bool, i32, double and string types and the math library are supported.
+     */
+    class CEmitter
+    {
+    public:
+        static constexpr const char* ENTRY_POINT = "ndbl_main"; // Name of the function running the program: extern "C" int ndbl_main(AotResult*)
+
+        CEmitter() = default;
+        std::string emit(const Graph*); // Emit the source of a given graph's program, returns an empty string when it can't be (an error is logged).
+    private:
+        // A C++ expression, and the type of its value
+        struct Expression
+        {
+            std::string                  code;
+            const tools::TypeDescriptor* type = nullptr;
+        };
+
+        void        emit_scope(const Scope*);                          // Emit a scope as a block recursively.
+        void        emit_scope_begin(const Scope*);                    // Open a block and declare the scope's variables (with their type's default value, cf. OpCode_push_var).
+        void        emit_scope_end();                                  // Close the current block.
+        void        emit_node(const Node*);                            // Emit a node as a statement, its value (if any) becomes the last result.
+        void        emit_statement_slot(const Slot*);                  // Emit an input (slot must be an INPUT) as a statement, its value (if any) becomes the last result.
+        void        emit_for_loop(const ForLoopNode*);
+        void        emit_while_loop(const WhileLoopNode*);
+        void        emit_conditional_struct(const IfNode*);
+        std::string emit_condition(const Slot*);                       // Get the C++ condition of an input (slot must be an INPUT, empty is true), the condition becomes the last result.
+        Expression  emit_input_slot(const Slot*);                      // Get the C++ expression of an input (slot must be an INPUT) recursively.
+        Expression  emit_output_slot(const Slot*);                     // Get the C++ expression of an output (slot must be an OUTPUT) recursively.
+        Expression  emit_function_call(const FunctionNode*);           // Get the C++ call of a given function, its arguments are converted to its signature's types.
+        static Expression  emit_constant(const tools::variant&);       // Get the C++ literal of a given value.
+        static std::string convert(const Expression&, const tools::TypeDescriptor*); // Get an expression converted to a given type (unchanged when it already has this type).
+        static const char* get_type_name(const tools::TypeDescriptor*); // Get the C++ name of a given type, throws when not supported.
+        const std::string& get_variable_name(const VariableNode*);     // Get the unique C++ name of a given variable.
+        void        line(const std::string&);                          // Append a given line to the source, indented.
+
+        std::string m_source;
+        size_t      m_indent = 0;
+        std::unordered_map<const VariableNode*, std::string> m_variable_name;
+        std::unordered_map<const FunctionNode*, const tools::IInvokable*> m_invokables; // cf. Compiler::Invokables
+    };
+} // namespace ndbl
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "fixtures/core.h"
+#include "tools/core/format.h"
+#include "ndbl/core/AotProgram.h"
+#include "ndbl/core/CEmitter.h"
+
+using namespace ndbl;
+using namespace tools;
+typedef ::testing::Core CEmitter_;
+
+// Programs whose result is a string, in addition to the ones of the fixture (cf. testing::Core::PROGRAMS)
+static const std::vector<std::string> STRING_PROGRAMS = {
+    "string s = \"a\\\"\"; for(int i = 0; i < 3; i = i + 1) { s = s + \"b\"; } s = s + 1.5; s = s + 2; return(s);",
+    "double d = 7; int i = d / 2; bool b = i; return(to_string(mod(d, 2.5)) + to_string(b) + to_string(i));",
+};
+
+// Last result of a program, as a string (to compare the results of both backends)
+static std::string to_string(const qword& _value, AotType _type)
+{
+    switch ( _type )
+    {
+        case AotType_BOOL:   return _value.b ? "true" : "false";
+        case AotType_I32:    return std::to_string(_value.i32);
+        case AotType_DOUBLE: return format::hexadecimal(_value.u64); // bitwise
+        default:             return {};
+    }
+}
+
+// Build a given program ahead-of-time, returns false when it can't be
+static bool build(NodableHeadless& _app, const std::string& _program, AotProgram& _out)
+{
+    const std::string source = CEmitter().emit( _app.parse(_program) );
+    if ( source.empty() )
+    {
+        return false;
+    }
+    const std::string path  = testing::Core::get_temp_path(".so");
+    const bool        built = _out.build(source, path);
+    EXPECT_TRUE(built) << _out.get_error();
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".cpp");
+    return built;
+}
+
+// Run a given program with the interpreter, and return its last result as a string (of the type of the AOT result)
+static std::string run_interpreted(NodableHeadless& _app, const std::string& _program, AotType _type)
+{
+    const Code* code = _app.compile(_app.parse(_program));
+    EXPECT_TRUE(_app.load_program(code));
+    _app.run_program();
+    const std::string result = _type == AotType_STRING ? _app.get_last_result_as<std::string>()
+                                                       : to_string(_app.get_last_result(), _type);
+    _app.release_program();
+    delete code;
+    return result;
+}
+
+TEST_F(CEmitter_, runs_the_programs_as_the_interpreter_does)
+{
+    if ( !AotProgram::is_supported() )
+        GTEST_SKIP() << "AOT compilation is not supported on this platform";
+
+    std::vector<std::string> programs = PROGRAMS;
+    programs.insert(programs.end(), STRING_PROGRAMS.begin(), STRING_PROGRAMS.end());
+    for ( const char* example : { "arithmetic.cpp", "for-loop.cpp", "if-else.cpp", "multi-instructions.cpp" } )
+        programs.push_back( load_example(example) );
+
+    for ( const std::string& program : programs )
+    {
+        AotProgram aot;
+        ASSERT_TRUE(build(app, program, aot)) << program;
+
+        AotResult result;
+        EXPECT_TRUE(aot.run(result)) << program;
+        ASSERT_NE(result.type, AotType_NONE) << program;
+        const std::string compiled = result.type == AotType_STRING ? result.string : to_string(result.value, (AotType)result.type);
+
+        EXPECT_EQ(compiled, run_interpreted(app, program, (AotType)result.type)) << program;
+    }
+}
+
+TEST_F(CEmitter_, exceptions_stop_the_program)
+{
+    if ( !AotProgram::is_supported() )
+        GTEST_SKIP() << "AOT compilation is not supported on this platform";
+
+    AotProgram aot;
+    ASSERT_TRUE(build(app, "int a = 0; int b = 1; for(int i = 0; i < 3; i = i + 1) { b = b + 2 / a; } return(b);", aot));
+
+    AotResult result;
+    EXPECT_FALSE(aot.run(result));
+    ASSERT_NE(result.error, nullptr);
+    EXPECT_STREQ(result.error, "division by zero !");
+}
+
+TEST_F(CEmitter_, functions_without_source_are_not_emitted)
+{
+    // only the math library is emitted with the program
+    EXPECT_TRUE( CEmitter().emit(app.parse("print(42)")).empty() );
+    EXPECT_FALSE( CEmitter().emit(app.parse("int a = 42; a = a + 1;")).empty() );
+}
+
+TEST_F(CEmitter_, builds_to_a_path_the_shell_would_interpret)
+{
+    if ( !AotProgram::is_supported() )
+        GTEST_SKIP() << "AOT compilation is not supported on this platform";
+
+    // the compiler is not run through a shell, quotes, spaces and substitutions are part of the path
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("ndbl-aot \"$(false)\"; `false` " + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directory(directory);
+    const std::string path = (directory / "program.so").string();
+
+    AotProgram aot;
+    EXPECT_TRUE(aot.build(CEmitter().emit(app.parse("int a = 41; return(a + 1);")), path)) << aot.get_error();
+    AotResult result;
+    EXPECT_TRUE(aot.run(result));
+    EXPECT_EQ(result.value.i32, 42);
+
+    aot.release();
+    std::filesystem::remove_all(directory);
+}
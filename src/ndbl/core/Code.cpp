@@ -1,18 +1,124 @@
 #include "Code.h"
+#include <atomic>
 #include <string>
+#include "tools/core/assertions.h"
 #include "tools/core/format.h"
 
 using namespace ndbl;
 using namespace tools;
 
-Code::~Code()
+static std::atomic<u64_t> next_id{1}; // codes can be created from several threads (ex: concurrent compilations)
+
+Code::Code(const Graph* graph, bool _with_debug_info)
+: m_id(next_id++)
+, m_meta_data({graph, 0, _with_debug_info, {}})
+{}
+
+Instruction* Code::push_instr(OpCode _type, std::string_view _comment)
+{
+    VERIFY(!is_mapped(), "A mapped code can't be modified");
+    m_instructions.emplace_back(_type);
+    m_view = m_instructions;
+    if ( m_meta_data.has_debug_info )
+    {
+        m_debug_info.push_back({std::string(_comment), m_debug_node});
+    }
+    return &m_instructions.back();
+}
+
+u32_t Code::push_constant(const variant& _value)
+{
+    m_constants.push_back(_value);
+    return (u32_t)m_constants.size() - 1;
+}
+
+u32_t Code::push_dataflow(Dataflow&& _dataflow)
+{
+    m_dataflows.push_back(std::move(_dataflow));
+    return (u32_t)m_dataflows.size() - 1;
+}
+
+const Code::DebugInfo* Code::get_debug_info(size_t _index) const
+{
+    if ( !m_meta_data.has_debug_info )
+    {
+        return nullptr;
+    }
+    return &m_debug_info.at(_index);
+}
+
+void Code::erase_instructions(const std::vector<bool>& _erase)
+{
+    VERIFY(!is_mapped(), "A mapped code can't be modified");
+    ASSERT(_erase.size() == m_instructions.size());
+
+    // compute each instruction's index once erased (an erased instruction gets the index of the next one kept)
+    std::vector<size_t> new_index(m_instructions.size() + 1);
+    size_t kept_count = 0;
+    for( size_t i = 0; i < m_instructions.size(); ++i )
+    {
+        new_index[i] = kept_count;
+        if ( !_erase[i] )
+        {
+            ++kept_count;
+        }
+    }
+    new_index[m_instructions.size()] = kept_count;
+
+    Instructions instructions;
+    DebugInfos   debug_info;
+    instructions.reserve(kept_count);
+    debug_info.reserve(m_meta_data.has_debug_info ? kept_count : 0);
+
+    for( size_t i = 0; i < m_instructions.size(); ++i )
+    {
+        if ( _erase[i] )
+        {
+            continue;
+        }
+
+        Instruction instr = m_instructions[i];
+        if ( instr.is_jump() )
+        {
+            i64_t target = (i64_t)i + instr.get_jump_offset();
+            ASSERT(target >= 0 && target <= (i64_t)m_instructions.size());
+            instr.set_jump_offset( (i64_t)new_index[target] - (i64_t)new_index[i] );
+        }
+        instructions.push_back(instr);
+
+        if ( m_meta_data.has_debug_info )
+        {
+            debug_info.push_back( std::move(m_debug_info[i]) );
+        }
+    }
+
+    m_instructions.swap(instructions);
+    m_view = m_instructions;
+    m_debug_info.swap(debug_info);
+}
+
+size_t Code::get_memory_usage() const
 {
-    for( auto each : m_instructions )
+    size_t usage = sizeof(Code)
+                 + m_instructions.capacity() * sizeof(Instruction)
+                 + ( is_mapped() ? m_view.size_bytes() : 0 )
+                 + m_constants.capacity()    * sizeof(variant)
+                 + m_debug_info.capacity()   * sizeof(DebugInfo);
+    for ( const DebugInfo& each : m_debug_info )
     {
-        delete each;
+        usage += each.comment.capacity();
     }
-    m_instructions.clear();
-    m_instructions.resize(0);
+    for ( const Dataflow& each : m_dataflows )
+    {
+        usage += each.get_memory_usage();
+    }
+    return usage;
+}
+
+std::string Code::instruction_to_string(size_t _index) const
+{
+    const DebugInfo* debug_info = get_debug_info(_index);
+    return Instruction::to_string(*get_instruction_at(_index), _index, debug_info ? debug_info->comment.c_str() : nullptr );
 }
 
 std::string Code::to_string(const Code* _code)
@@ -20,13 +126,19 @@ std::string Code::to_string(const Code* _code)
     std::string result;
 
     result.append( format::title("Program begin") );
-    for( Instruction* each_instruction : _code->m_instructions )
+    for( size_t i = 0; i < _code->size(); ++i )
     {
-        result.append(Instruction::to_string(*each_instruction) );
+        result.append( _code->instruction_to_string(i) );
         result.append("\n");
     }
+    for( size_t i = 0; i < _code->m_constants.size(); ++i )
+    {
+        result.append("#" + std::to_string(i) + " : " + _code->m_constants[i].to<std::string>() + "\n");
+    }
+    for( size_t i = 0; i < _code->m_dataflows.size(); ++i )
+    {
+        result.append("dataflow #" + std::to_string(i) + " :\n" + _code->m_dataflows[i].to_string());
+    }
     result.append( format::title("Program end") );
     return result;
 }
-
-
@@ -1,37 +1,90 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <vector>
+#include <string>
+#include <string_view>
+#include "tools/core/assertions.h"
 #include "tools/core/types.h"
+#include "tools/core/reflection/variant.h"
+#include "Dataflow.h"
 #include "Instruction.h"
 
 namespace ndbl
 {
     // forward declarations
     class Graph;
+    class Node;
 
     /**
      * @class Instructions container with some extra meta data
+     * Instructions are stored contiguously (no indirection), debug info (comments) are stored in a side table only
+     * filled when the Code is created with debug info enabled (cf. CompilerFlag_DEBUG_INFO).
+     * A Code loaded from a file runs its instructions in place, from the file's private memory mapping (cf. Bytecode::load(), the relocated pages are copied on write).
      */
     class Code
     {
-        typedef std::vector<Instruction*> Instructions; // TODO: switch to a std::vector<Instruction> to iterate faster on this data.
+    public:
+        // Debug info attached to a single instruction (not required to run the code)
+        struct DebugInfo
+        {
+            std::string comment;        // optional comment.
+            const Node* node = nullptr; // node this instruction was compiled from (cf. set_debug_node()), nullptr when unknown.
+        };
+    private:
+        typedef std::vector<Instruction>    Instructions;
+        typedef std::vector<DebugInfo>      DebugInfos;
+        typedef std::vector<tools::variant> Constants;
+        typedef std::vector<Dataflow>       Dataflows;
         struct MetaData
         {
             const Graph* graph;
+            size_t       stack_size     = 0;     // Maximum stack slot count required to run this code.
+            bool         has_debug_info = false; // When true, each instruction has its DebugInfo (cf. get_debug_info()).
+            std::vector<std::string> inputs;     // Identifiers of the variables initialized from a batch's columns, in column order (cf. OpCode_load_input).
         };
     public:
-        Code(const Graph* _root);
-        ~Code();
+        Code(const Graph* _root, bool _with_debug_info = false);
+        Code(const Code&) = delete;
+        Code& operator=(const Code&) = delete;
+        ~Code() = default;
 
-        Instruction*               push_instr(OpCode);                                                            // Push back a new instruction to the code
-        inline size_t              size() const { return  m_instructions.size(); }                                // Get instruction count.
-        inline Instruction*        get_instruction_at(size_t _index) const { return  m_instructions.at(_index); } // Get the instruction at a given zero-based index (be careful, a push_instr() call might invalidate this ptr).
-        size_t                     get_next_index() const { return m_instructions.size(); }                       // Get the next index available.
-        const Instructions&        get_instructions()const { return m_instructions; }                             // Get the instructions.
+        Instruction*               push_instr(OpCode, std::string_view _comment = {});                            // Push back a new instruction to the code (be careful, ptr is invalidated by the next push_instr() call)
+        void                       set_debug_node(const Node* _node) { m_debug_node = _node; }                    // Set the node the next instructions pushed are compiled from (stored in their DebugInfo).
+        const Node*                get_debug_node() const { return m_debug_node; }
+        u32_t                      push_constant(const tools::variant&);                                          // Push back a new constant to the pool, returns its index.
+        const tools::variant&      get_constant(u32_t _index) const { return m_constants[_index]; }               // Get a constant from the pool.
+        const Constants&           get_constants() const { return m_constants; }                                  // Get the constant pool.
+        u32_t                      push_dataflow(Dataflow&&);                                                     // Push back a new dataflow (cf. OpCode_dataflow), returns its index.
+        const Dataflow&            get_dataflow(u32_t _index) const { return m_dataflows[_index]; }               // Get a dataflow.
+        const Dataflows&           get_dataflows() const { return m_dataflows; }                                  // Get all the dataflows.
+        void                       set_stack_size(size_t _size) { m_meta_data.stack_size = _size; }               // Set the maximum stack slot count (computed by the Compiler).
+        void                       set_inputs(const std::vector<std::string>& _inputs) { m_meta_data.inputs = _inputs; } // Set the input variables' identifiers (cf. Compiler::compile_batch()).
+        inline size_t              size() const { return  m_view.size(); }                                        // Get instruction count.
+        inline const Instruction*  get_instruction_at(size_t _index) const { ASSERT(_index < m_view.size()); return &m_view[_index]; } // Get the instruction at a given zero-based index (be careful, a push_instr() call might invalidate this ptr).
+        inline Instruction*        get_instruction_at(size_t _index) { ASSERT(_index < m_view.size()); return &m_view[_index]; }       // Get the instruction at a given zero-based index (be careful, a push_instr() call might invalidate this ptr).
+        inline const Instruction*  data() const { return m_view.data(); }                                         // Get a ptr to the first instruction (instructions are contiguous).
+        size_t                     get_next_index() const { return m_view.size(); }                               // Get the next index available.
+        std::span<const Instruction> get_instructions()const { return m_view; }                                   // Get the instructions.
+        bool                       is_mapped() const { return m_storage != nullptr; }                             // Check if the instructions are run from a file mapping (such a code can't be modified, cf. Bytecode::load()).
+        const DebugInfo*           get_debug_info(size_t _index) const;                                           // Get the debug info of a given instruction, nullptr when code has no debug info.
+        void                       erase_instructions(const std::vector<bool>& _erase);                           // Erase each instruction flagged in a given mask (same size as the code), jump offsets are updated (a jump to an erased instruction lands on the next one kept).
         const MetaData&            get_meta_data()const { return m_meta_data; }                                   // Get the code metadata (cf. MetaData).
+        u64_t                      get_id() const { return m_id; }                                                // Get an id unique in the process (unlike the address, a deleted code's might be reused).
+        size_t                     get_memory_usage() const;                                                      // Get an estimation of the memory used by this code (in bytes).
+        std::string                instruction_to_string(size_t _index) const;                                    // Convert a given instruction to a string (with its comment, if any).
         static std::string         to_string(const Code*);                                                        // Convert all the instructions to a string.
     private:
+        friend class Bytecode;
+        u64_t        m_id;
         MetaData     m_meta_data;
-        Instructions m_instructions;
+        Instructions m_instructions; // Instructions pushed, empty when mapped.
+        std::span<Instruction> m_view;    // Instructions run: m_instructions, or the ones of a file mapping.
+        std::shared_ptr<void>  m_storage; // File mapping the instructions are read from (cf. Bytecode::load()), nullptr when pushed.
+        DebugInfos   m_debug_info;   // Side table, same size as m_instructions when debug info is enabled, empty otherwise.
+        Constants    m_constants;
+        Dataflows    m_dataflows;    // Pure expression trees evaluated in parallel (cf. CompilerFlag_PARALLEL).
+        const Node*  m_debug_node = nullptr; // Node of the next instructions pushed (cf. set_debug_node()).
     };
 } // namespace ndbl
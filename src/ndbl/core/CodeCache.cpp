@@ -0,0 +1,143 @@
+#include "CodeCache.h"
+
+#include <algorithm>
+#include <vector>
+#include "tools/core/Hash.h"
+#include "tools/core/log.h"
+#include "Code.h"
+#include "Graph.h"
+
+using namespace ndbl;
+using namespace tools;
+
+static u64_t hash_scope(u64_t _hash, const Scope* _scope)
+{
+    _hash = Hash::combine(_hash, _scope);
+    if ( _scope == nullptr )
+    {
+        return _hash;
+    }
+    for ( const Node* child : _scope->child() )
+    {
+        _hash = Hash::combine(_hash, child);
+    }
+    for ( const Scope* each : _scope->partition() )
+    {
+        _hash = hash_scope(_hash, each);
+    }
+    return _hash;
+}
+
+CodeCache::CodeCache(size_t _memory_budget)
+: m_memory_budget(_memory_budget)
+{}
+
+CodeCache::~CodeCache()
+{
+    clear();
+}
+
+u64_t CodeCache::hash(const Graph* _graph, CompilerFlags _flags, OptLevel _opt_level)
+{
+    u64_t result = Hash::DEFAULT_SEED;
+    result = Hash::combine(result, _flags);
+    result = Hash::combine(result, _opt_level);
+    result = Hash::combine(result, _graph);
+
+    // Code keeps pointers to nodes and scopes, so their addresses are part of the key, nodes are sorted to get a stable order.
+    std::vector<const Node*> nodes( _graph->nodes().begin(), _graph->nodes().end() );
+    std::sort(nodes.begin(), nodes.end());
+
+    for ( const Node* node : nodes )
+    {
+        result = node->hash(result);
+        result = Hash::combine(result, node->scope());
+        result = hash_scope(result, node->internal_scope());
+    }
+    return result;
+}
+
+const Code* CodeCache::find(u64_t _key, const CodeOrigin& _origin)
+{
+    auto found = m_entry_by_key.find(_key);
+    if ( found == m_entry_by_key.end() || found->second->origin != _origin ) // a different origin is a collision
+    {
+        ++m_miss_count;
+        return nullptr;
+    }
+
+    ++m_hit_count;
+    m_entries.splice(m_entries.begin(), m_entries, found->second); // most recently used first
+    return found->second->code;
+}
+
+const Code* CodeCache::insert(u64_t _key, const Code* _code, const CodeOrigin& _origin)
+{
+    ASSERT(_code != nullptr);
+    auto found = m_entry_by_key.find(_key);
+    if ( found != m_entry_by_key.end() )
+    {
+        VERIFY(found->second->origin != _origin, "A code is already cached for this key");
+        LOG_WARNING("CodeCache", "Key collision (key: %llx), the code cached is replaced.\n", (unsigned long long)_key);
+        erase(found->second);
+    }
+
+    const size_t memory_usage = _code->get_memory_usage();
+    m_entries.push_front({ _key, _origin, _code, memory_usage });
+    m_entry_by_key.emplace(_key, m_entries.begin());
+    m_memory_usage += memory_usage;
+    evict();
+    return _code;
+}
+
+const Code* CodeCache::compile(Compiler& _compiler, const Graph* _graph, CompilerFlags _flags, OptLevel _opt_level)
+{
+    const u64_t      key    = hash(_graph, _flags, _opt_level);
+    const CodeOrigin origin{ _graph, _flags, _opt_level };
+    if ( const Code* code = find(key, origin) )
+    {
+        LOG_MESSAGE("CodeCache", "Code found in cache (key: %llx), compilation skipped.\n", (unsigned long long)key);
+        return code;
+    }
+
+    const Code* code = _compiler.compile_syntax_tree(_graph, _flags, _opt_level);
+    if ( code == nullptr )
+    {
+        return nullptr;
+    }
+    return insert(key, code, origin);
+}
+
+void CodeCache::clear()
+{
+    for ( Entry& each : m_entries )
+    {
+        delete each.code;
+    }
+    m_entries.clear();
+    m_entry_by_key.clear();
+    m_memory_usage = 0;
+}
+
+void CodeCache::set_memory_budget(size_t _budget)
+{
+    m_memory_budget = _budget;
+    evict();
+}
+
+void CodeCache::erase(Entries::iterator _entry)
+{
+    m_memory_usage -= _entry->memory_usage;
+    m_entry_by_key.erase(_entry->key);
+    delete _entry->code;
+    m_entries.erase(_entry);
+}
+
+void CodeCache::evict()
+{
+    while ( m_memory_usage > m_memory_budget && m_entries.size() > 1 )
+    {
+        erase(std::prev(m_entries.end()));
+        ++m_eviction_count;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include "tools/core/types.h"
+#include "Compiler.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+    class Graph;
+
+    // What a cached code is compiled from, compared when a key matches (cf. CodeCache)
+    struct CodeOrigin
+    {
+        const Graph*  graph     = nullptr;
+        CompilerFlags flags     = CompilerFlag_NONE;
+        OptLevel      opt_level = OptLevel_O0;
+        bool operator==(const CodeOrigin&) const = default;
+    };
+
+    /**
+     * @class Cache of the Code compiled from a Graph, to avoid recompiling a graph which did not change.
+     * Entries are keyed by a structural hash of the graph (cf. hash()), the cache owns the codes it stores.
+     * A 64-bit key can collide, so each entry also stores the graph, flags and level it was compiled from (cf. CodeOrigin), a key matching
+     * another origin is a miss.
+     * When the memory budget is exceeded, the least recently used entries are deleted, except the most recent one
+     * (which is likely loaded in the Interpreter).
+     */
+    class CodeCache
+    {
+    public:
+        static constexpr size_t DEFAULT_MEMORY_BUDGET = 16 * 1024 * 1024; // 16 MiB
+
+        explicit CodeCache(size_t _memory_budget = DEFAULT_MEMORY_BUDGET);
+        ~CodeCache();
+        CodeCache(const CodeCache&) = delete;
+        CodeCache& operator=(const CodeCache&) = delete;
+
+        static u64_t     hash(const Graph*, CompilerFlags, OptLevel);                           // Compute the key of a given graph compiled with given flags and level (nodes, slots, properties, scopes and edges are hashed).
+        const Code*      find(u64_t _key, const CodeOrigin& = {});                              // Find the code cached for a given key and origin, nullptr on a miss. Updates the hit/miss counters.
+        const Code*      insert(u64_t _key, const Code*, const CodeOrigin& = {});               // Insert a given code (the cache takes ownership), returns it. Replaces the code of another origin cached for this key. Evicts the least recently used codes to stay in the memory budget.
+        const Code*      compile(Compiler&, const Graph*, CompilerFlags = CompilerFlag_DEFAULT, OptLevel = OptLevel_DEFAULT); // Find the code of a given graph, compile (and insert) it on a miss. The cache owns the returned code.
+        void             clear();                                                               // Delete all the cached codes (counters are kept).
+        size_t           size() const { return m_entries.size(); }                              // Get the cached code count.
+        size_t           get_hit_count() const { return m_hit_count; }                          // Get the number of find() calls returning a code.
+        size_t           get_miss_count() const { return m_miss_count; }                        // Get the number of find() calls returning nullptr.
+        size_t           get_eviction_count() const { return m_eviction_count; }                // Get the number of codes deleted to stay in the memory budget.
+        size_t           get_memory_usage() const { return m_memory_usage; }                    // Get the memory used by the cached codes (in bytes, cf. Code::get_memory_usage()).
+        size_t           get_memory_budget() const { return m_memory_budget; }                  // Get the maximum memory usage (the most recent code is kept, even if it exceeds it).
+        void             set_memory_budget(size_t);                                             // Set the maximum memory usage, evicts codes when necessary.
+
+    private:
+        struct Entry
+        {
+            u64_t       key;
+            CodeOrigin  origin;
+            const Code* code;
+            size_t      memory_usage; // computed once, when inserted
+        };
+        typedef std::list<Entry> Entries;
+
+        void             erase(Entries::iterator);                                              // Delete a given entry and its code.
+        void             evict();                                                               // Delete the least recently used codes until memory budget is respected.
+
+        Entries          m_entries;          // most recently used first
+        std::unordered_map<u64_t, Entries::iterator> m_entry_by_key;
+        size_t           m_memory_budget;
+        size_t           m_memory_usage   = 0;
+        size_t           m_hit_count      = 0;
+        size_t           m_miss_count     = 0;
+        size_t           m_eviction_count = 0;
+    };
+} // namespace ndbl
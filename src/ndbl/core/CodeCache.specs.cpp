@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "fixtures/core.h"
+#include "ndbl/core/CodeCache.h"
+
+using namespace ndbl;
+typedef ::testing::Core CodeCache_;
+
+// Create a code made of a single return
+static Code* make_code()
+{
+    Code* code = new Code(nullptr);
+    code->push_instr(OpCode_ret);
+    return code;
+}
+
+TEST_F(CodeCache_, compile_twice_the_same_graph)
+{
+    app.parse("int a = 5; return(a + 2);");
+    const Code* code = app.compile();
+    EXPECT_EQ(app.compile(), code); // reused, not recompiled
+
+    EXPECT_EQ(app.get_code_cache().get_miss_count(), 1);
+    EXPECT_EQ(app.get_code_cache().get_hit_count(), 1);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 7);
+}
+
+TEST_F(CodeCache_, compile_a_changed_graph)
+{
+    app.parse("int a = 5; return(a + 2);");
+    app.compile();
+    app.parse("int a = 5; return(a + 3);");
+    const Code* code = app.compile();
+
+    EXPECT_EQ(app.get_code_cache().get_miss_count(), 2);
+    EXPECT_EQ(app.get_code_cache().get_hit_count(), 0);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 8);
+}
+
+TEST_F(CodeCache_, compile_releases_the_program_loaded)
+{
+    app.parse("int a = 5; return(a + 2);");
+    ASSERT_TRUE(app.load_program(app.compile()));
+
+    // the code loaded might be evicted by the next insertion
+    app.parse("int a = 5; return(a + 3);");
+    app.compile();
+    EXPECT_EQ(app.get_interpreter()->get_program_asm_code(), nullptr);
+}
+
+TEST_F(CodeCache_, hash_depends_on_compilation_options)
+{
+    Graph* graph = app.parse("int a = 5; return(a + 2);");
+
+    EXPECT_EQ(CodeCache::hash(graph, CompilerFlag_NONE, OptLevel_O1), CodeCache::hash(graph, CompilerFlag_NONE, OptLevel_O1));
+    EXPECT_NE(CodeCache::hash(graph, CompilerFlag_NONE, OptLevel_O0), CodeCache::hash(graph, CompilerFlag_NONE, OptLevel_O1));
+    EXPECT_NE(CodeCache::hash(graph, CompilerFlag_NONE, OptLevel_O1), CodeCache::hash(graph, CompilerFlag_DEBUG_INFO, OptLevel_O1));
+}
+
+TEST_F(CodeCache_, evicts_least_recently_used_code)
+{
+    Code* a = make_code();
+    Code* b = make_code();
+    Code* c = make_code();
+    CodeCache cache(a->get_memory_usage() + b->get_memory_usage());
+
+    cache.insert(1, a);
+    cache.insert(2, b);
+    EXPECT_EQ(cache.find(1), a); // "b" is now the least recently used
+    cache.insert(3, c);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get_eviction_count(), 1);
+    EXPECT_EQ(cache.find(2), nullptr);
+    EXPECT_EQ(cache.find(1), a);
+    EXPECT_EQ(cache.find(3), c);
+    EXPECT_LE(cache.get_memory_usage(), cache.get_memory_budget());
+}
+
+TEST_F(CodeCache_, keeps_most_recent_code_when_over_budget)
+{
+    Code*     code = make_code();
+    CodeCache cache(0);
+    cache.insert(1, code);
+
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.find(1), code);
+}
+
+TEST_F(CodeCache_, a_key_colliding_with_another_origin_is_a_miss)
+{
+    Code*     a = make_code();
+    Code*     b = make_code();
+    CodeCache cache;
+    const CodeOrigin origin_a{ nullptr, CompilerFlag_NONE, OptLevel_O1 };
+    const CodeOrigin origin_b{ nullptr, CompilerFlag_DEBUG_INFO, OptLevel_O1 };
+
+    cache.insert(1, a, origin_a);
+    EXPECT_EQ(cache.find(1, origin_b), nullptr);
+    EXPECT_EQ(cache.find(1, origin_a), a);
+
+    cache.insert(1, b, origin_b); // "a" is replaced
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.find(1, origin_a), nullptr);
+    EXPECT_EQ(cache.find(1, origin_b), b);
+}
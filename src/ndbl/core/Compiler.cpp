@@ -1,6 +1,9 @@
 #include "Compiler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <exception>
+#include <stdexcept>
 #include <iostream>
 
 #include "tools/core/assertions.h"
@@ -16,6 +19,7 @@
 #include "ndbl/core/LiteralNode.h"
 #include "ndbl/core/Scope.h"
 #include "ndbl/core/VariableNode.h"
+#include "ndbl/core/VariableRefNode.h"
 #include "ndbl/core/WhileLoopNode.h"
 
 #include "Instruction.h"
@@ -25,17 +29,6 @@
 using namespace ndbl;
 using namespace tools;
 
-Code::Code(const Graph* graph )
-: m_meta_data({graph})
-{}
-
-Instruction* Code::push_instr(OpCode _type)
-{
-    auto instr = new Instruction(_type, m_instructions.size());
-    m_instructions.emplace_back(instr);
-    return instr;
-}
-
 bool Compiler::is_syntax_tree_valid(const Graph* _graph)
 {
     if( _graph->is_empty())
@@ -56,6 +49,16 @@ bool Compiler::is_syntax_tree_valid(const Graph* _graph)
                 break;
             }
 
+            case NodeType_VARIABLE_REF:
+            {
+                if( static_cast<const VariableRefNode*>(node)->get_variable() == nullptr )
+                {
+                    LOG_ERROR("Compiler", "\"%s\" should reference a variable.\n", node->name().c_str() );
+                    return false;
+                }
+                break;
+            }
+
             case NodeType_OPERATOR:
             {
                 auto* invokable = static_cast<const FunctionNode*>(node);
@@ -84,255 +87,1645 @@ bool Compiler::is_syntax_tree_valid(const Graph* _graph)
     return true;
 }
 
-void Compiler::compile_input_slot( const Slot* slot)
+void Compiler::stack_push(size_t _count)
+{
+    m_stack_size += _count;
+    m_stack_size_max = std::max(m_stack_size_max, m_stack_size);
+}
+
+void Compiler::stack_pop(size_t _count)
+{
+    ASSERT(m_stack_size >= _count);
+    m_stack_size -= _count;
+}
+
+// Set the node the instructions pushed to a given code are compiled from (cf. Code::DebugInfo), the previous one is restored when destroyed.
+struct DebugNodeScope
+{
+    DebugNodeScope(Code* _code, const Node* _node): code(_code), previous(_code->get_debug_node()) { code->set_debug_node(_node); }
+    ~DebugNodeScope() { code->set_debug_node(previous); }
+    Code*       code;
+    const Node* previous;
+};
+
+void Compiler::compile_input_slot( const Slot* slot, bool _by_ref)
 {
+    ASSERT(slot->has_flags(SlotFlag_INPUT) );
+
+    // an empty input has a constant value stored in its property's token
     if( slot->empty() )
     {
+        compile_constant( slot->property );
         return;
     }
     ASSERT( slot->adjacent_count() == 1 );
-    compile_output_slot( slot->first_adjacent() );
+    compile_output_slot( slot->first_adjacent(), _by_ref );
 }
 
-void Compiler::compile_output_slot(const Slot* slot)
+void Compiler::compile_output_slot(const Slot* slot, bool _by_ref)
 {
     ASSERT(slot->has_flags(SlotFlag_OUTPUT) );
-    compile_node(slot->node);
+    const Node* node = slot->node;
+
+    switch ( node->type() )
+    {
+        case NodeType_VARIABLE:
+        {
+            auto variable = static_cast<const VariableNode*>(node);
+            if ( slot == variable->decl_out() )
+            {
+                compile_variable_decl( variable ); // ex: "for( int i = 0; ...)", the declaration is an expression.
+            }
+            compile_variable_access( variable, _by_ref );
+            break;
+        }
+
+        case NodeType_VARIABLE_REF:
+        {
+            auto variable = static_cast<const VariableRefNode*>(node)->get_variable();
+            VERIFY(variable != nullptr, "VariableRefNode should reference a variable");
+            compile_variable_access( variable, _by_ref );
+            break;
+        }
+
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+            VERIFY(!_by_ref, "Unable to pass a function result by reference");
+            compile_function_call( static_cast<const FunctionNode*>(node) );
+            break;
+
+        case NodeType_LITERAL:
+            VERIFY(!_by_ref, "Unable to pass a literal by reference");
+            compile_constant( node->value() );
+            break;
+
+        default:
+            VERIFY(false, "Unable to compile this node as an expression");
+    }
 }
 
-void Compiler::compile_inner_scope(const Node* node, bool _insert_fake_return)
+variant Compiler::get_constant_value(const Property* property)
 {
-    ASSERT( node );
-    ASSERT(node->has_internal_scope() );
+    const Nodlang*    language = get_language();
+    const Token&      token    = property->token();
+    const std::string word     = token.word_to_string();
+    variant           value;
 
-    // call push_stack_frame
+    switch ( token.m_type )
     {
-        Instruction *instr  = m_temp_code->push_instr(OpCode_push_stack_frame);
-        instr->push.scope = node->internal_scope();
-        char str[64];
-        snprintf(str, 64, "%s's internal_scope", node->name().c_str());
-        instr->m_comment = str;
+        case Token_t::literal_bool:   value.set( language->parse_bool_or(word, false) ); break;
+        case Token_t::literal_int:    value.set( (i32_t)language->parse_int_or(word, 0) ); break;
+        case Token_t::literal_double: value.set( language->parse_double_or(word, 0.0) ); break;
+        case Token_t::literal_string: value.set( word.empty() ? word : language->remove_quotes(word) ); break;
+        default:
+        {
+            // no value set, use property's type default
+            const TypeDescriptor* type = property->get_type();
+            if      ( type->is<bool>() )        value.set( false );
+            else if ( type->is<i32_t>() )       value.set( (i32_t)0 );
+            else if ( type->is<i16_t>() )       value.set( (i16_t)0 );
+            else if ( type->is<double>() )      value.set( 0.0 );
+            else if ( type->is<std::string>() ) value.set( "" );
+            else VERIFY(false, "Unable to compile a constant for this type");
+        }
     }
+    return value;
+}
+
+void Compiler::compile_constant(const Property* property)
+{
+    compile_constant( get_constant_value(property), property->token().word_to_string() );
+}
+
+void Compiler::compile_constant(const variant& _value, std::string_view _comment)
+{
+    u32_t        index    = m_temp_code->push_constant( _value );
+    Instruction* instr    = m_temp_code->push_instr(OpCode_push_const, _comment);
+    instr->constant.index = index;
+    stack_push();
+}
+
+bool Compiler::evaluate_input_slot(const Slot* slot, variant& _out) const
+{
+    ASSERT(slot->has_flags(SlotFlag_INPUT) );
 
-    // push each variable
-    for(auto each_variable : node->internal_scope()->variable())
+    if ( slot->empty() )
     {
-        Instruction* instr   = m_temp_code->push_instr(OpCode_push_var);
-        instr->push.var      = each_variable;
-        instr->m_comment     = each_variable->name();
+        _out = get_constant_value( slot->property );
+        return true;
     }
 
-    // compile content
-    for( Node* each_node : node->internal_scope()->child() )
+    const Node* node = slot->first_adjacent()->node;
+    switch ( node->type() )
     {
-        compile_node( each_node );
+        case NodeType_LITERAL:
+            _out = get_constant_value( node->value() );
+            return true;
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+            return evaluate_function_call( static_cast<const FunctionNode*>(node), _out );
+        default:
+            return false; // depends on a variable
     }
+}
 
-    // before to pop, we could insert a return value
-    if( _insert_fake_return )
+bool Compiler::evaluate_function_call(const FunctionNode* _node, variant& _out) const
+{
+    auto found = m_folding.find(_node);
+    if ( found == m_folding.end() )
     {
-        m_temp_code->push_instr(OpCode_ret); // fake a return statement
+        Folding folding;
+        folding.is_folded = fold_function_call(_node, folding.value);
+        found = m_folding.emplace(_node, std::move(folding)).first;
+    }
+    if ( found->second.is_folded )
+    {
+        _out = found->second.value;
+    }
+    return found->second.is_folded;
+}
+
+bool Compiler::fold_function_call(const FunctionNode* _node, variant& _out) const
+{
+    const IInvokable* invokable = find_invokable( _node, &m_invokables );
+    if ( invokable == nullptr || !get_language()->is_pure(invokable) )
+    {
+        return false;
+    }
+
+    // each argument must be known at compile time, it is converted as the Interpreter would do (cf. OpCode_call)
+    const FunctionDescriptor* sig       = invokable->get_sig();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    if ( arg_slots.size() != sig->arg_count() )
+    {
+        return false;
     }
 
-    // pop each variable
-    for(auto each_variable : node->internal_scope()->variable())
+    std::vector<variant>   args(arg_slots.size());
+    std::vector<variant*>  args_ptr(arg_slots.size());
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
     {
-        Instruction *instr   = m_temp_code->push_instr(OpCode_pop_var);
-        instr->push.var      = each_variable;
-        instr->m_comment     = each_variable->name();
+        const FuncArg& arg_type = sig->arg_at(i);
+        if ( !evaluate_input_slot(arg_slots[i], args[i]) )
+        {
+            return false;
+        }
+        args[i].convert(arg_type.type);
+        args_ptr[i] = &args[i];
+    }
+
+    if ( sig->return_type()->is<void>() )
+    {
+        return false; // nothing to fold
     }
 
+    try
+    {
+        _out = invokable->invoke(args_ptr);
+    }
+    catch ( const std::exception& )
     {
-        Instruction *instr = m_temp_code->push_instr(OpCode_pop_stack_frame);
-        instr->pop.scope   = node->internal_scope();
-        instr->m_comment   = node->name() + "'s internal_scope";
+        // let the error happen at runtime (ex: division by zero)
+        return false;
     }
+    return true;
 }
 
-void Compiler::compile_node( const Node* _node )
+void Compiler::compile_function_call(const FunctionNode* _node)
 {
-    ASSERT( _node );
+    DebugNodeScope debug_node(m_temp_code, _node);
+    const IInvokable* invokable = find_invokable( _node, &m_invokables );
+    VERIFY(invokable != nullptr, "Unable to find a function for this signature");
 
-    switch (_node->type())
+    // a pure function having only constant arguments is evaluated once, here, its result is pushed as a constant
+    variant folded;
+    if ( m_opt_level >= OptLevel_O1 && evaluate_function_call(_node, folded) )
     {
-        case NodeType_BLOCK_FOR_LOOP:
-            compile_for_loop(static_cast<const ForLoopNode*>(_node));
-            break;
-        case NodeType_BLOCK_WHILE_LOOP:
-            compile_while_loop(static_cast<const WhileLoopNode*>(_node));
-            break;
-        case NodeType_BLOCK_IF:
-            compile_conditional_struct(static_cast<const IfNode*>(_node));
-            break;
-        default:
+        compile_constant( folded, _node->name() );
+        return;
+    }
+
+    // a loop-invariant expression was computed before its loop, its value is loaded from its slot
+    if ( m_invariant_slot.find(_node) != m_invariant_slot.end() )
+    {
+        Instruction* instr = m_temp_code->push_instr(OpCode_load, _node->name());
+        instr->slot.index  = get_invariant_slot(_node);
+        instr->slot.type   = invokable->get_sig()->return_type();
+        stack_push();
+        return;
+    }
+
+    // an assignment to a variable is compiled to a store (no reference to take, so the variable can be allocated to a register)
+    if ( const VariableNode* variable = get_assigned_variable(_node, invokable) )
+    {
+        compile_input_slot( _node->get_arg_slots()[1] );
+
+        const u32_t slot_index = get_variable_slot(variable);
+        Instruction* instr = m_temp_code->push_instr(OpCode_store, _node->name());
+        instr->slot.index  = slot_index;
+        instr->slot.type   = variable->get_type();
+        stack_pop();
+
+        // the assigned value is the expression's result
+        instr = m_temp_code->push_instr(OpCode_load, variable->get_identifier());
+        instr->slot.index  = slot_index;
+        instr->slot.type   = variable->get_type();
+        stack_push();
+        return;
+    }
+
+    // a pure expression calling independent functions is evaluated as a task graph, these calls can run in parallel
+    if ( (m_flags & CompilerFlag_PARALLEL) && compile_dataflow(_node) )
+    {
+        return;
+    }
+
+    // push each argument on the stack, in order (by reference when required by the signature)
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    VERIFY(arg_slots.size() == invokable->get_sig()->arg_count(), "Argument count mismatch");
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        compile_input_slot( arg_slots[i], invokable->get_sig()->arg_at(i).pass_by_ref );
+    }
+
+    // an operator whose operands types are known is compiled to a typed opcode, then a native call is preferred to the generic call
+    OpCode opcode = get_typed_operator(_node, invokable);
+    if ( opcode == OpCode_call && can_call_native(_node, invokable) )
+    {
+        opcode = OpCode_call_native;
+    }
+    Instruction* instr  = m_temp_code->push_instr(opcode, _node->name());
+    if ( opcode == OpCode_call || opcode == OpCode_call_native )
+    {
+        instr->call.invokable = invokable;
+    }
+
+    // arguments are replaced by the result (if any)
+    stack_pop( _node->get_arg_slots().size() );
+    if ( !invokable->get_sig()->return_type()->is<void>() )
+    {
+        stack_push();
+    }
+}
+
+const IInvokable* Compiler::find_invokable(const FunctionNode* _node, Invokables* _memo)
+{
+    if ( _memo != nullptr )
+    {
+        auto found = _memo->find(_node);
+        if ( found != _memo->end() )
+        {
+            return found->second;
+        }
+    }
+
+    const Nodlang*    language  = get_language();
+    const IInvokable* invokable = nullptr;
+
+    // The parser might not know an argument's type (ex: the result of another operator), but we do.
+    // Try to find the exact implementation for the argument types known here, to avoid a runtime conversion.
+    FunctionDescriptor        sig       = _node->get_func_type();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    if ( sig.arg_count() == arg_slots.size() )
+    {
+        for ( size_t i = 0; i < arg_slots.size(); ++i )
         {
-            // Compile all the outputs connected to each _node inputs.
-            for ( const Slot* slot: _node->filter_slots( SlotFlag_INPUT ) )
+            if ( const TypeDescriptor* type = get_expression_type(arg_slots[i], _memo) )
             {
-                if( slot->adjacent_count() == 0)
-                {
-                    continue;
-                }
-                // Compile adjacent_output ( except if node is a Variable which is compiled once, see compile_variable_node() )
-                Slot* adjacent_output = slot->first_adjacent();
-                if ( !adjacent_output->node->get_class()->is<VariableNode>() )
-                {
-                    // Any other slot must be compiled recursively
-                    compile_output_slot( adjacent_output );
-                }
+                sig.arg_at(i).type = type;
             }
+        }
+        invokable = language->find_function_exact( &sig );
+    }
 
-            // eval node
+    if ( invokable == nullptr )
+    {
+        invokable = language->find_function( &_node->get_func_type() ); // Get exact OR fallback function (in case of arg cast)
+    }
 
-            switch (_node->type())
-            {
-                case NodeType_FUNCTION:
-                case NodeType_OPERATOR:
-                {
-                    Instruction*              instr     = m_temp_code->push_instr(OpCode_call);
-                    const FunctionDescriptor& func_type = static_cast<const FunctionNode*>(_node)->get_func_type();
+    if ( _memo != nullptr )
+    {
+        _memo->emplace(_node, invokable);
+    }
+    return invokable;
+}
 
-                    instr->call.invokable = get_language()->find_function( &func_type ); // Get exact OR fallback function (in case of arg cast)
-                    ASSERT(instr->call.invokable  != nullptr);
+const TypeDescriptor* Compiler::get_expression_type(const Slot* slot, Invokables* _memo)
+{
+    ASSERT(slot->has_flags(SlotFlag_INPUT) );
 
-                    break;
-                }
-                case NodeType_LITERAL:
-                case NodeType_VARIABLE:
-                    VERIFY(false, "not implemented yet");
+    if ( slot->empty() )
+    {
+        return get_constant_value( slot->property ).get_type();
+    }
+
+    const Node* node = slot->first_adjacent()->node;
+    switch ( node->type() )
+    {
+        case NodeType_VARIABLE:
+            return static_cast<const VariableNode*>(node)->get_type(); // a variable's value is always converted to its type (cf. OpCode_store)
+        case NodeType_VARIABLE_REF:
+        {
+            const VariableNode* variable = static_cast<const VariableRefNode*>(node)->get_variable();
+            return variable ? variable->get_type() : nullptr;
+        }
+        case NodeType_LITERAL:
+            return get_constant_value( node->value() ).get_type();
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+        {
+            const IInvokable* invokable = find_invokable( static_cast<const FunctionNode*>(node), _memo );
+            return invokable ? invokable->get_sig()->return_type() : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+const VariableNode* Compiler::get_assigned_variable(const FunctionNode* _node, const IInvokable* _invokable) const
+{
+    const FunctionDescriptor* sig = _invokable->get_sig();
+    if ( _node->type() != NodeType_OPERATOR || sig->arg_count() != 2 || strcmp(sig->get_identifier(), "=") != 0 || !sig->arg_at(0).pass_by_ref )
+    {
+        return nullptr;
+    }
+
+    const Slot* left = _node->get_arg_slots()[0];
+    if ( left->empty() )
+    {
+        return nullptr;
+    }
+
+    const Slot*         output   = left->first_adjacent();
+    const VariableNode* variable = nullptr;
+    switch ( output->node->type() )
+    {
+        case NodeType_VARIABLE:
+            variable = static_cast<const VariableNode*>(output->node);
+            if ( output == variable->decl_out() )
+            {
+                return nullptr; // ex: "int a = b = 2", the declaration must be compiled first
             }
+            break;
+        case NodeType_VARIABLE_REF:
+            variable = static_cast<const VariableRefNode*>(output->node)->get_variable();
+            break;
+        default:
+            return nullptr;
+    }
+
+    // the store converts the value to the variable's type, as the assignment implementation would
+    if ( variable == nullptr || !variable->get_type()->equals(sig->arg_at(0).type) || m_variable_slot.find(variable) == m_variable_slot.end() )
+    {
+        return nullptr;
+    }
+    return variable;
+}
 
+bool Compiler::can_call_native(const FunctionNode* _node, const IInvokable* _invokable) const
+{
+    if ( !_invokable->get_native().valid() )
+    {
+        return false;
+    }
+
+    // no conversion at runtime: each argument must have the exact type of the signature's
+    const FunctionDescriptor* sig       = _invokable->get_sig();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        const TypeDescriptor* value_type = get_expression_type( arg_slots[i], &m_invokables );
+        if ( value_type == nullptr || !value_type->equals(sig->arg_at(i).type) )
+        {
+            return false;
         }
     }
+    return true;
 }
 
-void Compiler::compile_for_loop(const ForLoopNode* for_loop)
+OpCode Compiler::get_typed_operator(const FunctionNode* _node, const IInvokable* _invokable) const
 {
-    // Compile initialization instruction
-    compile_input_slot( for_loop->initialization_slot() );
+    if ( _node->type() != NodeType_OPERATOR )
+    {
+        return OpCode_call;
+    }
 
-    // compile condition and memorise its position
-    u64_t conditionInstrLine = m_temp_code->get_next_index();
-    compile_instruction_as_condition( for_loop->condition() );
+    // each operand must have the exact type of the implementation's arguments, the same for all (no conversion at runtime)
+    const FunctionDescriptor* sig       = _invokable->get_sig();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    if ( sig->arg_count() == 0 || sig->arg_count() != arg_slots.size() )
+    {
+        return OpCode_call;
+    }
 
-    // jump if condition is not true
-    Instruction* skipTrueBranch = m_temp_code->push_instr(OpCode_jne );
-    skipTrueBranch->m_comment = "jump true branch";
+    const TypeDescriptor* type = sig->arg_at(0).type;
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        const FuncArg&        arg        = sig->arg_at(i);
+        const TypeDescriptor* value_type = get_expression_type( arg_slots[i], &m_invokables );
+        if ( arg.pass_by_ref || !arg.type->equals(type) || value_type == nullptr || !value_type->equals(type) )
+        {
+            return OpCode_call;
+        }
+    }
 
-    if ( auto true_branch = for_loop->branch_out(Branch_TRUE) )
+    // OpCode_call is used when no typed opcode exists for a given type
+    struct TypedOperator
     {
-        compile_inner_scope( true_branch->node );
+        const char* identifier;
+        size_t      arg_count;
+        OpCode      i32_opcode;
+        OpCode      f64_opcode;
+        OpCode      bool_opcode;
+    };
 
-        // Compile iteration instruction
-        compile_input_slot( for_loop->iteration_slot() );
+    static const TypedOperator typed_operators[] =
+    {
+        { "+",   2, OpCode_add_i32, OpCode_add_f64, OpCode_call },
+        { "-",   2, OpCode_sub_i32, OpCode_sub_f64, OpCode_call },
+        { "*",   2, OpCode_mul_i32, OpCode_mul_f64, OpCode_call },
+        { "/",   2, OpCode_div_i32, OpCode_div_f64, OpCode_call },
+        { "-",   1, OpCode_neg_i32, OpCode_neg_f64, OpCode_call },
+        { "<",   2, OpCode_lt_i32,  OpCode_lt_f64,  OpCode_call },
+        { "<=",  2, OpCode_le_i32,  OpCode_le_f64,  OpCode_call },
+        { ">",   2, OpCode_gt_i32,  OpCode_gt_f64,  OpCode_call },
+        { ">=",  2, OpCode_ge_i32,  OpCode_ge_f64,  OpCode_call },
+        { "==",  2, OpCode_eq_i32,  OpCode_eq_f64,  OpCode_call },
+        { "!=",  2, OpCode_ne_i32,  OpCode_ne_f64,  OpCode_ne_bool },
+        { "<=>", 2, OpCode_call,    OpCode_call,    OpCode_eq_bool },
+        { "&&",  2, OpCode_call,    OpCode_call,    OpCode_and_bool },
+        { "||",  2, OpCode_call,    OpCode_call,    OpCode_or_bool },
+        { "!",   1, OpCode_call,    OpCode_call,    OpCode_not_bool },
+    };
 
-        // jump back to condition instruction
-        auto loopJump = m_temp_code->push_instr(OpCode_jmp );
-        loopJump->jmp.offset = signed_diff( conditionInstrLine, loopJump->line );
-        loopJump->m_comment = "jump back to \"for\"";
+    for ( const TypedOperator& each : typed_operators )
+    {
+        if ( each.arg_count != sig->arg_count() || strcmp(each.identifier, sig->get_identifier()) != 0 )
+        {
+            continue;
+        }
+        if ( type->is<i32_t>() )  return each.i32_opcode;
+        if ( type->is<double>() ) return each.f64_opcode;
+        if ( type->is<bool>() )   return each.bool_opcode;
+        return OpCode_call;
     }
+    return OpCode_call;
+}
 
+void Compiler::compile_variable_decl(const VariableNode* variable)
+{
+    DebugNodeScope debug_node(m_temp_code, variable);
+
+    // an input is initialized with the value of the row being run (cf. Interpreter::run_batch())
+    auto input = m_input_index.find( variable );
+    if ( input != m_input_index.end() )
+    {
+        Instruction* instr = m_temp_code->push_instr(OpCode_load_input, variable->get_identifier());
+        instr->input.index = input->second;
+        stack_push();
+    }
+    else
+    {
+        const Slot* value_in = variable->value_in();
+        if ( value_in->empty() )
+        {
+            return; // variable keeps its default value (cf. OpCode_push_var)
+        }
+        compile_input_slot( value_in );
+    }
 
-    skipTrueBranch->jmp.offset = m_temp_code->get_next_index() - skipTrueBranch->line;
+    Instruction* instr = m_temp_code->push_instr(OpCode_store, variable->get_identifier());
+    instr->slot.index  = get_variable_slot( variable );
+    instr->slot.type   = variable->get_type();
+    stack_pop();
 }
 
-void Compiler::compile_while_loop(const WhileLoopNode* while_loop)
+void Compiler::compile_variable_access(const VariableNode* variable, bool _by_ref)
 {
-    // compile condition and memorise its position
-    u64_t conditionInstrLine = m_temp_code->get_next_index();
-    compile_instruction_as_condition( while_loop->condition() );
+    Instruction* instr = m_temp_code->push_instr(_by_ref ? OpCode_load_ref : OpCode_load, variable->get_identifier() );
+    instr->slot.index  = get_variable_slot( variable );
+    instr->slot.type   = variable->get_type();
+    stack_push();
+}
 
-    // jump if condition is not true
-    Instruction* skipTrueBranch = m_temp_code->push_instr(OpCode_jne );
-    skipTrueBranch->m_comment = "jump if not equal";
+void Compiler::compile_statement_slot(const Slot* slot)
+{
+    if ( slot->empty() || slot->first_adjacent()->node->type() == NodeType_EMPTY_INSTRUCTION )
+    {
+        return; // nothing to evaluate, ex: "for(;;)"
+    }
 
-    if ( auto whileScope = while_loop->branch_out( Branch_TRUE ) )
+    // evaluate the expression, and store its result (if any) in rax
+    size_t stack_size = m_stack_size;
+    compile_input_slot( slot );
+    if ( m_stack_size != stack_size )
     {
-        compile_inner_scope( whileScope->node );
+        Instruction* instr  = m_temp_code->push_instr(OpCode_pop, "store result");
+        instr->pop_reg.dst  = Register_rax;
+        stack_pop();
+    }
+}
 
-        // jump back to condition instruction
-        auto loopJump = m_temp_code->push_instr(OpCode_jmp );
-        loopJump->jmp.offset = signed_diff( conditionInstrLine, loopJump->line );
-        loopJump->m_comment = "jump back to \"while\"";
+void Compiler::compile_scope_begin(const Scope* scope)
+{
+    DebugNodeScope debug_node(m_temp_code, scope->node());
+
+    // call push_stack_frame
+    {
+        char str[64];
+        snprintf(str, 64, "%s's scope", scope->node()->name().c_str());
+        Instruction *instr  = m_temp_code->push_instr(OpCode_push_stack_frame, str);
+        instr->push.scope   = scope;
+        instr->push.size    = (u32_t)scope->variable().size(); // a slot per variable
     }
 
-    skipTrueBranch->jmp.offset = m_temp_code->get_next_index() - skipTrueBranch->line;
+    // initialize each variable's slot
+    for(auto each_variable : scope->variable())
+    {
+        Instruction* instr   = m_temp_code->push_instr(OpCode_push_var, each_variable->name());
+        instr->push.type     = each_variable->get_type();
+        instr->push.index    = (u32_t)m_stack_size;
+        instr->push.reg      = Register_undefined; // cf. allocate_registers()
+        m_variable_slot[each_variable]  = (u32_t)m_stack_size;
+        m_variable_chunk[each_variable] = m_chunk;
+        m_chunk->declared.push_back({ each_variable, (u32_t)m_stack_size, each_variable->get_type() });
+        stack_push();
+    }
 }
 
-void Compiler::compile_instruction_as_condition(const Node* _instr_node)
+void Compiler::compile_scope_end(const Scope* scope)
 {
-    // compile condition result (must be stored in rax after this line)
-    compile_node(_instr_node);
+    DebugNodeScope debug_node(m_temp_code, scope->node());
 
-    // move "true" result to rdx
-    Instruction* store_true = m_temp_code->push_instr(OpCode_mov);
-    store_true->mov.src.b   = true;
-    store_true->mov.dst.u8  = Register_rdx;
-    store_true->m_comment   = "store true in rdx";
+    // the frame releases the variable slots at once
+    for(size_t i = 0; i < scope->variable().size(); ++i)
+    {
+        stack_pop();
+    }
 
-    // compare rax (condition result) with rdx (true)
-    Instruction* cmp_instr  = m_temp_code->push_instr(OpCode_cmp);  // works only with registry
-    cmp_instr->cmp.left.u8  = Register_rax;
-    cmp_instr->cmp.right.u8 = Register_rdx;
-    cmp_instr->m_comment    = "compare condition with rdx";
+    {
+        Instruction *instr = m_temp_code->push_instr(OpCode_pop_stack_frame, scope->node()->name() + "'s scope");
+        instr->pop.scope   = scope;
+    }
 }
 
-void Compiler::compile_conditional_struct(const IfNode* _cond_node)
+void Compiler::compile_scope(const Scope* scope, bool _insert_fake_return)
 {
-    compile_instruction_as_condition( _cond_node->condition() ); // compile condition instruction, store result, compare
+    ASSERT( scope );
+    ASSERT( m_chunk );
 
-    Instruction* jump_over_true_branch = m_temp_code->push_instr(OpCode_jne);
-    jump_over_true_branch->m_comment   = "conditional jump";
+    // the nested chunk is replaced by its code when linked
+    m_chunk->nested.push_back({ m_temp_code->get_next_index(), scope, m_stack_size });
+    Instruction* placeholder = m_temp_code->push_instr(OpCode_push_stack_frame, "nested scope");
+    placeholder->push.scope  = scope;
 
-    Instruction* jump_after_conditional = nullptr;
+    compile_chunk( scope, _insert_fake_return );
+}
+
+Compiler::Chunk& Compiler::compile_chunk(const Scope* scope, bool _insert_fake_return)
+{
+    const u64_t fingerprint = get_fingerprint( scope );
+    Chunk&      chunk       = m_chunks[scope];
+    chunk.generation        = m_generation;
 
-    if ( auto true_branch = _cond_node->branch_out( Branch_TRUE ) )
+    if ( is_chunk_valid( chunk, _insert_fake_return, fingerprint ) )
     {
-        compile_inner_scope( true_branch->node );
+        ++m_reused_chunk_count;
 
-        if ( _cond_node->branch_out( Branch_FALSE )->node )
+        // restore the state the nested chunks depend on
+        for ( const VariableSlot& each : chunk.declared )
         {
-            jump_after_conditional = m_temp_code->push_instr(OpCode_jmp);
-            jump_after_conditional->m_comment = "jump after else";
+            m_variable_slot[each.variable]  = each.index;
+            m_variable_chunk[each.variable] = &chunk;
         }
-    }
-
-    i64_t next_index = m_temp_code->get_next_index();
-    jump_over_true_branch->jmp.offset = next_index - jump_over_true_branch->line;
-
-    if ( const Slot* false_branch = _cond_node->branch_out(Branch_FALSE ) )
-    {
-        if( false_branch->node->get_class()->is<IfNode>() )
+        for ( const InvariantSlot& each : chunk.hoisted )
         {
-            compile_conditional_struct( static_cast<const IfNode*>(false_branch->node) );
+            m_invariant_slot[each.node]  = each.index;
+            m_invariant_chunk[each.node] = &chunk;
         }
-        else
+        for ( const NestedChunk& each : chunk.nested )
         {
-            compile_inner_scope(false_branch->node );
+            m_stack_size = each.stack_size;
+            compile_chunk( each.scope, false );
         }
-
-        if ( jump_after_conditional )
+        for ( const InvariantSlot& each : chunk.hoisted )
         {
-            jump_after_conditional->jmp.offset = signed_diff(m_temp_code->get_next_index(), jump_after_conditional->line);
+            m_invariant_slot.erase(each.node);
+            m_invariant_chunk.erase(each.node);
         }
+        m_stack_size     = chunk.stack_base;
+        m_stack_size_max = std::max( m_stack_size_max, chunk.stack_size_max );
+    }
+    else
+    {
+        ++m_emitted_chunk_count;
+
+        Code*  parent_code    = m_temp_code;
+        Chunk* parent_chunk   = m_chunk;
+        size_t stack_size_max = m_stack_size_max;
+
+        chunk.fingerprint    = fingerprint;
+        chunk.stack_base     = m_stack_size;
+        chunk.fake_return    = _insert_fake_return;
+        chunk.code           = std::make_unique<Code>( m_chunks_graph, m_chunks_flags & CompilerFlag_DEBUG_INFO );
+        chunk.nested.clear();
+        chunk.declared.clear();
+        chunk.external.clear();
+        chunk.hoisted.clear();
+        chunk.invariant.clear();
+
+        m_temp_code      = chunk.code.get();
+        m_chunk          = &chunk;
+        m_stack_size_max = m_stack_size;
+
+        emit_chunk( scope, _insert_fake_return );
+
+        chunk.stack_size_max = m_stack_size_max;
+        m_temp_code          = parent_code;
+        m_chunk              = parent_chunk;
+        m_stack_size_max     = std::max( stack_size_max, chunk.stack_size_max );
     }
+
+    chunk.linked_size = chunk.code->size() - chunk.nested.size();
+    for ( const NestedChunk& each : chunk.nested )
+    {
+        chunk.linked_size += m_chunks.at(each.scope).linked_size;
+    }
+    return chunk;
 }
 
-const Code* Compiler::compile_syntax_tree(const Graph* _graph)
+bool Compiler::is_chunk_valid(const Chunk& chunk, bool _insert_fake_return, u64_t _fingerprint) const
 {
-    if (is_syntax_tree_valid(_graph))
+    if ( chunk.code == nullptr || chunk.fingerprint != _fingerprint || chunk.fake_return != _insert_fake_return || chunk.stack_base != m_stack_size )
     {
-        m_temp_code = new Code( _graph );
+        return false;
+    }
 
-        try
+    // the variables declared outside must still have the same slot and type
+    for ( const VariableSlot& each : chunk.external )
+    {
+        auto found = m_variable_slot.find(each.variable);
+        if ( found == m_variable_slot.end() || found->second != each.index || each.variable->get_type() != each.type )
         {
-            compile_inner_scope( _graph->root().get(), true); // "true" <== here is a hack, TODO: implement a real ReturnNode
-            LOG_MESSAGE("Compiler", "Program compiled.\n");
+            return false;
         }
-        catch ( const std::exception& e )
-        {
-            delete m_temp_code;
+    }
+
+    // the loop-invariant expressions computed outside must still have the same slot
+    for ( const InvariantSlot& each : chunk.invariant )
+    {
+        auto found = m_invariant_slot.find(each.node);
+        if ( found == m_invariant_slot.end() || found->second != each.index )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Compiler::emit_chunk(const Scope* scope, bool _insert_fake_return)
+{
+    compile_scope_begin( scope );
+
+    // compile content
+    for( Node* each_node : scope->child() )
+    {
+        compile_node( each_node );
+    }
+
+    // before to pop, we could insert a return value
+    if( _insert_fake_return )
+    {
+        m_temp_code->push_instr(OpCode_ret); // fake a return statement
+    }
+
+    compile_scope_end( scope );
+}
+
+void Compiler::link_chunk(const Chunk& _chunk, Code* _out) const
+{
+    const Code& code = *_chunk.code;
+
+    // compute each instruction's index once linked (a placeholder is replaced by its nested chunk)
+    std::vector<size_t> linked_index(code.size() + 1);
+    size_t index  = _out->size();
+    auto   nested = _chunk.nested.begin();
+    for ( size_t i = 0; i < code.size(); ++i )
+    {
+        linked_index[i] = index;
+        if ( nested != _chunk.nested.end() && nested->index == i )
+        {
+            index += m_chunks.at(nested->scope).linked_size;
+            ++nested;
+        }
+        else
+        {
+            ++index;
+        }
+    }
+    linked_index[code.size()] = index;
+
+    const u32_t constant_base = (u32_t)_out->get_constants().size();
+    for ( const variant& each : code.get_constants() )
+    {
+        _out->push_constant(each);
+    }
+    const u32_t dataflow_base = (u32_t)_out->get_dataflows().size();
+    for ( const Dataflow& each : code.get_dataflows() )
+    {
+        _out->push_dataflow( Dataflow(each) );
+    }
+
+    nested = _chunk.nested.begin();
+    for ( size_t i = 0; i < code.size(); ++i )
+    {
+        if ( nested != _chunk.nested.end() && nested->index == i )
+        {
+            link_chunk( m_chunks.at(nested->scope), _out );
+            ++nested;
+            continue;
+        }
+
+        Instruction instr = *code.get_instruction_at(i);
+        if ( instr.is_jump() )
+        {
+            const size_t target = i + instr.get_jump_offset();
+            instr.set_jump_offset( (i64_t)linked_index[target] - (i64_t)linked_index[i] );
+        }
+        else if ( instr.opcode == OpCode_push_const )
+        {
+            instr.constant.index += constant_base;
+        }
+        else if ( instr.opcode == OpCode_dataflow )
+        {
+            instr.dataflow.index += dataflow_base;
+        }
+
+        const Code::DebugInfo* debug_info = code.get_debug_info(i);
+        _out->set_debug_node( debug_info ? debug_info->node : nullptr );
+        *_out->push_instr(instr.opcode, debug_info ? debug_info->comment : std::string_view{}) = instr;
+    }
+    ASSERT(_out->size() == linked_index[code.size()]);
+}
+
+u64_t Compiler::get_fingerprint(const Scope* scope) const
+{
+    u64_t result = Hash::combine(Hash::DEFAULT_SEED, scope);
+    result = Hash::combine(result, scope->node()->name()); // used in comments
+    for ( const Node* each : scope->variable() )
+    {
+        result = each->hash(result);
+    }
+    for ( const Node* each : scope->child() )
+    {
+        result = get_statement_fingerprint(result, each);
+    }
+    return result;
+}
+
+u64_t Compiler::get_statement_fingerprint(u64_t _hash, const Node* _node) const
+{
+    u64_t result = _node->hash(_hash);
+
+    // nodes compiled with the statement (ex: for loop's initialization, condition, and iteration), nested scopes are separate chunks
+    if ( const Scope* internal_scope = _node->internal_scope() )
+    {
+        result = Hash::combine(result, internal_scope);
+        for ( const Node* each : internal_scope->variable() )
+        {
+            result = each->hash(result);
+        }
+        for ( const Scope* each : internal_scope->partition() )
+        {
+            result = Hash::combine(result, each);
+        }
+
+        // the loop-invariant expressions hoisted out of a loop depend on its nested scopes (cf. compile_loop_invariants())
+        const NodeType type = _node->type();
+        if ( m_opt_level >= OptLevel_O2 && (type == NodeType_BLOCK_FOR_LOOP || type == NodeType_BLOCK_WHILE_LOOP) )
+        {
+            std::set<Scope*> nested_scopes;
+            Scope::get_descendent( nested_scopes, _node->internal_scope(), ScopeFlags_NONE );
+            for ( const Scope* each_scope : nested_scopes )
+            {
+                result = Hash::combine(result, each_scope);
+                for ( const Node* each : each_scope->variable() )
+                {
+                    result = each->hash(result);
+                }
+                for ( const Node* each : each_scope->child() )
+                {
+                    result = get_statement_fingerprint(result, each);
+                }
+            }
+        }
+    }
+
+    for ( const Slot* slot : _node->slots() )
+    {
+        if ( !slot->has_flags(SlotFlag_INPUT) )
+        {
+            continue;
+        }
+        for ( const Slot* adjacent : slot->adjacent() )
+        {
+            const Node* input = adjacent->node;
+            if ( input->type() == NodeType_VARIABLE && adjacent != static_cast<const VariableNode*>(input)->decl_out() )
+            {
+                result = Hash::combine(result, input); // variable is read (its declaration belongs to another statement)
+                continue;
+            }
+            result = get_statement_fingerprint(result, input);
+        }
+    }
+    return result;
+}
+
+u32_t Compiler::get_variable_slot(const VariableNode* variable)
+{
+    auto found = m_variable_slot.find( variable );
+    VERIFY(found != m_variable_slot.end(), "Variable is not declared in any compiled scope");
+    if ( m_variable_chunk.at(variable) != m_chunk )
+    {
+        m_chunk->external.push_back({ variable, found->second, variable->get_type() });
+    }
+    return found->second;
+}
+
+u32_t Compiler::get_invariant_slot(const FunctionNode* _node)
+{
+    auto found = m_invariant_slot.find( _node );
+    VERIFY(found != m_invariant_slot.end(), "Expression is not hoisted out of any compiled loop");
+    if ( m_invariant_chunk.at(_node) != m_chunk )
+    {
+        m_chunk->invariant.push_back({ _node, found->second });
+    }
+    return found->second;
+}
+
+void Compiler::clear_chunks()
+{
+    m_chunks.clear();
+    m_chunks_graph = nullptr;
+    m_chunks_inputs.clear();
+}
+
+bool Compiler::compile_dataflow(const FunctionNode* _node)
+{
+    Dataflow                         dataflow;
+    std::vector<const VariableNode*> inputs;
+    u32_t                            root;
+    if ( !build_dataflow_task(_node, dataflow, inputs, root) || dataflow.get_width() < 2 )
+    {
+        return false;
+    }
+
+    // variables are read before, in the Interpreter's thread (the tasks only see copies)
+    for ( const VariableNode* each : inputs )
+    {
+        compile_variable_access( each, false );
+    }
+
+    Instruction* instr    = m_temp_code->push_instr(OpCode_dataflow, _node->name());
+    instr->dataflow.index = m_temp_code->push_dataflow( std::move(dataflow) );
+
+    // inputs are replaced by the result
+    stack_pop( inputs.size() );
+    stack_push();
+    return true;
+}
+
+bool Compiler::build_dataflow_task(const FunctionNode* _node, Dataflow& _dataflow, std::vector<const VariableNode*>& _inputs, u32_t& _task) const
+{
+    const IInvokable* invokable = find_invokable( _node, &m_invokables );
+    if ( invokable == nullptr || !get_language()->is_pure(invokable) )
+    {
+        return false;
+    }
+
+    const FunctionDescriptor* sig       = invokable->get_sig();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    if ( arg_slots.size() != sig->arg_count() || sig->return_type()->is<void>() )
+    {
+        return false;
+    }
+
+    std::vector<Dataflow::Operand> args;
+    args.reserve( arg_slots.size() );
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        const FuncArg& arg_type = sig->arg_at(i);
+        const Slot*    slot     = arg_slots[i];
+        variant     value;
+        if ( slot->empty() )
+        {
+            value = get_constant_value( slot->property );
+            value.convert( arg_type.type );
+            args.push_back({ Dataflow::OperandType_CONSTANT, _dataflow.push_constant(value) });
+            continue;
+        }
+
+        const Slot* adjacent = slot->first_adjacent();
+        const Node* node     = adjacent->node;
+        switch ( node->type() )
+        {
+            case NodeType_LITERAL:
+                value = get_constant_value( node->value() );
+                value.convert( arg_type.type );
+                args.push_back({ Dataflow::OperandType_CONSTANT, _dataflow.push_constant(value) });
+                break;
+
+            case NodeType_VARIABLE:
+            case NodeType_VARIABLE_REF:
+            {
+                const VariableNode* variable = node->type() == NodeType_VARIABLE
+                                             ? static_cast<const VariableNode*>(node)
+                                             : static_cast<const VariableRefNode*>(node)->get_variable();
+                if ( variable == nullptr || adjacent == variable->decl_out() )
+                {
+                    return false; // a declaration is not pure
+                }
+
+                // each variable is an input, read once
+                auto found = std::find(_inputs.begin(), _inputs.end(), variable);
+                if ( found == _inputs.end() )
+                {
+                    _inputs.push_back(variable);
+                    found = std::prev(_inputs.end());
+                    _dataflow.push_input();
+                }
+                args.push_back({ Dataflow::OperandType_INPUT, (u32_t)std::distance(_inputs.begin(), found) });
+                break;
+            }
+
+            case NodeType_FUNCTION:
+            case NodeType_OPERATOR:
+            {
+                auto function = static_cast<const FunctionNode*>(node);
+                if ( m_opt_level >= OptLevel_O1 && evaluate_function_call(function, value) )
+                {
+                    args.push_back({ Dataflow::OperandType_CONSTANT, _dataflow.push_constant(value) });
+                    break;
+                }
+                u32_t task;
+                if ( !build_dataflow_task(function, _dataflow, _inputs, task) )
+                {
+                    return false;
+                }
+                args.push_back({ Dataflow::OperandType_TASK, task });
+                break;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    // operators are cheap, only function calls are worth running in another thread
+    _task = _dataflow.push_task( invokable, std::move(args), _node->type() == NodeType_FUNCTION );
+    return true;
+}
+
+void Compiler::compile_node( const Node* _node )
+{
+    ASSERT( _node );
+    DebugNodeScope debug_node(m_temp_code, _node);
+
+    switch (_node->type())
+    {
+        case NodeType_BLOCK_FOR_LOOP:
+            compile_for_loop(static_cast<const ForLoopNode*>(_node));
+            break;
+        case NodeType_BLOCK_WHILE_LOOP:
+            compile_while_loop(static_cast<const WhileLoopNode*>(_node));
+            break;
+        case NodeType_BLOCK_IF:
+            compile_conditional_struct(static_cast<const IfNode*>(_node));
+            break;
+        case NodeType_VARIABLE:
+        {
+            auto variable = static_cast<const VariableNode*>(_node);
+            if ( variable->decl_out()->empty() ) // otherwise declaration is compiled where it is used
+            {
+                compile_variable_decl( variable );
+            }
+            break;
+        }
+        case NodeType_VARIABLE_REF:
+        case NodeType_LITERAL:
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+        {
+            // evaluate the expression, and store its result (if any) in rax
+            size_t stack_size = m_stack_size;
+            compile_output_slot( _node->value_out() );
+            if ( m_stack_size != stack_size )
+            {
+                Instruction* instr  = m_temp_code->push_instr(OpCode_pop, "store result");
+                instr->pop_reg.dst  = Register_rax;
+                stack_pop();
+            }
+            break;
+        }
+        default:
+            break; // nothing to compile (ex: empty instruction)
+    }
+}
+
+void Compiler::compile_for_loop(const ForLoopNode* for_loop)
+{
+    // variables declared in for's parenthesis are stored in its internal scope
+    const Scope* scope = for_loop->internal_scope();
+    compile_scope_begin( scope );
+
+    // Compile initialization instruction
+    compile_statement_slot( for_loop->initialization_slot() );
+
+    // compute the loop-invariant expressions once
+    const std::vector<const FunctionNode*> invariants = compile_loop_invariants( for_loop, for_loop->condition_in(), for_loop->iteration_slot() );
+
+    // compile condition and memorise its position, jump if condition is not true
+    u64_t conditionInstrLine = m_temp_code->get_next_index();
+    u64_t skipTrueBranchLine = compile_instruction_as_condition( for_loop->condition_in(), "jump true branch" );
+
+    compile_scope( scope->partition().at(Branch_TRUE) );
+
+    // Compile iteration instruction
+    compile_statement_slot( for_loop->iteration_slot() );
+
+    // jump back to condition instruction
+    u64_t loopJumpLine   = m_temp_code->get_next_index();
+    auto loopJump        = m_temp_code->push_instr(OpCode_jmp, "jump back to \"for\"");
+    loopJump->jmp.offset = signed_diff( conditionInstrLine, loopJumpLine );
+
+    set_condition_target( skipTrueBranchLine, m_temp_code->get_next_index() );
+
+    compile_loop_invariants_end( invariants );
+    compile_scope_end( scope );
+}
+
+void Compiler::compile_while_loop(const WhileLoopNode* while_loop)
+{
+    const Scope* scope = while_loop->internal_scope();
+    compile_scope_begin( scope );
+
+    // compute the loop-invariant expressions once
+    const std::vector<const FunctionNode*> invariants = compile_loop_invariants( while_loop, while_loop->condition_in(), nullptr );
+
+    // compile condition and memorise its position, jump if condition is not true
+    u64_t conditionInstrLine = m_temp_code->get_next_index();
+    u64_t skipTrueBranchLine = compile_instruction_as_condition( while_loop->condition_in(), "jump if not equal" );
+
+    compile_scope( scope->partition().at(Branch_TRUE) );
+
+    // jump back to condition instruction
+    u64_t loopJumpLine   = m_temp_code->get_next_index();
+    auto loopJump        = m_temp_code->push_instr(OpCode_jmp, "jump back to \"while\"");
+    loopJump->jmp.offset = signed_diff( conditionInstrLine, loopJumpLine );
+
+    set_condition_target( skipTrueBranchLine, m_temp_code->get_next_index() );
+
+    compile_loop_invariants_end( invariants );
+    compile_scope_end( scope );
+}
+
+std::vector<const FunctionNode*> Compiler::compile_loop_invariants(const Node* _loop, const Slot* _condition, const Slot* _iteration)
+{
+    std::vector<const FunctionNode*> result;
+    if ( m_opt_level < OptLevel_O2 )
+    {
+        return result;
+    }
+
+    // statements run at each iteration: condition, iteration, and the content of the nested scopes
+    // (the content of a partitioned scope, if any, is not compiled, only its partitions are)
+    Loop loop;
+    Scope::get_descendent( loop.scopes, _loop->internal_scope() );
+    std::vector<const Node*> statements;
+    for ( const Slot* each : { _condition, _iteration } )
+    {
+        if ( each != nullptr && !each->empty() )
+        {
+            statements.push_back( each->first_adjacent()->node );
+        }
+    }
+    for ( const Scope* each_scope : loop.scopes )
+    {
+        loop.variant.insert( each_scope->variable().begin(), each_scope->variable().end() );
+        if ( !each_scope->is_partitioned() )
+        {
+            statements.insert( statements.end(), each_scope->child().begin(), each_scope->child().end() );
+        }
+    }
+
+    for ( const Node* each : statements )
+    {
+        find_variant_variables( each, loop );
+    }
+    for ( const Node* each : statements )
+    {
+        find_loop_invariants( each, loop, result );
+    }
+
+    // each value stays in the slot it is pushed to
+    for ( const FunctionNode* each : result )
+    {
+        compile_function_call( each );
+        const u32_t slot_index = (u32_t)m_stack_size - 1;
+        m_invariant_slot[each]  = slot_index;
+        m_invariant_chunk[each] = m_chunk;
+        m_chunk->hoisted.push_back({ each, slot_index });
+    }
+    return result;
+}
+
+void Compiler::compile_loop_invariants_end(const std::vector<const FunctionNode*>& _invariants)
+{
+    for ( auto it = _invariants.rbegin(); it != _invariants.rend(); ++it )
+    {
+        Instruction* instr = m_temp_code->push_instr(OpCode_pop, "pop loop invariant");
+        instr->pop_reg.dst = Register_rdx;
+        stack_pop();
+        m_invariant_slot.erase(*it);
+        m_invariant_chunk.erase(*it);
+    }
+}
+
+void Compiler::find_variant_variables(const Node* _node, Loop& _loop) const
+{
+    // a declaration (reads are not visited) initializes its variable at each iteration
+    if ( _node->type() == NodeType_VARIABLE )
+    {
+        _loop.variant.insert( static_cast<const VariableNode*>(_node) );
+    }
+
+    // a variable passed by reference might be written (all of them when the function is unknown)
+    if ( _node->type() == NodeType_FUNCTION || _node->type() == NodeType_OPERATOR )
+    {
+        auto                      function  = static_cast<const FunctionNode*>(_node);
+        const IInvokable*         invokable = find_invokable( function, &m_invokables );
+        const std::vector<Slot*>& arg_slots = function->get_arg_slots();
+        for ( size_t i = 0; i < arg_slots.size(); ++i )
+        {
+            const bool by_ref = invokable == nullptr || i >= invokable->get_sig()->arg_count() || invokable->get_sig()->arg_at(i).pass_by_ref;
+            if ( !by_ref || arg_slots[i]->empty() )
+            {
+                continue;
+            }
+            const Node* arg = arg_slots[i]->first_adjacent()->node;
+            if ( arg->type() == NodeType_VARIABLE )
+            {
+                _loop.variant.insert( static_cast<const VariableNode*>(arg) );
+            }
+            else if ( arg->type() == NodeType_VARIABLE_REF )
+            {
+                _loop.variant.insert( static_cast<const VariableRefNode*>(arg)->get_variable() );
+            }
+        }
+    }
+
+    for ( const Slot* slot : _node->slots() )
+    {
+        if ( !slot->has_flags(SlotFlag_INPUT) )
+        {
+            continue;
+        }
+        for ( const Slot* adjacent : slot->adjacent() )
+        {
+            const Node* input = adjacent->node;
+            if ( input->type() == NodeType_VARIABLE && adjacent != static_cast<const VariableNode*>(input)->decl_out() )
+            {
+                continue; // variable is read (its declaration belongs to another statement)
+            }
+            find_variant_variables( input, _loop );
+        }
+    }
+}
+
+void Compiler::find_loop_invariants(const Node* _node, const Loop& _loop, std::vector<const FunctionNode*>& _out) const
+{
+    if ( _node->type() == NodeType_FUNCTION || _node->type() == NodeType_OPERATOR )
+    {
+        auto function = static_cast<const FunctionNode*>(_node);
+        if ( m_invariant_slot.find(function) != m_invariant_slot.end() || std::find(_out.begin(), _out.end(), function) != _out.end() )
+        {
+            return; // already hoisted (ex: by an outer loop)
+        }
+        if ( is_loop_invariant_call(function, _loop) )
+        {
+            variant folded;
+            if ( !evaluate_function_call(function, folded) ) // otherwise it is folded to a constant
+            {
+                _out.push_back( function );
+            }
+            return;
+        }
+    }
+
+    for ( const Slot* slot : _node->slots() )
+    {
+        if ( !slot->has_flags(SlotFlag_INPUT) )
+        {
+            continue;
+        }
+        for ( const Slot* adjacent : slot->adjacent() )
+        {
+            const Node* input = adjacent->node;
+            if ( input->type() == NodeType_VARIABLE && adjacent != static_cast<const VariableNode*>(input)->decl_out() )
+            {
+                continue; // variable is read (its declaration belongs to another statement)
+            }
+            find_loop_invariants( input, _loop, _out );
+        }
+    }
+}
+
+bool Compiler::is_loop_invariant(const Slot* slot, const Loop& _loop) const
+{
+    ASSERT(slot->has_flags(SlotFlag_INPUT) );
+
+    if ( slot->empty() )
+    {
+        return true; // constant
+    }
+
+    const Slot*         adjacent = slot->first_adjacent();
+    const Node*         node     = adjacent->node;
+    const VariableNode* variable = nullptr;
+    switch ( node->type() )
+    {
+        case NodeType_LITERAL:
+            return true;
+        case NodeType_VARIABLE:
+            variable = static_cast<const VariableNode*>(node);
+            if ( adjacent == variable->decl_out() )
+            {
+                return false; // a declaration is not pure
+            }
+            break;
+        case NodeType_VARIABLE_REF:
+            variable = static_cast<const VariableRefNode*>(node)->get_variable();
+            break;
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:
+        {
+            auto function = static_cast<const FunctionNode*>(node);
+            return m_invariant_slot.find(function) != m_invariant_slot.end() || is_loop_invariant_call(function, _loop);
+        }
+        default:
+            return false;
+    }
+
+    // a variable declared outside the loop and never written in it
+    return variable != nullptr && _loop.variant.find(variable) == _loop.variant.end() && m_variable_slot.find(variable) != m_variable_slot.end();
+}
+
+bool Compiler::is_loop_invariant_call(const FunctionNode* _node, const Loop& _loop) const
+{
+    const IInvokable* invokable = find_invokable( _node, &m_invokables );
+    if ( invokable == nullptr || !get_language()->is_pure(invokable) )
+    {
+        return false;
+    }
+
+    const FunctionDescriptor* sig       = invokable->get_sig();
+    const std::vector<Slot*>& arg_slots = _node->get_arg_slots();
+    if ( arg_slots.size() != sig->arg_count() || sig->return_type()->is<void>() )
+    {
+        return false;
+    }
+    for ( size_t i = 0; i < arg_slots.size(); ++i )
+    {
+        if ( !is_loop_invariant(arg_slots[i], _loop) )
+        {
+            return false;
+        }
+    }
+
+    // the call is hoisted before the condition, it runs even when the loop does not: it must not throw.
+    // The only pure function throwing is the division (by zero), allowed when the divisor is a non-zero constant.
+    if ( strcmp(sig->get_identifier(), "/") == 0 )
+    {
+        variant divisor;
+        if ( arg_slots.size() != 2 || !evaluate_input_slot(arg_slots[1], divisor) )
+        {
+            return false;
+        }
+        divisor.convert( type::get<double>() );
+        return (double)divisor != 0.0;
+    }
+    return true;
+}
+
+size_t Compiler::compile_instruction_as_condition(const Slot* _condition_in, const char* _comment)
+{
+    if ( is_empty_condition(_condition_in) )
+    {
+        return NO_BRANCH; // an empty condition is always true, there is nothing to test
+    }
+
+    // compile condition, pop its result to rax, and jump if false (single superinstruction instead of pop/mov/cmp/jne)
+    compile_input_slot( _condition_in );
+    size_t branch_index = m_temp_code->get_next_index();
+    m_temp_code->push_instr(OpCode_pop_jne, _comment);
+    stack_pop();
+
+    return branch_index;
+}
+
+bool Compiler::is_empty_condition(const Slot* _condition_in)
+{
+    return _condition_in->empty() || _condition_in->first_adjacent()->node->type() == NodeType_EMPTY_INSTRUCTION;
+}
+
+void Compiler::set_condition_target(size_t _branch_index, size_t _target)
+{
+    if ( _branch_index != NO_BRANCH )
+    {
+        m_temp_code->get_instruction_at(_branch_index)->set_jump_offset( signed_diff(_target, _branch_index) );
+    }
+}
+
+void Compiler::compile_conditional_struct(const IfNode* _cond_node)
+{
+    const Scope* scope = _cond_node->internal_scope();
+    compile_scope_begin( scope );
+
+    u64_t jump_over_true_branch = compile_instruction_as_condition( _cond_node->condition_in(), "conditional jump" ); // compile condition instruction, jump if false
+
+    compile_scope( scope->partition().at(Branch_TRUE) );
+
+    const Scope* false_scope = scope->partition().at(Branch_FALSE);
+    const bool has_false_branch  = !false_scope->empty();
+    u64_t jump_after_conditional = 0;
+    if ( has_false_branch )
+    {
+        jump_after_conditional = m_temp_code->get_next_index();
+        m_temp_code->push_instr(OpCode_jmp, "jump after else");
+    }
+
+    set_condition_target( jump_over_true_branch, m_temp_code->get_next_index() );
+
+    // the false branch may contain a single IfNode (ex: "else if(...) {...}"), it is compiled as any other node
+    compile_scope( false_scope );
+
+    if ( has_false_branch )
+    {
+        m_temp_code->get_instruction_at(jump_after_conditional)->jmp.offset = signed_diff(m_temp_code->get_next_index(), jump_after_conditional);
+    }
+
+    compile_scope_end( scope );
+}
+
+void Compiler::allocate_registers()
+{
+    // Live interval of a variable, from its declaration to its last use (instruction indexes)
+    struct LiveInterval
+    {
+        const TypeDescriptor* type;                   // variable's type
+        size_t                start;                  // index of its push_var
+        size_t                end;                    // index of its last use
+        bool                  address_taken = false;  // when passed by reference, a variable must stay in its stack slot.
+        Register              reg           = Register_undefined;
+    };
+
+    const size_t              NONE = ~(size_t)0;
+    std::vector<LiveInterval> intervals;
+    std::vector<size_t>       interval_of_instr(m_temp_code->size(), NONE); // interval accessed by each instruction (if any)
+    std::unordered_map<u32_t, size_t> interval_of_slot;                      // interval of the variable occupying each stack slot
+
+    // 1) Compute the live intervals, the variable a load/store refers to is the last one pushed in its slot (scopes are compiled in order)
+    for ( size_t i = 0; i < m_temp_code->size(); ++i )
+    {
+        const Instruction* instr = m_temp_code->get_instruction_at(i);
+        switch ( instr->opcode )
+        {
+            case OpCode_push_var:
+            {
+                interval_of_slot[ instr->push.index ] = intervals.size(); // the variable's slot
+                interval_of_instr[i] = intervals.size();
+                intervals.push_back({ instr->push.type, i, i });
+                break;
+            }
+            case OpCode_pop_stack_frame:
+            {
+                for ( const VariableNode* each : instr->pop.scope->variable() )
+                {
+                    interval_of_slot.erase( m_variable_slot.at(each) ); // the slot might be reused by a temporary value (ex: a loop invariant)
+                }
+                break;
+            }
+            case OpCode_load:
+            case OpCode_load_ref:
+            case OpCode_store:
+            {
+                auto found = interval_of_slot.find(instr->slot.index);
+                if ( found == interval_of_slot.end() )
+                {
+                    break; // not a variable's slot
+                }
+                LiveInterval& interval = intervals[found->second];
+                interval.end            = i;
+                interval.address_taken |= instr->opcode == OpCode_load_ref;
+                interval_of_instr[i]    = found->second;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    // A variable declared before a loop and used in it must live until the loop jumps back
+    bool changed = true;
+    while ( changed )
+    {
+        changed = false;
+        for ( size_t i = 0; i < m_temp_code->size(); ++i )
+        {
+            const Instruction* instr = m_temp_code->get_instruction_at(i);
+            if ( !instr->is_jump() || instr->get_jump_offset() >= 0 )
+            {
+                continue;
+            }
+            const size_t loop_begin = i + instr->get_jump_offset();
+            for ( LiveInterval& interval : intervals )
+            {
+                if ( interval.start < loop_begin && loop_begin <= interval.end && interval.end < i )
+                {
+                    interval.end = i;
+                    changed      = true;
+                }
+            }
+        }
+    }
+
+    // 2) Linear scan, intervals are sorted by start. When no register is free, the interval ending last is spilled (stays in its stack slot).
+    std::vector<Register> free_registers;
+    for ( int reg = Register_GP_FIRST + Register_GP_COUNT - 1; reg >= Register_GP_FIRST; --reg )
+    {
+        free_registers.push_back( (Register)reg );
+    }
+    std::vector<LiveInterval*> active; // intervals having a register, sorted by end
+    size_t                     spill_count = 0;
+
+    for ( LiveInterval& interval : intervals )
+    {
+        const TypeDescriptor* type = interval.type;
+        if ( interval.address_taken || !(type->is<i32_t>() || type->is<double>() || type->is<bool>()) )
+        {
+            continue; // registers store raw values (qword), only these types fit
+        }
+
+        // expire the intervals ended before this one starts
+        while ( !active.empty() && active.front()->end < interval.start )
+        {
+            free_registers.push_back( active.front()->reg );
+            active.erase( active.begin() );
+        }
+
+        if ( free_registers.empty() )
+        {
+            LiveInterval* last = active.back();
+            ++spill_count;
+            if ( last->end <= interval.end )
+            {
+                continue; // this one is spilled
+            }
+            interval.reg = last->reg;
+            last->reg    = Register_undefined;
+            active.pop_back();
+        }
+        else
+        {
+            interval.reg = free_registers.back();
+            free_registers.pop_back();
+        }
+
+        auto pos = std::find_if(active.begin(), active.end(), [&](const LiveInterval* each) { return each->end > interval.end; });
+        active.insert(pos, &interval);
+    }
+
+    // 3) Rewrite the instructions accessing a variable allocated to a register
+    size_t allocated_count = 0;
+    for ( size_t i = 0; i < m_temp_code->size(); ++i )
+    {
+        if ( interval_of_instr[i] == NONE || intervals[interval_of_instr[i]].reg == Register_undefined )
+        {
+            continue;
+        }
+
+        const Register reg   = intervals[interval_of_instr[i]].reg;
+        Instruction*   instr = m_temp_code->get_instruction_at(i);
+        switch ( instr->opcode )
+        {
+            case OpCode_push_var:
+                instr->push.reg = reg;
+                ++allocated_count;
+                break;
+            case OpCode_load:
+            case OpCode_store:
+            {
+                Instruction rewritten( instr->opcode == OpCode_load ? OpCode_load_reg : OpCode_store_reg );
+                rewritten.reg.reg  = reg;
+                rewritten.reg.type = instr->slot.type;
+                *instr = rewritten;
+                break;
+            }
+            default:
+                VERIFY(false, "Unexpected instruction");
+        }
+    }
+
+    LOG_MESSAGE("Compiler", "%zu variable(s) allocated to registers, %zu spilled.\n", allocated_count, spill_count);
+}
+
+const Code* Compiler::compile_syntax_tree(const Graph* _graph, CompilerFlags _flags, OptLevel _opt_level)
+{
+    return compile( _graph, {}, _flags, _opt_level );
+}
+
+const Code* Compiler::compile_batch(const Graph* _graph, const std::vector<std::string>& _inputs, CompilerFlags _flags, OptLevel _opt_level)
+{
+    return compile( _graph, _inputs, _flags, _opt_level );
+}
+
+const Code* Compiler::compile(const Graph* _graph, const std::vector<std::string>& _inputs, CompilerFlags _flags, OptLevel _opt_level)
+{
+    if (is_syntax_tree_valid(_graph))
+    {
+        // chunks can only be reused for the same graph, inputs, flags and level
+        if ( m_chunks_graph != _graph || m_chunks_inputs != _inputs || m_chunks_flags != _flags || m_chunks_opt_level != _opt_level )
+        {
+            clear_chunks();
+            m_chunks_graph     = _graph;
+            m_chunks_inputs    = _inputs;
+            m_chunks_flags     = _flags;
+            m_chunks_opt_level = _opt_level;
+        }
+
+        m_temp_code           = nullptr;
+        m_chunk               = nullptr;
+        m_stack_size          = 0;
+        m_stack_size_max      = 0;
+        m_opt_level           = _opt_level;
+        m_flags               = _flags;
+        m_emitted_chunk_count = 0;
+        m_reused_chunk_count  = 0;
+        ++m_generation;
+        m_variable_slot.clear();
+        m_variable_chunk.clear();
+        m_input_index.clear();
+        m_invokables.clear();
+        m_folding.clear();
+
+        try
+        {
+            // inputs are variables declared in the root scope, their index is their column's (cf. Interpreter::run_batch())
+            const Scope* root_scope = _graph->root()->internal_scope();
+            for ( u32_t i = 0; i < (u32_t)_inputs.size(); ++i )
+            {
+                auto found = std::find_if(root_scope->variable().begin(), root_scope->variable().end(),
+                                          [&](const VariableNode* each) { return each->get_identifier() == _inputs[i]; });
+                if ( found == root_scope->variable().end() )
+                {
+                    throw std::runtime_error("Input \"" + _inputs[i] + "\" is not a variable declared in the program's root scope");
+                }
+                if ( !m_input_index.emplace(*found, i).second )
+                {
+                    throw std::runtime_error("Input \"" + _inputs[i] + "\" is used twice");
+                }
+            }
+
+            const Chunk& root_chunk = compile_chunk( _graph->root()->internal_scope(), true); // "true" <== here is a hack, TODO: implement a real ReturnNode
+
+            // chunks of the scopes no longer in the graph are deleted
+            for ( auto it = m_chunks.begin(); it != m_chunks.end(); )
+            {
+                it = it->second.generation != m_generation ? m_chunks.erase(it) : std::next(it);
+            }
+
+            m_temp_code = new Code( _graph, _flags & CompilerFlag_DEBUG_INFO );
+            m_temp_code->set_inputs( _inputs );
+            link_chunk( root_chunk, m_temp_code );
+            m_temp_code->set_debug_node( nullptr );
+            m_temp_code->push_instr(OpCode_ret, "end of program"); // the Interpreter requires the code to end with a ret
+            Optimizer::optimize( m_temp_code, _opt_level );
+            if ( _opt_level >= OptLevel_O1 )
+            {
+                allocate_registers();
+            }
+            m_temp_code->set_stack_size( m_stack_size_max );
+            LOG_MESSAGE("Compiler", "Program compiled.\n");
+        }
+        catch ( const std::exception& e )
+        {
+            if ( m_chunk == nullptr ) // otherwise, the code belongs to the chunk being emitted
+            {
+                delete m_temp_code;
+            }
             m_temp_code = nullptr;
+            m_chunk     = nullptr;
+            clear_chunks(); // might be partially emitted
             LOG_ERROR("Compiler", "Unable to create_new assembly code for program. Reason: %s\n", e.what());
         }
         return m_temp_code;
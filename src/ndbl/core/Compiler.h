@@ -1,38 +1,182 @@
 #pragma once
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "tools/core/types.h"
 #include "Graph.h"
 #include "Code.h"
+#include "Optimizer.h"
 
 namespace ndbl
 {
     // forward declarations
     class IfNode;
     class ForLoopNode;
+    class FunctionNode;
     class WhileLoopNode;
     class InstructionNode;
     class Node;
     class Property;
     class Scope;
+    class VariableNode;
+
+    typedef int CompilerFlags;
+    enum CompilerFlag_
+    {
+        CompilerFlag_NONE       = 0,
+        CompilerFlag_DEBUG_INFO = 1 << 0, // Store a comment for each instruction (for disassembly/debugging), not required to run the code.
+        CompilerFlag_PARALLEL   = 1 << 1, // Compile the pure expressions calling independent functions to task graphs, to run these calls in parallel (cf. Dataflow).
+#ifdef NDBL_DEBUG
+        CompilerFlag_DEFAULT    = CompilerFlag_DEBUG_INFO,
+#else
+        CompilerFlag_DEFAULT    = CompilerFlag_NONE,
+#endif
+    };
 
     /**
      * @class Class to compile a syntax tree (Graph) to a simple instruction list (Assembly::Code)
+     * The code of each scope is emitted in a separate chunk, kept from a compilation to the next one. A chunk is emitted again
+     * only when its scope changed (cf. get_fingerprint()), chunks are then linked to a single Code.
      */
     class Compiler
     {
     public:
         Compiler()= default;
-        const Code* compile_syntax_tree(const Graph *_graph);        // Compile the full syntax tree (a.k.a. graph) and return dynamically allocated code that VirtualMachine can load.
+        const Code* compile_syntax_tree(const Graph *_graph, CompilerFlags = CompilerFlag_DEFAULT, OptLevel = OptLevel_DEFAULT); // Compile the full syntax tree (a.k.a. graph), optimize it, and return dynamically allocated code that VirtualMachine can load.
+        const Code* compile_batch(const Graph*, const std::vector<std::string>& _inputs, CompilerFlags = CompilerFlag_DEFAULT, OptLevel = OptLevel_DEFAULT); // Same as compile_syntax_tree(), the given variables (declared in the root scope) are initialized from the row being run instead (cf. Interpreter::run_batch()).
+        void        clear_chunks();                                               // Clear the chunks kept from the previous compilation, the next one emits all the scopes.
+        size_t      get_emitted_chunk_count() const { return m_emitted_chunk_count; } // Get the number of chunks emitted by the last compilation.
+        size_t      get_reused_chunk_count() const { return m_reused_chunk_count; }   // Get the number of chunks reused by the last compilation (their scope did not change).
+        typedef std::unordered_map<const FunctionNode*, const tools::IInvokable*> Invokables; // Implementation found for each function call of a syntax tree (cf. find_invokable()), valid while the tree does not change.
+        static tools::variant               get_constant_value(const Property*);        // Get the value of a Property's token (or its type's default value when token is not a literal).
+        static const tools::IInvokable*     find_invokable(const FunctionNode*, Invokables* _memo = nullptr);  // Find the implementation of a given function, exact match for the argument types known at compile time first, fallback otherwise. Memoized when a memo is given (otherwise its arguments are resolved again, recursively).
+        static const tools::TypeDescriptor* get_expression_type(const Slot*, Invokables* _memo = nullptr);     // Get the type of the value an input pushes on the stack once compiled, nullptr when unknown (memoized as find_invokable()).
+        static bool                         is_empty_condition(const Slot*);            // Check if a given condition is empty (always true), ex: "for(;;)" connects an empty instruction to it.
     private:
+        static constexpr size_t NO_BRANCH = ~size_t(0); // cf. compile_instruction_as_condition()
+
+        // Stack slot of a variable, and its type when the slot was accessed
+        struct VariableSlot
+        {
+            const VariableNode*          variable;
+            u32_t                        index;
+            const tools::TypeDescriptor* type;
+        };
+
+        // Result of a function call evaluated at compile time (cf. evaluate_function_call())
+        struct Folding
+        {
+            bool           is_folded = false;
+            tools::variant value;
+        };
+
+        // Stack slot of a loop-invariant expression, computed once before its loop (cf. compile_loop_invariants())
+        struct InvariantSlot
+        {
+            const FunctionNode* node;
+            u32_t               index;
+        };
+
+        // Scopes of a loop being compiled, and the variables they declare or write (their value may change from an iteration to the next)
+        struct Loop
+        {
+            std::set<Scope*>                        scopes;
+            std::unordered_set<const VariableNode*> variant;
+        };
+
+        // Nested chunk, its placeholder in the parent chunk is the nested scope's push_stack_frame
+        struct NestedChunk
+        {
+            size_t       index;       // placeholder's index in the parent chunk
+            const Scope* scope;
+            size_t       stack_size;  // stack size when the nested scope begins
+        };
+
+        // Relocatable code emitted for a single scope: jumps are relative and never leave the chunk, constant indexes are local.
+        struct Chunk
+        {
+            u64_t                     fingerprint    = 0;     // scope's fingerprint when emitted (cf. get_fingerprint())
+            size_t                    stack_base     = 0;     // stack size when the scope begins (variable slots are absolute)
+            size_t                    stack_size_max = 0;     // maximum stack size reached (nested chunks included)
+            bool                      fake_return    = false;
+            size_t                    linked_size    = 0;     // instruction count once linked (nested chunks included)
+            u32_t                     generation     = 0;     // last compilation using this chunk
+            std::unique_ptr<Code>     code;                   // instructions, local constants and debug info
+            std::vector<NestedChunk>  nested;                 // sorted by index
+            std::vector<VariableSlot> declared;               // variables declared by this chunk
+            std::vector<VariableSlot> external;               // variables declared by another chunk, accessed by this one
+            std::vector<InvariantSlot> hoisted;               // loop-invariant expressions computed by this chunk
+            std::vector<InvariantSlot> invariant;             // loop-invariant expressions computed by another chunk, loaded by this one
+        };
+
+        const Code* compile(const Graph*, const std::vector<std::string>& _inputs, CompilerFlags, OptLevel); // Common part of compile_syntax_tree() and compile_batch().
         bool is_syntax_tree_valid(const Graph*);                                  // Check if syntax tree has a valid syntax (declared variables and functions).
-        void compile_node( const Node*);                                          // Compile a node recursively, result depends on node type.
-        void compile_input_slot(const Slot*);                                     // Compile from a Slot recursively (slot must be an OUTPUT).
-        void compile_output_slot(const Slot*);                                    // Compile from a Slot recursively (slot must be an INPUT).
-        void compile_inner_scope(const Node*, bool _insert_fake_return = false);  // Compile a scope recursively, optionally insert a fake return statement (lack of return" keyword").
-        void compile_instruction_as_condition(const Node* );                      // Compile an instruction as a condition (stores result in a register)
+        void compile_node( const Node*);                                          // Compile a node as a statement, result depends on node type (value is stored in rax).
+        void compile_input_slot(const Slot*, bool _by_ref = false);               // Compile from a Slot recursively (slot must be an INPUT), its value (or reference) is pushed on the stack.
+        void compile_output_slot(const Slot*, bool _by_ref = false);              // Compile from a Slot recursively (slot must be an OUTPUT), its value (or reference) is pushed on the stack.
+        void compile_constant(const Property*);                                   // Compile a Property's token as a constant pushed on the stack.
+        void compile_constant(const tools::variant&, std::string_view _comment);  // Compile a value as a constant pushed on the stack.
+        bool evaluate_input_slot(const Slot*, tools::variant& _out) const;        // Try to evaluate an input at compile time (literals and pure functions only), returns false when it depends on a runtime value.
+        bool evaluate_function_call(const FunctionNode*, tools::variant& _out) const; // Try to evaluate a pure function call at compile time (cf. FunctionFlag_PURE), returns false if not possible. Memoized (cf. m_folding).
+        bool fold_function_call(const FunctionNode*, tools::variant& _out) const;     // Implementation of evaluate_function_call(), not memoized.
+        const VariableNode* get_assigned_variable(const FunctionNode*, const tools::IInvokable*) const; // Get the variable a given assignment operator can store to directly (ex: "a = 42"), nullptr otherwise.
+        OpCode get_typed_operator(const FunctionNode*, const tools::IInvokable*) const; // Get the typed opcode to compile a given operator with (ex: OpCode_add_i32), OpCode_call when operand types don't allow it.
+        bool   can_call_native(const FunctionNode*, const tools::IInvokable*) const;     // Check if a given call can use its invokable's native call (cf. OpCode_call_native): its arguments must have the exact types.
+        void compile_function_call(const FunctionNode*);                          // Compile a function's arguments and its call, its result (if not void) is pushed on the stack.
+        bool compile_dataflow(const FunctionNode*);                               // Try to compile a pure expression to a Dataflow (inputs are pushed, then OpCode_dataflow), returns false when it has nothing to run in parallel.
+        bool build_dataflow_task(const FunctionNode*, Dataflow&, std::vector<const VariableNode*>& _inputs, u32_t& _task) const; // Add the task of a given pure function call (and its dependencies) to a given Dataflow, returns false if one is not pure.
+        void compile_statement_slot(const Slot*);                                 // Compile from a Slot recursively (slot must be an INPUT) as a statement, its value (if any) is stored in rax.
+        void compile_variable_decl(const VariableNode*);                          // Compile a variable's initialization (if any).
+        void compile_variable_access(const VariableNode*, bool _by_ref);          // Compile a variable read, its value (or reference) is pushed on the stack.
+        void compile_scope(const Scope*, bool _insert_fake_return = false);       // Compile a scope recursively, optionally insert a fake return statement (lack of return" keyword"). Its chunk is nested in the current one.
+        Chunk& compile_chunk(const Scope*, bool _insert_fake_return);             // Emit the chunk of a given scope, or reuse the previous one when still valid (nested chunks are compiled the same way).
+        void emit_chunk(const Scope*, bool _insert_fake_return);                  // Emit the instructions of a given scope to the current chunk (nested scopes are placeholders).
+        bool is_chunk_valid(const Chunk&, bool _insert_fake_return, u64_t _fingerprint) const; // Check if a chunk emitted previously can be reused (same fingerprint, stack base, and external variable slots).
+        void link_chunk(const Chunk&, Code* _out) const;                          // Append a chunk to a given code recursively, jumps and constant indexes are relocated.
+        u64_t get_fingerprint(const Scope*) const;                                // Hash the nodes compiled in a given scope's chunk (nested scopes excluded).
+        u64_t get_statement_fingerprint(u64_t _hash, const Node*) const;          // Combine a given hash with a given statement's nodes (itself, and its inputs recursively).
+        u32_t get_variable_slot(const VariableNode*);                             // Get the slot of a given variable, track it as an external variable of the current chunk when declared by another one.
+        void compile_scope_begin(const Scope*);                                   // Push a new stack frame and the scope's variables.
+        void compile_scope_end(const Scope*);                                     // Pop the scope's variables and its stack frame.
+        size_t compile_instruction_as_condition(const Slot*, const char* _comment); // Compile an instruction as a condition followed by a jump taken when false (result is stored in rax), returns the jump's index (target must be set by the caller, cf. set_condition_target()). An empty condition is always true, nothing is compiled and NO_BRANCH is returned.
+        void set_condition_target(size_t _branch_index, size_t _target);           // Set the target of a jump returned by compile_instruction_as_condition() (does nothing for NO_BRANCH).
+        std::vector<const FunctionNode*> compile_loop_invariants(const Node* _loop, const Slot* _condition, const Slot* _iteration); // From O2, compute the loop-invariant expressions of a given loop once (before its condition), their values stay on the stack until compile_loop_invariants_end().
+        void compile_loop_invariants_end(const std::vector<const FunctionNode*>&); // Pop the values of the given loop-invariant expressions.
+        void find_variant_variables(const Node*, Loop&) const;                   // Add the variables a given node (and its inputs recursively) writes to the loop's variant variables.
+        void find_loop_invariants(const Node*, const Loop&, std::vector<const FunctionNode*>& _out) const; // Find the largest loop-invariant expressions in a given node (and its inputs recursively).
+        bool is_loop_invariant(const Slot*, const Loop&) const;                  // Check if an input (slot must be an INPUT) has the same value at each iteration of a given loop.
+        bool is_loop_invariant_call(const FunctionNode*, const Loop&) const;     // Check if a function call has the same result at each iteration of a given loop (pure, invariant arguments), and can be computed even when the loop does not run.
+        u32_t get_invariant_slot(const FunctionNode*);                           // Get the slot of a given loop-invariant expression, track it as an invariant of the current chunk when computed by another one.
         void compile_for_loop(const ForLoopNode*);                                // Compile a "for loop" recursively (initial, condition, iterative instructions and inner scope).
         void compile_while_loop(const WhileLoopNode*);                            // Compile a "while loop" recursively (initial, condition, iterative instructions and inner scope).
         void compile_conditional_struct(const IfNode*);                           // Compile an "if/else" recursively.
+        void allocate_registers();                                                // Linear-scan allocation of the general purpose registers to the scalar variables (bool, i32, double) not passed by reference, the others stay in their stack slot.
+        void stack_push(size_t _count = 1);                                       // Track a push on the stack (to compute its maximum size).
+        void stack_pop(size_t _count = 1);                                        // Track a pop on the stack.
 
-        Code* m_temp_code;  // Store the code being compiled, is released when compilation ends.
+        Code* m_temp_code;                                                       // Store the code being compiled (the current chunk's code while emitting), is released when compilation ends.
+        Chunk* m_chunk          = nullptr;                                       // Chunk being emitted.
+        size_t m_stack_size     = 0;                                             // Stack slot count at the current instruction (known at compile time since Nodlang has no recursion).
+        size_t m_stack_size_max = 0;                                             // Maximum stack slot count for the code being compiled.
+        OptLevel m_opt_level    = OptLevel_DEFAULT;                              // Optimization level of the code being compiled (constants are folded from O1).
+        CompilerFlags m_flags   = CompilerFlag_NONE;                             // Flags of the code being compiled.
+        std::unordered_map<const VariableNode*, u32_t> m_variable_slot;          // Absolute stack slot index for each variable.
+        std::unordered_map<const VariableNode*, const Chunk*> m_variable_chunk;  // Chunk declaring each variable.
+        std::unordered_map<const FunctionNode*, u32_t> m_invariant_slot;         // Absolute stack slot index for each loop-invariant expression of the loops being compiled.
+        std::unordered_map<const FunctionNode*, const Chunk*> m_invariant_chunk; // Chunk computing each loop-invariant expression.
+        std::unordered_map<const VariableNode*, u32_t> m_input_index;            // Column index of each input variable (cf. compile_batch()).
+        mutable Invokables m_invokables;                                         // Implementation of each function call of the current compilation (cf. find_invokable()).
+        mutable std::unordered_map<const FunctionNode*, Folding> m_folding;      // Each function call evaluated at compile time by the current compilation (a parent evaluates its arguments again).
+        std::unordered_map<const Scope*, Chunk> m_chunks;                        // Chunk of each scope, kept between compilations.
+        const Graph*  m_chunks_graph        = nullptr;                           // Graph, inputs, flags and level the chunks were compiled for (chunks are cleared when one changes).
+        std::vector<std::string> m_chunks_inputs;
+        CompilerFlags m_chunks_flags        = CompilerFlag_NONE;
+        OptLevel      m_chunks_opt_level    = OptLevel_DEFAULT;
+        u32_t         m_generation          = 0;                                 // Incremented by each compilation.
+        size_t        m_emitted_chunk_count = 0;
+        size_t        m_reused_chunk_count  = 0;
     };
 } // namespace ndbl
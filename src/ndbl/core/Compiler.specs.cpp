@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "fixtures/core.h"
+#include "ndbl/core/Compiler.h"
+
+using namespace ndbl;
+typedef ::testing::Core Compiler_;
+
+static const char* PROGRAM = "int sum = 0; for(int i = 0; i < 4; i = i + 1){ sum = sum + 5; } if(sum > 10){ sum = sum * 2; } return(sum);";
+
+TEST_F(Compiler_, recompile_unchanged_graph_reuses_all_chunks)
+{
+    Graph*      graph = app.parse(PROGRAM);
+    Compiler    compiler;
+    const Code* first = compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    const size_t chunk_count = compiler.get_emitted_chunk_count();
+    EXPECT_EQ(compiler.get_reused_chunk_count(), 0);
+
+    const Code* second = compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    EXPECT_EQ(compiler.get_emitted_chunk_count(), 0);
+    EXPECT_EQ(compiler.get_reused_chunk_count(), chunk_count);
+
+    // must be identical to a code compiled from scratch
+    Compiler    other_compiler;
+    const Code* expected = other_compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    EXPECT_EQ(Code::to_string(second), Code::to_string(expected));
+    EXPECT_EQ(Code::to_string(first), Code::to_string(expected));
+
+    delete first;
+    delete second;
+    delete expected;
+}
+
+TEST_F(Compiler_, recompile_only_the_changed_scope)
+{
+    Graph*    graph = app.parse(PROGRAM);
+    Compiler  compiler;
+    delete compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    const size_t chunk_count = compiler.get_emitted_chunk_count();
+
+    Node* multiply = find_node(graph, "*"); // in the "if" body
+    ASSERT_NE(multiply, nullptr);
+    multiply->get_prop(RIGHT_VALUE_PROPERTY)->set_token({Token_t::literal_int, "3"}); // sum * 3
+
+    const Code* code = compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    EXPECT_EQ(compiler.get_emitted_chunk_count(), 1);
+    EXPECT_EQ(compiler.get_reused_chunk_count(), chunk_count - 1);
+
+    Compiler    other_compiler;
+    const Code* expected = other_compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    EXPECT_EQ(Code::to_string(code), Code::to_string(expected));
+
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 60);
+    app.release_program();
+
+    delete code;
+    delete expected;
+}
+
+TEST_F(Compiler_, recompile_with_other_options_emits_all_chunks)
+{
+    Graph*    graph = app.parse(PROGRAM);
+    Compiler  compiler;
+    delete compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O1);
+    const size_t chunk_count = compiler.get_emitted_chunk_count();
+
+    delete compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O0);
+    EXPECT_EQ(compiler.get_emitted_chunk_count(), chunk_count);
+    EXPECT_EQ(compiler.get_reused_chunk_count(), 0);
+}
+
+TEST_F(Compiler_, recompile_a_loop_whose_invariant_changed)
+{
+    Graph*    graph = app.parse("int a = 2; int sum = 0; for(int i = 0; i < 4; i = i + 1){ sum = sum + a * 3; } return(sum);");
+    Compiler  compiler;
+    delete compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O2);
+
+    Node* multiply = find_node(graph, "*"); // hoisted out of the loop
+    ASSERT_NE(multiply, nullptr);
+    multiply->get_prop(RIGHT_VALUE_PROPERTY)->set_token({Token_t::literal_int, "5"}); // a * 5
+
+    // the loop's chunk computes the invariant, it must be emitted again with the loop body's
+    const Code* code = compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O2);
+    Compiler    other_compiler;
+    const Code* expected = other_compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O2);
+    EXPECT_EQ(Code::to_string(code), Code::to_string(expected));
+
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 40);
+    app.release_program();
+
+    delete code;
+    delete expected;
+}
+
+TEST_F(Compiler_, stack_frames_reserve_a_slot_per_variable)
+{
+    Graph*      graph = app.parse(PROGRAM);
+    Compiler    compiler;
+    const Code* code  = compiler.compile_syntax_tree(graph, CompilerFlag_DEFAULT, OptLevel_O0);
+
+    // each variable's slot is inside the block reserved by the last frame pushed
+    size_t frame_base = 0;
+    size_t frame_size = 0;
+    size_t var_count  = 0;
+    for ( size_t i = 0; i < code->size(); ++i )
+    {
+        const Instruction* instr = code->get_instruction_at(i);
+        if ( instr->opcode == OpCode_push_stack_frame )
+        {
+            EXPECT_EQ(instr->push.size, instr->push.scope->variable().size());
+            frame_size = instr->push.size;
+            frame_base = i + 1 < code->size() && code->get_instruction_at(i + 1)->opcode == OpCode_push_var
+                       ? code->get_instruction_at(i + 1)->push.index
+                       : 0;
+        }
+        else if ( instr->opcode == OpCode_push_var )
+        {
+            EXPECT_GE(instr->push.index, frame_base);
+            EXPECT_LT(instr->push.index, frame_base + frame_size);
+            ++var_count;
+        }
+    }
+    EXPECT_EQ(var_count, 2); // sum and i
+
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 40);
+    app.release_program();
+    delete code;
+}
@@ -0,0 +1,214 @@
+#include "Dataflow.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include "tools/core/ThreadPool.h"
+#include "tools/core/assertions.h"
+#include "tools/core/reflection/Invokable.h"
+
+using namespace ndbl;
+using namespace tools;
+
+namespace
+{
+    // State shared by the threads running a single Dataflow
+    struct Run
+    {
+        Run(const Dataflow& _dataflow, const std::vector<variant>& _constants, const variant* _inputs)
+        : dataflow(_dataflow)
+        , constants(_constants)
+        , inputs(_inputs)
+        {}
+
+        const Dataflow&                       dataflow;
+        const std::vector<variant>&           constants;
+        const variant*                        inputs;
+        std::vector<variant>                  results;          // one per task, each written by a single thread
+        std::unique_ptr<std::atomic<u32_t>[]> pending;          // remaining dependency count of each task
+        std::atomic<bool>                     has_error{false};
+        std::exception_ptr                    error;            // first error thrown by a task (protected by mutex)
+        bool                                  is_done = false;  // root task is done (protected by mutex)
+        std::mutex                            mutex;
+        std::condition_variable               condition;
+    };
+
+    // Run a given task, then its parent when it was its last dependency (and so on, up to the root)
+    void execute(Run& _run, u32_t _index)
+    {
+        for(;;)
+        {
+            const Dataflow::Task& task = _run.dataflow.get_task(_index);
+
+            if ( !_run.has_error ) // the tasks after an error are skipped, the root must be reached anyway
+            {
+                try
+                {
+                    // arguments are converted as the Interpreter would do (cf. OpCode_call)
+                    const FunctionDescriptor* sig = task.invokable->get_sig();
+                    std::vector<variant>      args(task.args.size());
+                    std::vector<variant*>     args_ptr(task.args.size());
+                    for ( size_t i = 0; i < task.args.size(); ++i )
+                    {
+                        const Dataflow::Operand& operand = task.args[i];
+                        switch ( operand.type )
+                        {
+                            case Dataflow::OperandType_INPUT:    args[i] = _run.inputs[operand.index];     break;
+                            case Dataflow::OperandType_CONSTANT: args[i] = _run.constants[operand.index];  break;
+                            case Dataflow::OperandType_TASK:     args[i] = _run.results[operand.index];    break;
+                        }
+                        args[i].convert(sig->arg_at(i).type);
+                        args_ptr[i] = &args[i];
+                    }
+                    _run.results[_index] = task.invokable->invoke(args_ptr);
+                }
+                catch ( ... )
+                {
+                    std::lock_guard<std::mutex> lock(_run.mutex);
+                    if ( !_run.error )
+                    {
+                        _run.error = std::current_exception();
+                    }
+                    _run.has_error = true;
+                }
+            }
+
+            if ( task.parent == Dataflow::NO_PARENT )
+            {
+                std::lock_guard<std::mutex> lock(_run.mutex);
+                _run.is_done = true;
+                _run.condition.notify_all();
+                return;
+            }
+
+            if ( _run.pending[task.parent].fetch_sub(1) != 1 )
+            {
+                return; // another dependency is still running, its thread will run the parent
+            }
+            _index = task.parent;
+        }
+    }
+}
+
+u32_t Dataflow::push_constant(const variant& _value)
+{
+    m_constants.push_back(_value);
+    return (u32_t)m_constants.size() - 1;
+}
+
+u32_t Dataflow::push_task(const IInvokable* _invokable, std::vector<Operand>&& _args, bool _is_expensive)
+{
+    const u32_t index = (u32_t)m_tasks.size();
+    u32_t dependency_count = 0;
+    for ( const Operand& each : _args )
+    {
+        if ( each.type == OperandType_TASK )
+        {
+            VERIFY(each.index < index && m_tasks[each.index].parent == NO_PARENT, "A task must be used once, after it was pushed");
+            m_tasks[each.index].parent = index;
+            ++dependency_count;
+        }
+    }
+    m_tasks.push_back({ _invokable, std::move(_args), NO_PARENT, dependency_count, _is_expensive });
+    return index;
+}
+
+size_t Dataflow::get_width() const
+{
+    // a task is always after its dependencies, so each width is known before its parent's
+    std::vector<size_t> children_width(m_tasks.size(), 0);
+    size_t width = 0;
+    for ( size_t i = 0; i < m_tasks.size(); ++i )
+    {
+        width = std::max<size_t>(children_width[i], m_tasks[i].is_expensive ? 1 : 0);
+        if ( m_tasks[i].parent != NO_PARENT )
+        {
+            children_width[m_tasks[i].parent] += width;
+        }
+    }
+    return width; // root's
+}
+
+size_t Dataflow::get_memory_usage() const
+{
+    size_t usage = sizeof(Dataflow)
+                 + m_tasks.capacity()     * sizeof(Task)
+                 + m_constants.capacity() * sizeof(variant);
+    for ( const Task& each : m_tasks )
+    {
+        usage += each.args.capacity() * sizeof(Operand);
+    }
+    return usage;
+}
+
+variant Dataflow::run(const variant* _inputs, ThreadPool* _pool) const
+{
+    ASSERT(!m_tasks.empty());
+
+    Run state( *this, m_constants, _inputs );
+    state.results.resize(m_tasks.size());
+    state.pending = std::make_unique<std::atomic<u32_t>[]>(m_tasks.size());
+
+    // tasks without dependency can start now, the expensive ones are sent to the pool (except one, kept for this thread)
+    std::vector<u32_t> cheap;
+    std::vector<u32_t> expensive;
+    for ( u32_t i = 0; i < (u32_t)m_tasks.size(); ++i )
+    {
+        state.pending[i].store(m_tasks[i].dependency_count);
+        if ( m_tasks[i].dependency_count == 0 )
+        {
+            ( _pool != nullptr && m_tasks[i].is_expensive ? expensive : cheap ).push_back(i);
+        }
+    }
+
+    for ( size_t i = 1; i < expensive.size(); ++i )
+    {
+        _pool->run([&state, index = expensive[i]]() { execute(state, index); });
+    }
+    for ( u32_t each : cheap )
+    {
+        execute(state, each);
+    }
+    if ( !expensive.empty() )
+    {
+        execute(state, expensive[0]);
+    }
+
+    // results are joined by the last dependency's thread, wait for the root
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.condition.wait(lock, [&state]() { return state.is_done; });
+    }
+
+    if ( state.error )
+    {
+        std::rethrow_exception(state.error);
+    }
+    return std::move(state.results.back());
+}
+
+std::string Dataflow::to_string() const
+{
+    std::string result;
+    for ( size_t i = 0; i < m_tasks.size(); ++i )
+    {
+        const Task& task = m_tasks[i];
+        result.append("  task[" + std::to_string(i) + "] " + task.invokable->get_sig()->get_identifier() + "(");
+        for ( size_t j = 0; j < task.args.size(); ++j )
+        {
+            const Operand& operand = task.args[j];
+            if ( j != 0 ) result.append(", ");
+            switch ( operand.type )
+            {
+                case OperandType_INPUT:    result.append("input[" + std::to_string(operand.index) + "]"); break;
+                case OperandType_CONSTANT: result.append(m_constants[operand.index].to<std::string>()); break;
+                case OperandType_TASK:     result.append("task[" + std::to_string(operand.index) + "]"); break;
+            }
+        }
+        result.append(")\n");
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "tools/core/types.h"
+#include "tools/core/reflection/variant.h"
+
+namespace tools
+{
+    // forward declarations
+    class IInvokable;
+    class ThreadPool;
+}
+
+namespace ndbl
+{
+    /**
+     * @class Pure expression tree, compiled to a task graph whose independent calls can run in parallel (cf. CompilerFlag_PARALLEL).
+     * Each task is a single function (or operator) call, its arguments are inputs (values popped from the stack by OpCode_dataflow),
+     * constants, or the result of another task. The tree has no side effect (only pure functions, cf. FunctionFlag_PURE),
+     * so its tasks can run in any order respecting their dependencies.
+     */
+    class Dataflow
+    {
+    public:
+        // Argument of a task
+        typedef u8_t OperandType;
+        enum OperandType_ : u8_t
+        {
+            OperandType_INPUT,    // value popped from the stack
+            OperandType_CONSTANT, // value known at compile time
+            OperandType_TASK,     // result of another task
+        };
+
+        struct Operand
+        {
+            OperandType type;
+            u32_t       index;   // index in the inputs, the constants, or the tasks (depending on type).
+        };
+
+        struct Task
+        {
+            const tools::IInvokable* invokable;
+            std::vector<Operand>     args;
+            u32_t                    parent;             // task using this result, or NO_PARENT for the root.
+            u32_t                    dependency_count;   // number of arguments of type OperandType_TASK.
+            bool                     is_expensive;       // a function call (not an operator), worth running in another thread.
+        };
+
+        static constexpr u32_t NO_PARENT = (u32_t)-1;
+
+        u32_t                   push_input() { return m_input_count++; }                          // Add an input, returns its index.
+        u32_t                   push_constant(const tools::variant&);                             // Add a constant, returns its index.
+        u32_t                   push_task(const tools::IInvokable*, std::vector<Operand>&&, bool _is_expensive); // Add a task (its task operands must be pushed before), returns its index.
+        size_t                  get_input_count() const { return m_input_count; }
+        size_t                  get_task_count() const { return m_tasks.size(); }
+        const Task&             get_task(size_t _index) const { return m_tasks[_index]; }
+        const std::vector<tools::variant>& get_constants() const { return m_constants; }
+        size_t                  get_width() const;                                                // Get the maximum number of expensive tasks able to run at the same time.
+        size_t                  get_memory_usage() const;                                         // Get an estimation of the memory used (in bytes).
+        tools::variant          run(const tools::variant* _inputs, tools::ThreadPool*) const;     // Run the tasks (in parallel when a pool is given) and return the root's result. Throws the first error of a task.
+        std::string             to_string() const;
+    private:
+        std::vector<Task>           m_tasks;        // a task is always after its dependencies, the last one is the root.
+        std::vector<tools::variant> m_constants;
+        u32_t                       m_input_count = 0;
+    };
+} // namespace ndbl
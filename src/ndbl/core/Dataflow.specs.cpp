@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include "fixtures/core.h"
+#include "ndbl/core/Dataflow.h"
+#include "tools/core/ThreadPool.h"
+
+using namespace ndbl;
+using namespace tools;
+typedef ::testing::Core Dataflow_;
+
+static std::mutex                  g_thread_ids_mutex;
+static std::set<std::thread::id>   g_thread_ids; // threads having called slow_identity()
+
+// Take some time to return its argument, record the calling thread
+static double slow_identity(double _value)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_thread_ids_mutex);
+        g_thread_ids.insert(std::this_thread::get_id());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return _value;
+}
+
+static double add(double _left, double _right) { return _left + _right; }
+
+static double fail(double) { throw std::runtime_error("fail"); }
+
+// Build "add(slow_identity(input[0]), slow_identity(2.0))"
+static Dataflow make_dataflow(const IInvokable* _slow_identity, const IInvokable* _add)
+{
+    Dataflow dataflow;
+    const u32_t input = dataflow.push_input();
+    const u32_t left  = dataflow.push_task(_slow_identity, {{Dataflow::OperandType_INPUT, input}}, true);
+    const u32_t right = dataflow.push_task(_slow_identity, {{Dataflow::OperandType_CONSTANT, dataflow.push_constant(2.0)}}, true);
+    dataflow.push_task(_add, {{Dataflow::OperandType_TASK, left}, {Dataflow::OperandType_TASK, right}}, false);
+    return dataflow;
+}
+
+TEST_F(Dataflow_, runs_independent_tasks_in_parallel)
+{
+    InvokableStaticFunction<double(double)>         slow_identity_fct("slow_identity", &slow_identity);
+    InvokableStaticFunction<double(double, double)> add_fct("add", &add);
+    const Dataflow dataflow = make_dataflow(&slow_identity_fct, &add_fct);
+    const variant  input    = 40.0;
+    EXPECT_EQ(dataflow.get_width(), 2);
+
+    ThreadPool pool(2);
+    g_thread_ids.clear();
+    EXPECT_EQ((double)dataflow.run(&input, &pool), 42.0);
+    EXPECT_EQ(g_thread_ids.size(), 2);
+
+    // sequential without a pool
+    g_thread_ids.clear();
+    EXPECT_EQ((double)dataflow.run(&input, nullptr), 42.0);
+    EXPECT_EQ(g_thread_ids.size(), 1);
+}
+
+TEST_F(Dataflow_, throws_the_error_of_a_task)
+{
+    InvokableStaticFunction<double(double)>         fail_fct("fail", &fail);
+    InvokableStaticFunction<double(double, double)> add_fct("add", &add);
+    const Dataflow dataflow = make_dataflow(&fail_fct, &add_fct);
+    const variant  input    = 40.0;
+
+    ThreadPool pool(2);
+    EXPECT_THROW(dataflow.run(&input, &pool), std::runtime_error);
+}
+
+TEST_F(Dataflow_, parallel_flag_compiles_independent_calls_to_a_dataflow)
+{
+    const char* program = "double a = 0.5; double b = 2.0; double r = sin(a) + cos(b) * sqrt(a); return(r);";
+    const Code* code    = app.compile(app.parse(program), CompilerFlag_PARALLEL, OptLevel_O1);
+
+    ASSERT_EQ(count_opcode(code, OpCode_dataflow), 1);
+    EXPECT_EQ(count_opcode(code, OpCode_call, OpCode_call_native), 1); // return
+    EXPECT_EQ(code->get_dataflow(0).get_input_count(), 2);
+    EXPECT_EQ(code->get_dataflow(0).get_width(), 3);
+
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_DOUBLE_EQ(app.get_last_result_as<double>(), std::sin(0.5) + std::cos(2.0) * std::sqrt(0.5));
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Dataflow_, parallel_flag_ignores_expressions_without_independent_calls)
+{
+    const Code* code = app.compile(app.parse("double a = 0.5; double r = sin(cos(a)) + a; return(r);"), CompilerFlag_PARALLEL, OptLevel_O1);
+    EXPECT_EQ(count_opcode(code, OpCode_dataflow), 0);
+    delete code;
+}
+
+TEST_F(Dataflow_, parallel_flag_does_not_change_the_statement_order)
+{
+    const char* program = "double a = 0.5; double r = sin(a) + cos(a); a = 2.0; r = r + sin(a) + cos(a); return(r);";
+    const Code* code    = app.compile(app.parse(program), CompilerFlag_PARALLEL, OptLevel_O1);
+
+    EXPECT_EQ(count_opcode(code, OpCode_dataflow), 2);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_DOUBLE_EQ(app.get_last_result_as<double>(), std::sin(0.5) + std::cos(0.5) + std::sin(2.0) + std::cos(2.0));
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Dataflow_, interpreters_share_a_thread_pool_unless_one_is_set)
+{
+    Interpreter other;
+    EXPECT_EQ(app.get_interpreter()->get_thread_pool(), &Interpreter::get_shared_thread_pool());
+    EXPECT_EQ(other.get_thread_pool(), &Interpreter::get_shared_thread_pool());
+
+    ThreadPool pool(2);
+    app.get_interpreter()->set_thread_pool(&pool);
+    EXPECT_EQ(app.get_interpreter()->get_thread_pool(), &pool);
+
+    const Code* code = app.compile(app.parse("double a = 0.5; double b = 2.0; double r = sin(a) + cos(b); return(r);"), CompilerFlag_PARALLEL, OptLevel_O1);
+    ASSERT_EQ(count_opcode(code, OpCode_dataflow), 1);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_DOUBLE_EQ(app.get_last_result_as<double>(), std::sin(0.5) + std::cos(2.0));
+    app.release_program();
+    app.get_interpreter()->set_thread_pool(nullptr);
+    delete code;
+}
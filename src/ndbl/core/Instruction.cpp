@@ -7,13 +7,43 @@
 using namespace ndbl;
 using namespace tools;
 
-std::string Instruction::to_string(const Instruction& _instr)
+bool Instruction::is_jump() const
+{
+    switch ( opcode )
+    {
+        case OpCode_jmp:
+        case OpCode_jne:
+        case OpCode_pop_jne:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Instruction::is_operator() const
+{
+    return opcode >= OpCode_add_i32 && opcode <= OpCode_ne_bool;
+}
+
+i64_t Instruction::get_jump_offset() const
+{
+    ASSERT( is_jump() );
+    return jmp.offset;
+}
+
+void Instruction::set_jump_offset(i64_t _offset)
+{
+    ASSERT( is_jump() );
+    jmp.offset = _offset;
+}
+
+std::string Instruction::to_string(const Instruction& _instr, size_t _line, const char* _comment)
 {
     std::string result;
     result.reserve(80); // to fit with terminals
 
     // append "<line> :"
-    std::string str = format::hexadecimal(_instr.line);
+    std::string str = format::hexadecimal(_line);
     result.append( str );
     result.resize(4, ' ');
     result.append( " : " );
@@ -27,6 +57,7 @@ std::string Instruction::to_string(const Instruction& _instr)
     switch ( _instr.opcode )
     {
         case OpCode_call:
+        case OpCode_call_native:
         {
             get_language()->serialize_invokable_sig( result, _instr.call.invokable );
             break;
@@ -35,14 +66,12 @@ std::string Instruction::to_string(const Instruction& _instr)
         case OpCode_deref_qword:
         {
             result.append(format::address( _instr.uref.ptr ));
-            result.append(", *");
-            result.append(_instr.uref.type->name() );
             break;
         }
 
         case OpCode_mov:
         {
-            result.append(Register_to_string(_instr.mov.dst.u8));
+            result.append(Register_to_string(_instr.mov.dst));
             result.append(", ");
             result.append(qword::to_string(_instr.mov.src ));
             break;
@@ -50,12 +79,13 @@ std::string Instruction::to_string(const Instruction& _instr)
 
         case OpCode_cmp:
         {
-            result.append(qword::to_string(_instr.cmp.left ));
+            result.append(Register_to_string(_instr.cmp.left ));
             result.append(", ");
-            result.append(qword::to_string(_instr.cmp.right ));
+            result.append(Register_to_string(_instr.cmp.right ));
             break;
         }
 
+        case OpCode_pop_jne:
         case OpCode_jne:
         case OpCode_jmp:
         {
@@ -68,24 +98,59 @@ std::string Instruction::to_string(const Instruction& _instr)
         case OpCode_pop_stack_frame:
             result.append(format::address(_instr.pop.scope) );
             break;
-        case OpCode_pop_var:
-            result.append(format::address(_instr.push.var) );
-            break;
         case OpCode_push_stack_frame:
             result.append(format::address(_instr.push.scope) );
+            result.append(", ");
+            result.append(std::to_string(_instr.push.size) );
             break;
         case OpCode_push_var:
-            result.append(format::address(_instr.push.var) );
+            result.append(_instr.push.type->name() );
+            if ( _instr.push.reg != Register_undefined )
+            {
+                result.append(", ");
+                result.append(Register_to_string(_instr.push.reg) );
+            }
+            break;
+        case OpCode_push_const:
+            result.append("#");
+            result.append(std::to_string(_instr.constant.index) );
+            break;
+        case OpCode_dataflow:
+            result.append("dataflow #");
+            result.append(std::to_string(_instr.dataflow.index) );
+            break;
+        case OpCode_load_input:
+            result.append("input #");
+            result.append(std::to_string(_instr.input.index) );
+            break;
+        case OpCode_load:
+        case OpCode_load_ref:
+        case OpCode_store:
+            result.append("[");
+            result.append(std::to_string(_instr.slot.index) );
+            result.append("], ");
+            result.append(_instr.slot.type->name() );
+            break;
+        case OpCode_pop:
+            result.append(Register_to_string(_instr.pop_reg.dst) );
+            break;
+        case OpCode_load_reg:
+        case OpCode_store_reg:
+            result.append(Register_to_string(_instr.reg.reg) );
+            result.append(", ");
+            result.append(_instr.reg.type->name() );
+            break;
+        default: // typed operators have no parameter
             break;
     }
 
     // optionally append comment
-    if ( !_instr.m_comment.empty() )
+    if ( _comment && _comment[0] != '\0' )
     {
         result.resize(50, ' ');
 
         result.append( "; " );
-        result.append( _instr.m_comment );
+        result.append( _comment );
     }
     result.resize(80, ' '); // to fit with terminals
     return result;
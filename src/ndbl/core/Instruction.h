@@ -3,12 +3,12 @@
 #include "tools/core/memory/memory.h"
 #include "tools/core/reflection/reflection"
 #include "tools/core/types.h"
+#include "Register.h"
 
 namespace ndbl
 {
     // forward declarations
     class Scope;
-    class VariableNode;
     class Node;
 
     // list possible instruction's operation types
@@ -21,11 +21,52 @@ namespace ndbl
         OpCode_jne,              // conditional jump.
         OpCode_mov,              // move or copy memory.
         OpCode_deref_qword,      // qword ptr de-referencing.
-        OpCode_pop_stack_frame,  // ends the current stack frame.
-        OpCode_pop_var,          // pop a variable from the stack.
-        OpCode_push_stack_frame, // starts a new stack frame within the current.
-        OpCode_push_var,         // push a variable to the stack.
-        OpCode_ret               // return value.
+        OpCode_pop_stack_frame,  // ends the current stack frame, releasing all its slots at once.
+        OpCode_push_stack_frame, // starts a new stack frame within the current, reserving a slot per variable of its scope.
+        OpCode_push_var,         // initialize a variable's slot (reserved by its stack frame) to its type's default value.
+        OpCode_push_const,       // push a constant (from the Code's constant pool) to the stack.
+        OpCode_load,             // push a copy of a given stack slot (read a variable).
+        OpCode_load_ref,         // push a reference to a given stack slot (pass a variable by reference).
+        OpCode_store,            // pop the stack top into a given stack slot (initialize a variable).
+        OpCode_pop,              // pop the stack top into a register.
+        OpCode_ret,              // return value.
+        OpCode_pop_jne,          // pop the stack top into rax, and jump if it is false (superinstruction: pop + jne).
+        // Typed operators, operands are popped from the stack (left is the deepest) and the result is pushed.
+        // They replace an OpCode_call when operand types are known at compile time (keep them contiguous, cf. is_operator()).
+        OpCode_add_i32,          // i32 + i32
+        OpCode_sub_i32,          // i32 - i32
+        OpCode_mul_i32,          // i32 * i32
+        OpCode_div_i32,          // i32 / i32 (throws on division by zero)
+        OpCode_neg_i32,          // -i32
+        OpCode_lt_i32,           // i32 < i32
+        OpCode_le_i32,           // i32 <= i32
+        OpCode_gt_i32,           // i32 > i32
+        OpCode_ge_i32,           // i32 >= i32
+        OpCode_eq_i32,           // i32 == i32
+        OpCode_ne_i32,           // i32 != i32
+        OpCode_add_f64,          // double + double
+        OpCode_sub_f64,          // double - double
+        OpCode_mul_f64,          // double * double
+        OpCode_div_f64,          // double / double (throws on division by zero)
+        OpCode_neg_f64,          // -double
+        OpCode_lt_f64,           // double < double
+        OpCode_le_f64,           // double <= double
+        OpCode_gt_f64,           // double > double
+        OpCode_ge_f64,           // double >= double
+        OpCode_eq_f64,           // double == double
+        OpCode_ne_f64,           // double != double
+        OpCode_and_bool,         // bool && bool
+        OpCode_or_bool,          // bool || bool
+        OpCode_not_bool,         // !bool
+        OpCode_eq_bool,          // bool <=> bool
+        OpCode_ne_bool,          // bool != bool
+        OpCode_load_reg,         // push a copy of a given register (read a variable allocated to a register).
+        OpCode_store_reg,        // pop the stack top into a given register (write a variable allocated to a register).
+        OpCode_dataflow,         // pop the inputs of a pure expression tree (cf. Dataflow) and push its result, its independent calls run in parallel.
+        OpCode_load_input,       // push the value of a given input column at the row being run (cf. Interpreter::run_batch()).
+        OpCode_call_native,      // call a function through its allocation-free native call, arguments have its exact types (cf. tools::NativeCall).
+        OpCode_trap,             // stop the dispatch loop, never compiled: swapped in for a breakpoint (cf. Breakpoints).
+        OpCode_COUNT
     };
 
     REFLECT_ENUM(OpCode)
@@ -34,13 +75,51 @@ namespace ndbl
         REFLECT_ENUM_V(OpCode_deref_qword )
         REFLECT_ENUM_V(OpCode_call)
         REFLECT_ENUM_V(OpCode_push_var)
-        REFLECT_ENUM_V(OpCode_pop_var)
+        REFLECT_ENUM_V(OpCode_push_const)
+        REFLECT_ENUM_V(OpCode_load)
+        REFLECT_ENUM_V(OpCode_load_ref)
+        REFLECT_ENUM_V(OpCode_store)
+        REFLECT_ENUM_V(OpCode_pop)
         REFLECT_ENUM_V(OpCode_push_stack_frame)
         REFLECT_ENUM_V(OpCode_pop_stack_frame)
         REFLECT_ENUM_V(OpCode_jmp)
         REFLECT_ENUM_V(OpCode_jne)
         REFLECT_ENUM_V(OpCode_ret)
         REFLECT_ENUM_V(OpCode_cmp)
+        REFLECT_ENUM_V(OpCode_pop_jne)
+        REFLECT_ENUM_V(OpCode_add_i32)
+        REFLECT_ENUM_V(OpCode_sub_i32)
+        REFLECT_ENUM_V(OpCode_mul_i32)
+        REFLECT_ENUM_V(OpCode_div_i32)
+        REFLECT_ENUM_V(OpCode_neg_i32)
+        REFLECT_ENUM_V(OpCode_lt_i32)
+        REFLECT_ENUM_V(OpCode_le_i32)
+        REFLECT_ENUM_V(OpCode_gt_i32)
+        REFLECT_ENUM_V(OpCode_ge_i32)
+        REFLECT_ENUM_V(OpCode_eq_i32)
+        REFLECT_ENUM_V(OpCode_ne_i32)
+        REFLECT_ENUM_V(OpCode_add_f64)
+        REFLECT_ENUM_V(OpCode_sub_f64)
+        REFLECT_ENUM_V(OpCode_mul_f64)
+        REFLECT_ENUM_V(OpCode_div_f64)
+        REFLECT_ENUM_V(OpCode_neg_f64)
+        REFLECT_ENUM_V(OpCode_lt_f64)
+        REFLECT_ENUM_V(OpCode_le_f64)
+        REFLECT_ENUM_V(OpCode_gt_f64)
+        REFLECT_ENUM_V(OpCode_ge_f64)
+        REFLECT_ENUM_V(OpCode_eq_f64)
+        REFLECT_ENUM_V(OpCode_ne_f64)
+        REFLECT_ENUM_V(OpCode_and_bool)
+        REFLECT_ENUM_V(OpCode_or_bool)
+        REFLECT_ENUM_V(OpCode_not_bool)
+        REFLECT_ENUM_V(OpCode_eq_bool)
+        REFLECT_ENUM_V(OpCode_ne_bool)
+        REFLECT_ENUM_V(OpCode_load_reg)
+        REFLECT_ENUM_V(OpCode_store_reg)
+        REFLECT_ENUM_V(OpCode_dataflow)
+        REFLECT_ENUM_V(OpCode_load_input)
+        REFLECT_ENUM_V(OpCode_call_native)
+        REFLECT_ENUM_V(OpCode_trap)
     )
 
     // Unconditional jump
@@ -52,60 +131,112 @@ namespace ndbl
 
     struct Instruction_mov
     {
-        OpCode opcode;
-        tools::qword  dst;       // source memory
-        tools::qword  src;       // destination memory
+        OpCode        opcode;
+        Register      dst;       // destination register
+        tools::qword  src;       // source memory
     };
 
-    // Un-reference a pointer to a given type
+    // Un-reference a qword pointer
     struct Instruction_uref
     {
         OpCode                 opcode;
         const tools::qword*    ptr;
-        const tools::TypeDescriptor* type; // pointed data's type.
     };
 
-    // Compare two operands (test if equals)
+    // Compare two registers (test if equals)
     struct Instruction_cmp
     {
-        using qword = tools::qword;
-
-        OpCode opcode;
-        qword  left;     // the left operand.
-        qword  right;    // the right operand.
+        OpCode   opcode;
+        Register left;     // the left operand.
+        Register right;    // the right operand.
     };
 
     // Push or pop to/from the stack.
     struct Instruction_push_or_pop
     {
-        OpCode opcode;
+        OpCode   opcode;
+        Register reg;              // push_var only: register allocated to the variable, Register_undefined when it lives in its stack slot.
         union {
-            VariableNode* var;     // a variable to push/pop.
-            const Scope*  scope;   // a scope to push/pop.
+            u32_t         size;    // push_stack_frame only: slot count reserved by the frame (sized at compile time).
+            u32_t         index;   // push_var only: absolute index of the variable's slot.
         };
+        union {
+            const tools::TypeDescriptor* type;  // push_var only: the variable's type (its slot is reset to this type's default value).
+            const Scope*                 scope; // a scope to push/pop.
+        };
+    };
+
+    // Push a constant from the Code's constant pool
+    struct Instruction_const
+    {
+        OpCode opcode;
+        u32_t  index;    // index in the Code's constant pool.
     };
 
-    // Evaluates a given node
+    // Read or write a given stack slot (where a variable is stored)
+    struct Instruction_slot
+    {
+        OpCode                       opcode;
+        u32_t                        index; // absolute slot index in the stack.
+        const tools::TypeDescriptor* type;  // slot's type (a value stored is converted to it).
+    };
+
+    // Read or write a variable allocated to a register (only bool, i32 and double can be)
+    struct Instruction_reg
+    {
+        OpCode                       opcode;
+        Register                     reg;   // register allocated to the variable.
+        const tools::TypeDescriptor* type;  // variable's type (a value stored is converted to it).
+    };
+
+    // Pop the stack top into a register
+    struct Instruction_pop_reg
+    {
+        OpCode   opcode;
+        Register dst;     // destination register.
+    };
+
+    // Evaluates a given invokable, arguments are taken from the stack top, result is pushed back.
     struct Instruction_eval
     {
         OpCode                   opcode;
         const tools::IInvokable* invokable;
     };
 
+    // Evaluates a pure expression tree, inputs are taken from the stack top, result is pushed back.
+    struct Instruction_dataflow
+    {
+        OpCode opcode;
+        u32_t  index;    // index in the Code's dataflows.
+    };
+
+    // Push the value of an input column at the row being run
+    struct Instruction_input
+    {
+        OpCode opcode;
+        u32_t  index;    // column index (cf. Code's inputs).
+    };
+
     /**
      * Store a single assembly instruction.
+     * Instructions are fixed-size records stored contiguously in a Code (4 per cache line), their line is their index
+     * in the Code, and comments are stored aside (cf. Code::DebugInfo).
      * Each instruction looks like:
      * @code
      * line_nb type left-arg_at right-arg_at comment
      */
     struct Instruction
     {
-        Instruction(OpCode _opcode, size_t _line)
-            : opcode(_opcode)
-            , line(_line)
-        {}
+        explicit Instruction(OpCode _opcode)
+        {
+            memset((void*)this, 0, sizeof(Instruction)); // unused bytes are zeroed to make instructions comparable/serializable.
+            opcode = _opcode;
+        }
 
-        size_t      line;                                   // line index (zero-based position in the code)
+        bool  is_jump() const;                              // Check if this instruction is a (conditional or not) jump.
+        bool  is_operator() const;                          // Check if this instruction is a typed operator (ex: OpCode_add_i32).
+        i64_t get_jump_offset() const;                      // Get the jump offset (instruction must be a jump).
+        void  set_jump_offset(i64_t);                       // Set the jump offset (instruction must be a jump).
 
         // all the possible instructions
         union {
@@ -116,10 +247,16 @@ namespace ndbl
             Instruction_cmp         cmp;                    // compare
             Instruction_push_or_pop push;                   // push to stack
             Instruction_push_or_pop pop;                    // pop from stack
+            Instruction_const       constant;               // push a constant
+            Instruction_slot        slot;                   // load/store a stack slot
+            Instruction_reg         reg;                    // load/store a register
+            Instruction_pop_reg     pop_reg;                // pop to a register
             Instruction_eval        call;                   // evaluates
+            Instruction_dataflow    dataflow;               // evaluates in parallel
+            Instruction_input       input;                  // push an input
         };
-        std::string m_comment;                              // optional comment.
-        static std::string to_string(const Instruction&);   // Convert the instruction to a nice looking string.
+        static std::string to_string(const Instruction&, size_t _line, const char* _comment = nullptr); // Convert the instruction to a nice looking string.
     };
+    static_assert(sizeof(Instruction) == 16, "Instruction must stay a small fixed-size record, change this with care");
 
 } // namespace ndbl
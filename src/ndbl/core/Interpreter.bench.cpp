@@ -0,0 +1,225 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ndbl/core/NodableHeadless.h"
+#include "ndbl/core/Interpreter.h"
+#include "ndbl/core/language/Nodlang.h"
+
+using namespace ndbl;
+using namespace tools;
+
+// Instruction layout used before Code stored its instructions contiguously (heap allocated, with an inline comment).
+struct ScatteredInstruction
+{
+    ScatteredInstruction(const Instruction& _instr, size_t _line): line(_line), instr(_instr) {}
+    size_t      line;
+    Instruction instr;
+    std::string comment;
+};
+
+class InterpreterFixture : public benchmark::Fixture {
+public:
+    NodableHeadless app;
+    const Code*     code{};
+
+    static constexpr const char* PROGRAM =
+            "int sum = 0;"
+            "for(int i = 0; i < 1000; i = i+1)"
+            "{"
+            "   sum = sum + i;"
+            "}"
+            "return(sum);";
+
+    void SetUp(::benchmark::State& state) override
+    {
+        app.init();
+        log::set_verbosity(log::Verbosity_Error);
+        code = app.compile( app.parse(PROGRAM) );
+        if ( !app.load_program(code) )
+        {
+            state.SkipWithError("Unable to load program");
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state)
+    {
+        app.release_program();
+        delete code;
+        app.shutdown();
+    }
+};
+
+// Decode each instruction of a given range (no execution), returns a checksum to avoid dead code elimination.
+template<typename IteratorT, typename GetInstrT>
+static u64_t decode_all(IteratorT _begin, IteratorT _end, GetInstrT _get_instr)
+{
+    u64_t checksum = 0;
+    for ( auto it = _begin; it != _end; ++it )
+    {
+        const Instruction& instr = _get_instr(*it);
+        switch ( instr.opcode )
+        {
+            case OpCode_jmp:
+            case OpCode_jne:         checksum += instr.jmp.offset; break;
+            case OpCode_mov:         checksum += instr.mov.src.u64; break;
+            case OpCode_push_const:  checksum += instr.constant.index; break;
+            case OpCode_load:
+            case OpCode_load_ref:
+            case OpCode_store:       checksum += instr.slot.index; break;
+            case OpCode_call:
+            case OpCode_call_native: checksum += (u64_t)instr.call.invokable; break;
+            default:                 checksum += instr.opcode;
+        }
+    }
+    return checksum;
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, decode__scattered_instructions)(benchmark::State& state) {
+    // rebuild the former layout: one heap allocation per instruction, interleaved with its comment
+    std::vector<std::unique_ptr<ScatteredInstruction>> scattered;
+    for ( size_t i = 0; i < code->size(); ++i )
+    {
+        scattered.emplace_back( new ScatteredInstruction(*code->get_instruction_at(i), i) );
+        scattered.back()->comment = "a comment long enough to be heap allocated";
+    }
+
+    for (auto _ : state)
+    {
+        u64_t checksum = decode_all(scattered.begin(), scattered.end(), [](auto& each) -> const Instruction& { return each->instr; });
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed( state.iterations() * (i64_t)code->size() );
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, decode__contiguous_instructions)(benchmark::State& state) {
+    for (auto _ : state)
+    {
+        const Instruction* begin = code->data();
+        u64_t checksum = decode_all(begin, begin + code->size(), [](auto& each) -> const Instruction& { return each; });
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetItemsProcessed( state.iterations() * (i64_t)code->size() );
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, run_program__for_loop)(benchmark::State& state) {
+    Interpreter* interpreter = app.get_interpreter();
+    for (auto _ : state)
+    {
+        interpreter->run_program();
+        benchmark::DoNotOptimize( interpreter->get_last_result() );
+    }
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, run_program__for_loop_jit)(benchmark::State& state) {
+    Interpreter* interpreter = app.get_interpreter();
+    interpreter->release_program();
+    interpreter->set_jit_enabled(true);
+    if ( !interpreter->load_program(code) )
+    {
+        state.SkipWithError("Unable to load program");
+    }
+    else if ( !interpreter->is_jit_compiled() )
+    {
+        state.SkipWithError("JIT is not supported");
+    }
+    for (auto _ : state)
+    {
+        interpreter->run_program();
+        benchmark::DoNotOptimize( interpreter->get_last_result() );
+    }
+    interpreter->set_jit_enabled(false);
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, run_program__for_loop_traced)(benchmark::State& state) {
+    Interpreter* interpreter = app.get_interpreter();
+    Trace trace;
+    interpreter->set_trace(&trace);
+    for (auto _ : state)
+    {
+        interpreter->run_program();
+        benchmark::DoNotOptimize( interpreter->get_last_result() );
+    }
+    interpreter->set_trace(nullptr);
+}
+
+BENCHMARK_DEFINE_F(InterpreterFixture, run_program__for_loop_sliced)(benchmark::State& state) {
+    Interpreter* interpreter = app.get_interpreter();
+    for (auto _ : state)
+    {
+        interpreter->start_program();
+        while ( interpreter->run_for(1000000) == RunStatus_SUSPENDED ) {} // 1ms slices
+        benchmark::DoNotOptimize( interpreter->get_last_result() );
+    }
+}
+
+class BatchFixture : public benchmark::Fixture {
+public:
+    NodableHeadless     app;
+    std::vector<double> x;
+    std::vector<double> y;
+
+    static constexpr const char* PROGRAM = "double x = 0.0; double y = 0.0; double r = x * x + y * 2.0; return(r);";
+
+    void SetUp(const ::benchmark::State& state)
+    {
+        app.init();
+        log::set_verbosity(log::Verbosity_Error);
+        app.parse(PROGRAM);
+        x.resize(state.range(0));
+        y.resize(state.range(0));
+        for ( size_t i = 0; i < x.size(); ++i )
+        {
+            x[i] = (double)i;
+            y[i] = (double)(x.size() - i);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& state)
+    {
+        x.clear();
+        y.clear();
+        app.shutdown();
+    }
+};
+
+// One program run per row, each row being a new program (inputs as initializers)
+BENCHMARK_DEFINE_F(BatchFixture, run_program__per_row)(benchmark::State& state) {
+    const size_t row_count = x.size();
+    for (auto _ : state)
+    {
+        for ( size_t i = 0; i < row_count; ++i )
+        {
+            // a parse/compile per row is the only way to change the inputs without run_batch()
+            Graph*      graph = app.parse("double x = " + std::to_string(x[i]) + "; double y = " + std::to_string(y[i]) + "; double r = x * x + y * 2.0; return(r);");
+            const Code* code  = app.compile(graph);
+            app.load_program(code);
+            app.run_program();
+            benchmark::DoNotOptimize( app.get_last_result() );
+            app.release_program();
+            delete code;
+        }
+    }
+    state.SetItemsProcessed( state.iterations() * (i64_t)row_count );
+}
+
+BENCHMARK_DEFINE_F(BatchFixture, run_batch)(benchmark::State& state) {
+    const std::vector<Column> columns{ Column::of("x", x.data()), Column::of("y", y.data()) };
+    for (auto _ : state)
+    {
+        std::vector<qword> results = app.run_batch(columns, x.size());
+        benchmark::DoNotOptimize( results.data() );
+    }
+    state.SetItemsProcessed( state.iterations() * (i64_t)x.size() );
+}
+
+BENCHMARK_REGISTER_F(InterpreterFixture, decode__scattered_instructions);
+BENCHMARK_REGISTER_F(InterpreterFixture, decode__contiguous_instructions);
+BENCHMARK_REGISTER_F(InterpreterFixture, run_program__for_loop);
+BENCHMARK_REGISTER_F(InterpreterFixture, run_program__for_loop_jit);
+BENCHMARK_REGISTER_F(InterpreterFixture, run_program__for_loop_traced);
+BENCHMARK_REGISTER_F(InterpreterFixture, run_program__for_loop_sliced);
+BENCHMARK_REGISTER_F(BatchFixture, run_program__per_row)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_REGISTER_F(BatchFixture, run_batch)->Arg(1000)->Arg(100000)->Arg(10000000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
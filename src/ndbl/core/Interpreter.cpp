@@ -1,13 +1,19 @@
 #include "Interpreter.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include "tools/core/ThreadPool.h"
 #include "FunctionNode.h"
 #include "VariableNode.h"
 
 using namespace ndbl;
 using namespace tools;
 
-static Interpreter* g_interpreter{nullptr };
 
 CPU::CPU()
 {
@@ -44,6 +50,63 @@ void CPU::write(Register _id, qword _data)
     LOG_VERBOSE("CPU", "write register %s (value: %s)\n", Register_to_string(_id), mem_dst.to_string().c_str());
 }
 
+void Stack::reserve(size_t _size)
+{
+    if ( m_values.size() < _size )
+    {
+        m_values.resize(_size);
+        m_held.resize(_size, 0);
+    }
+}
+
+void Stack::clear()
+{
+    m_top = 0;
+    m_frame.clear();
+}
+
+// Get the bytes held by a given value outside of its variant (ex: a string's characters)
+static size_t get_held_memory(const variant& _value)
+{
+    static const TypeDescriptor* string_type = type::get<std::string>();
+
+    if ( _value.is_type(string_type) && _value.data()->ptr != nullptr )
+    {
+        return ((const std::string*)_value.data()->ptr)->capacity();
+    }
+    return 0;
+}
+
+void Stack::measure()
+{
+    m_held_total = 0;
+    for ( size_t i = 0; i < m_values.size(); ++i )
+    {
+        m_held[i]     = get_held_memory(m_values[i]);
+        m_held_total += m_held[i];
+    }
+}
+
+void Stack::measure(const variant* _slot)
+{
+    ASSERT(_slot >= m_values.data() && _slot < m_values.data() + m_values.size());
+    size_t& held  = m_held[_slot - m_values.data()];
+    m_held_total -= held;
+    held          = get_held_memory(*_slot);
+    m_held_total += held;
+}
+
+// Reset a given value to a given type's default value
+static void reset(variant& _value, const TypeDescriptor* _type)
+{
+    if      ( _type->is<double>() )      _value.set( 0.0 );
+    else if ( _type->is<i32_t>() )       _value.set( (i32_t)0 );
+    else if ( _type->is<i16_t>() )       _value.set( (i16_t)0 );
+    else if ( _type->is<bool>() )        _value.set( false );
+    else if ( _type->is<std::string>() ) _value.set( "" );
+    // other types (any, pointers) have no default value
+}
+
 void Interpreter::advance_cursor(i64_t _amount)
 {
     qword eip = m_cpu.read(Register_eip);
@@ -51,243 +114,828 @@ void Interpreter::advance_cursor(i64_t _amount)
     m_cpu.write(Register_eip, eip );
 }
 
-void Interpreter::run_program()
+void Interpreter::exec_cmp(const Instruction& _instr)
+{
+    qword left  = m_cpu.read(_instr.cmp.left);  // dereference registers, get their value
+    qword right = m_cpu.read(_instr.cmp.right);
+    qword result;
+    result.b = left.b == right.b;
+    m_cpu.write(Register_rax, result);       // boolean comparison
+}
+
+void Interpreter::exec_deref_qword(const Instruction& _instr)
+{
+    const qword* qword = _instr.uref.ptr;
+    m_cpu.write(Register_rax, *qword );
+    LOG_VERBOSE("Interpreter", "deref_qword %p: %s\n", qword, qword->to_string().c_str() );
+}
+
+void Interpreter::exec_mov(const Instruction& _instr)
+{
+    // write( <destination_register>, <source_data>)
+    m_cpu.write(_instr.mov.dst, _instr.mov.src);
+}
+
+void Interpreter::exec_push_var(const Instruction& _instr)
+{
+    // a variable's slot (reserved by its frame) is reset to its type's default value
+    reset(m_stack.at(_instr.push.index), _instr.push.type );
+    if ( _instr.push.reg != Register_undefined )
+    {
+        m_cpu.write(_instr.push.reg, qword()); // zero is the default value of each type a register can hold
+    }
+}
+
+void Interpreter::exec_push_stack_frame(const Instruction& _instr)
+{
+    m_stack.push_frame(_instr.push.size);
+}
+
+void Interpreter::exec_pop_stack_frame(const Instruction&)
+{
+    m_stack.pop_frame();
+}
+
+void Interpreter::exec_push_const(const Instruction& _instr)
+{
+    *m_stack.push() = m_code->get_constant(_instr.constant.index);
+}
+
+void Interpreter::exec_load(const Instruction& _instr)
+{
+    variant& src = m_stack.at(_instr.slot.index);
+    *m_stack.push() = src;
+}
+
+void Interpreter::exec_load_ref(const Instruction& _instr)
+{
+    variant* src = &m_stack.at(_instr.slot.index);
+    m_stack.push()->set( (void*)src );
+}
+
+void Interpreter::exec_store(const Instruction& _instr)
+{
+    variant& dst = m_stack.at(_instr.slot.index);
+    dst = m_stack.top();
+    dst.convert(_instr.slot.type);
+    m_stack.pop();
+    m_cpu.write(Register_rax, *dst.data() );
+}
+
+void Interpreter::exec_load_reg(const Instruction& _instr)
+{
+    static const TypeDescriptor* i32_type    = type::get<i32_t>();
+    static const TypeDescriptor* double_type = type::get<double>();
+
+    const qword value = m_cpu.read(_instr.reg.reg);
+    variant&    dst   = *m_stack.push();
+    if      ( _instr.reg.type == i32_type )    dst.set( value.i32 );
+    else if ( _instr.reg.type == double_type ) dst.set( value.d );
+    else                                       dst.set( value.b );
+}
+
+void Interpreter::exec_store_reg(const Instruction& _instr)
+{
+    variant& src = m_stack.top();
+    src.convert(_instr.reg.type);
+    m_cpu.write(_instr.reg.reg, *src.data() );
+    m_cpu.write(Register_rax, *src.data() );
+    m_stack.pop();
+}
+
+void Interpreter::exec_pop(const Instruction& _instr)
+{
+    m_cpu.write(_instr.pop_reg.dst, *m_stack.top().data() );
+    m_stack.pop();
+}
+
+void Interpreter::exec_call(const Instruction& _instr)
+{
+    // arguments are the N values on top of the stack (first argument is the deepest)
+    const IInvokable*         invokable = _instr.call.invokable;
+    const FunctionDescriptor* sig       = invokable->get_sig();
+    const size_t              arg_count = sig->arg_count();
+
+    m_call_args.resize(arg_count);
+    for( size_t i = 0; i < arg_count; ++i )
+    {
+        variant* arg = &m_stack.top(arg_count - 1 - i);
+        const FuncArg& arg_type = sig->arg_at(i);
+        if ( arg_type.pass_by_ref )
+        {
+            arg = (variant*)arg->to<void*>(); // slot stores a pointer to a variable's slot (cf. OpCode_load_ref)
+        }
+        else
+        {
+            arg->convert(arg_type.type); // slot is a copy, we can convert it in place
+        }
+        m_call_args[i] = arg;
+    }
+
+    variant result = invokable->invoke(m_call_args);
+
+    // arguments are replaced by the result (if any)
+    m_stack.pop(arg_count);
+    if ( !sig->return_type()->is<void>() )
+    {
+        *m_stack.push() = result;
+    }
+}
+
+void Interpreter::exec_call_native(const Instruction& _instr)
+{
+    // arguments are the N values on top of the stack (first argument is the deepest), the Compiler ensures they have the exact types
+    const NativeCall& native    = _instr.call.invokable->get_native();
+    const size_t      arg_count = native.arg_count;
+
+    if ( arg_count == 0 )
+    {
+        native(nullptr, native.has_result ? m_stack.push() : nullptr);
+        return;
+    }
+
+    // arguments are replaced by the result (if any), written to the deepest one
+    variant* args = &m_stack.top(arg_count - 1);
+    native(args, args);
+    m_stack.pop( native.has_result ? arg_count - 1 : arg_count );
+}
+
+ThreadPool& Interpreter::get_shared_thread_pool()
+{
+    // a pool per interpreter would create a thread per core for each of them
+    static ThreadPool pool;
+    return pool;
+}
+
+void Interpreter::exec_dataflow(const Instruction& _instr)
+{
+    // inputs are the N values on top of the stack (first input is the deepest)
+    const Dataflow& dataflow    = m_code->get_dataflow(_instr.dataflow.index);
+    const size_t    input_count = dataflow.get_input_count();
+
+    variant result = dataflow.run( input_count ? &m_stack.top(input_count - 1) : nullptr, get_thread_pool() );
+
+    // inputs are replaced by the result
+    m_stack.pop(input_count);
+    *m_stack.push() = std::move(result);
+}
+
+void Interpreter::exec_load_input(const Instruction& _instr)
+{
+    static const TypeDescriptor* i32_type    = type::get<i32_t>();
+    static const TypeDescriptor* double_type = type::get<double>();
+
+    if ( m_batch_columns == nullptr )
+    {
+        throw std::runtime_error("Inputs are only available when running a batch (cf. run_batch())");
+    }
+    const Column& column = (*m_batch_columns)[_instr.input.index];
+    variant&      dst    = *m_stack.push();
+    if      ( column.type == i32_type )    dst.set( static_cast<const i32_t*>(column.data)[m_batch_row] );
+    else if ( column.type == double_type ) dst.set( static_cast<const double*>(column.data)[m_batch_row] );
+    else                                   dst.set( static_cast<const bool*>(column.data)[m_batch_row] );
+}
+
+i64_t Interpreter::exec_jmp(const Instruction& _instr)
+{
+    return _instr.jmp.offset;
+}
+
+i64_t Interpreter::exec_jne(const Instruction& _instr)
+{
+    // last comparison result is stored in rax, jump if NOT equal
+    return m_cpu.read(Register_rax).b ? 1 : _instr.jmp.offset;
+}
+
+i64_t Interpreter::exec_pop_jne(const Instruction& _instr)
+{
+    m_cpu.write(Register_rax, *m_stack.top().data() );
+    m_stack.pop();
+    return exec_jne(_instr);
+}
+
+// Division functor, throws on division by zero (as the Nodlang_math implementation does)
+template<typename T>
+struct divides_or_throw
+{
+    T operator()(T _left, T _right) const
+    {
+        if ( _right == 0 ) throw std::runtime_error("division by zero !");
+        return _left / _right;
+    }
+};
+
+// Typed binary operator, operands are on top of the stack (left is the deepest), they are replaced by the result.
+// The Compiler ensures operands are of type T (cf. Compiler::compile_function_call)
+template<typename T, typename OperatorT>
+static inline void exec_binary_operator(Stack& _stack)
+{
+    const T right = (T)_stack.top();
+    _stack.pop();
+    variant& left = _stack.top();
+    auto result = OperatorT()( (T)left, right );
+    if constexpr ( std::is_same_v<decltype(result), T> )
+        left.operator T&() = result; // same type, no need to change variant's type
+    else
+        left.set( result );
+}
+
+// Typed unary operator, operand is on top of the stack, it is replaced by the result.
+template<typename T, typename OperatorT>
+static inline void exec_unary_operator(Stack& _stack)
+{
+    variant& operand = _stack.top();
+    operand.operator T&() = OperatorT()( (T)operand );
+}
+
+// List all the typed operators: X(name, arity, operand type, functor)
+#define NDBL_TYPED_OPERATORS(X) \
+    X(add_i32,  binary, i32_t,  std::plus) \
+    X(sub_i32,  binary, i32_t,  std::minus) \
+    X(mul_i32,  binary, i32_t,  std::multiplies) \
+    X(div_i32,  binary, i32_t,  divides_or_throw) \
+    X(neg_i32,  unary,  i32_t,  std::negate) \
+    X(lt_i32,   binary, i32_t,  std::less) \
+    X(le_i32,   binary, i32_t,  std::less_equal) \
+    X(gt_i32,   binary, i32_t,  std::greater) \
+    X(ge_i32,   binary, i32_t,  std::greater_equal) \
+    X(eq_i32,   binary, i32_t,  std::equal_to) \
+    X(ne_i32,   binary, i32_t,  std::not_equal_to) \
+    X(add_f64,  binary, double, std::plus) \
+    X(sub_f64,  binary, double, std::minus) \
+    X(mul_f64,  binary, double, std::multiplies) \
+    X(div_f64,  binary, double, divides_or_throw) \
+    X(neg_f64,  unary,  double, std::negate) \
+    X(lt_f64,   binary, double, std::less) \
+    X(le_f64,   binary, double, std::less_equal) \
+    X(gt_f64,   binary, double, std::greater) \
+    X(ge_f64,   binary, double, std::greater_equal) \
+    X(eq_f64,   binary, double, std::equal_to) \
+    X(ne_f64,   binary, double, std::not_equal_to) \
+    X(and_bool, binary, bool,   std::logical_and) \
+    X(or_bool,  binary, bool,   std::logical_or) \
+    X(not_bool, unary,  bool,   std::logical_not) \
+    X(eq_bool,  binary, bool,   std::equal_to) \
+    X(ne_bool,  binary, bool,   std::not_equal_to)
+
+#define NDBL_DEFINE_OPERATOR(name, arity, T, functor) \
+    static void exec_##name(Stack& _stack) { exec_##arity##_operator<T, functor<T>>(_stack); }
+NDBL_TYPED_OPERATORS(NDBL_DEFINE_OPERATOR)
+#undef NDBL_DEFINE_OPERATOR
+
+// Direct-threaded dispatch is used when the compiler supports "labels as values" (GCC/Clang), a switch otherwise.
+#if defined(__GNUC__) || defined(__clang__)
+#   define NDBL_COMPUTED_GOTO 1
+#else
+#   define NDBL_COMPUTED_GOTO 0
+#endif
+
+// Get a time point in nanoseconds (cf. Profiler, run_for())
+static inline u64_t clock_now()
+{
+    return (u64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RunStatus Interpreter::run_program()
+{
+    start_program();
+
+    // a run limited by a budget is a single slice, ended by the budget only
+    if ( has_budget() )
+    {
+        return run_slice(UINT64_MAX, 0);
+    }
+
+    // the machine code does not sample nor record the instructions run
+    const bool use_jit = is_jit_compiled() && m_profiler == nullptr && m_trace == nullptr;
+    try
+    {
+        if ( use_jit )
+            m_jit->run(this);
+        else
+            execute(m_code->data());
+    }
+    catch (...)
+    {
+        stop_program();
+        throw;
+    }
+
+    stop_program();
+    LOG_MESSAGE("Interpreter", "Program terminated\n");
+    return RunStatus_DONE;
+}
+
+void Interpreter::start_program()
 {
     ASSERT(m_code);
     LOG_MESSAGE("Interpreter", "Running program ...\n");
     m_is_program_running = true;
     m_cpu.clear_registers();
+    m_stack.clear();
     m_visited_nodes.clear();
     m_next_node = nullptr;
-
-    while( is_there_a_next_instr() && get_next_instr()->opcode != OpCode_ret )
+    m_usage     = {};
+    if ( m_budget.memory != 0 )
     {
-        step_over();
+        m_stack.measure(); // slots are only measured when the memory is limited, they may have changed since
     }
-    stop_program();
-    LOG_MESSAGE("Interpreter", "Program terminated\n");
 }
 
-void Interpreter::stop_program()
+RunStatus Interpreter::run_steps(u64_t _count)
 {
-    if ( m_is_program_running )
+    return run_slice(_count, 0);
+}
+
+RunStatus Interpreter::run_for(u64_t _nanoseconds)
+{
+    return run_slice(UINT64_MAX, clock_now() + _nanoseconds);
+}
+
+RunStatus Interpreter::run_slice(u64_t _steps, u64_t _deadline)
+{
+    ASSERT(m_code);
+    VERIFY(m_is_program_running && !m_is_debugging, "Program must be started first (cf. start_program())");
+
+    m_slice          = {};
+    m_slice.steps    = _steps;
+    m_slice.deadline = _deadline;
+    m_slice.begin    = clock_now();
+    try
     {
-        m_is_program_running = false;
-        m_is_debugging       = false;
-        m_next_node          = {};
-        LOG_MESSAGE("Interpreter", "Program stopped\n");
+        execute(m_code->data(), true);
     }
-    else
+    catch (...)
     {
-        LOG_ERROR("Interpreter", "stop_program() failed, program is not running\n");
+        m_usage.nanoseconds += clock_now() - m_slice.begin;
+        stop_program();
+        throw;
     }
-}
+    m_usage.instructions += m_slice.granted; // run since the last check
+    m_usage.nanoseconds  += clock_now() - m_slice.begin;
 
-const Code* Interpreter::release_program()
-{
-    if( m_is_program_running )
+    if ( m_usage.exceeded != BudgetFlag_NONE )
     {
-        LOG_VERBOSE("Interpreter", "stopping program before continue\n");
         stop_program();
+        LOG_WARNING("Interpreter", "Program exceeded its budget (instructions: %llu, time: %llu ns, memory: %zu bytes)\n",
+                    m_usage.instructions, m_usage.nanoseconds, m_usage.memory);
+        return RunStatus_BUDGET_EXCEEDED;
     }
-
-    m_cpu.clear_registers(); // will also clear reset instruction pointer (stored in a register Register_eip)
-    LOG_VERBOSE("Interpreter", "registers cleared\n");
-
-    LOG_VERBOSE("Interpreter", "program released\n");
-    const Code* copy = m_code;
-    m_code = nullptr;
-    return copy;
+    if ( m_slice.suspended )
+    {
+        return RunStatus_SUSPENDED;
+    }
+    stop_program();
+    LOG_MESSAGE("Interpreter", "Program terminated\n");
+    return RunStatus_DONE;
 }
 
-bool Interpreter::step_over()
+u64_t Interpreter::next_slice_steps()
 {
-    bool success{false};
-    Instruction* next_instr = get_next_instr();
+    // the instructions granted previously were run
+    m_slice.steps        -= m_slice.granted;
+    m_usage.instructions += m_slice.granted;
+    m_slice.granted       = 0;
 
-    LOG_MESSAGE("Interpreter", "%s\n", Instruction::to_string(*next_instr).c_str() );
+    // the clock is read only when the time is limited
+    const bool  timed = m_slice.deadline != 0 || m_budget.nanoseconds != 0;
+    const u64_t now   = timed ? clock_now() : 0;
 
-    switch ( next_instr->opcode )
+    if ( m_budget.instructions != 0 && m_usage.instructions >= m_budget.instructions )
     {
-        case OpCode_cmp:
-        {
-            qword left  = m_cpu.read(static_cast<Register>(next_instr->cmp.left.u8));  // dereference registers, get their value
-            qword right = m_cpu.read(static_cast<Register>(next_instr->cmp.right.u8));
-            qword result;
-            result.b = left.b == right.b;
-            m_cpu.write(Register_rax, result);       // boolean comparison
-            advance_cursor();
-            break;
-        }
+        m_usage.exceeded |= BudgetFlag_INSTRUCTIONS;
+    }
+    if ( m_budget.nanoseconds != 0 && m_usage.nanoseconds + (now - m_slice.begin) >= m_budget.nanoseconds )
+    {
+        m_usage.exceeded |= BudgetFlag_TIME;
+    }
+    if ( m_usage.exceeded != BudgetFlag_NONE )
+    {
+        return 0;
+    }
 
-        case OpCode_deref_qword:
-        {
-            // TODO: code is WTH because of a lack of stack/heap
+    if ( m_slice.steps == 0 || ( m_slice.deadline != 0 && now >= m_slice.deadline ) )
+    {
+        m_slice.suspended = true;
+        return 0;
+    }
 
-            const qword* qword = next_instr->uref.ptr;
-            m_cpu.write(Register_rax, *qword );
+    u64_t granted = m_slice.steps;
+    if ( m_budget.instructions != 0 )
+    {
+        granted = std::min(granted, m_budget.instructions - m_usage.instructions);
+    }
+    if ( timed )
+    {
+        granted = std::min(granted, SLICE_CLOCK_PERIOD);
+    }
+    m_slice.granted = granted;
+    return granted;
+}
 
-            const TypeDescriptor* ptr_type = next_instr->uref.type;
-            if(ptr_type->is<bool>() )
-            {
-                LOG_VERBOSE("Interpreter", "deref_qword bool: %b\n", qword->b);
-            }
-            else if(ptr_type->is<double>() )
-            {
-                LOG_VERBOSE("Interpreter", "deref_qword double: %d\n", qword->d );
-            }
-            else if(ptr_type->is<i16_t>() )
-            {
-                LOG_VERBOSE("Interpreter", "deref_qword i16_t: %i\n", qword->i16 );
-            }
-            else if(ptr_type->is<i32_t>() )
-            {
-                LOG_VERBOSE("Interpreter", "deref_qword i32_t: %i\n", qword->i32 );
-            }
-            else if(ptr_type->is<std::string>() )
-            {
-                LOG_VERBOSE("Interpreter", "deref_qword std::string* (%p): %s\n", qword->ptr, ((std::string*)qword)->c_str() );
-            }
-            else if(ptr_type->is<void *>() )
+bool Interpreter::check_memory(const Instruction& _instr)
+{
+    // only the slots written by the instruction are measured again
+    switch ( _instr.opcode )
+    {
+        case OpCode_call:
+            for ( const variant* each : m_call_args ) // arguments converted in place, or written through a reference
             {
-                LOG_VERBOSE("Interpreter", "deref_qword void* (aka Node*) (%p): %s\n", qword->ptr,
-                            ((Node *) qword->ptr)->name().c_str() );
+                m_stack.measure(each);
             }
-            else if(ptr_type->is<any>() )
+            if ( m_stack.size() != 0 ) // result
             {
-                LOG_VERBOSE("Interpreter", "deref_qword any_t (%p)\n", qword->ptr );
+                m_stack.measure(&m_stack.top());
             }
-            else
+            break;
+        case OpCode_call_native: // arguments have the exact types, only the result is written
+            if ( _instr.call.invokable->get_native().has_result )
             {
-                VERIFY(false, "This type is not handled!");
+                m_stack.measure(&m_stack.top());
             }
-
-            advance_cursor();
             break;
-        }
+        case OpCode_push_var:
+            m_stack.measure(&m_stack.at(_instr.push.index));
+            break;
+        case OpCode_store: // the popped value is left unchanged
+            m_stack.measure(&m_stack.at(_instr.slot.index));
+            break;
+        default: // the value pushed (cf. OpCode_push_const, OpCode_load, OpCode_dataflow)
+            m_stack.measure(&m_stack.top());
+    }
 
-        case OpCode_mov:
-        {
-            // write( <destination_register>, <source_data>)
-            m_cpu.write(next_instr->mov.dst.u8, next_instr->mov.src);
+    m_usage.memory = std::max(m_usage.memory, m_stack.get_memory());
+    if ( m_usage.memory > m_budget.memory )
+    {
+        m_usage.exceeded |= BudgetFlag_MEMORY;
+        return false;
+    }
+    return true;
+}
 
-            advance_cursor();
-            break;
-        }
+std::vector<qword> Interpreter::run_batch(const std::vector<Column>& _columns, size_t _row_count)
+{
+    static const TypeDescriptor* bool_type   = type::get<bool>();
+    static const TypeDescriptor* i32_type    = type::get<i32_t>();
+    static const TypeDescriptor* double_type = type::get<double>();
 
-        case OpCode_push_var:
+    ASSERT(m_code);
+    const std::vector<std::string>& inputs = m_code->get_meta_data().inputs;
+    // columns are checked once, rows are then run without any check
+    if ( _columns.size() != inputs.size() )
+    {
+        throw std::runtime_error("A column is required for each input of the program");
+    }
+    for ( size_t i = 0; i < inputs.size(); ++i )
+    {
+        const Column& column = _columns[i];
+        if ( column.name != inputs[i] )
         {
-            advance_cursor();
-            VariableNode* variable = next_instr->push.var;
-            ASSERT(variable->has_flags(VariableFlag_DECLARED) == false);
-            ASSERT(variable->has_flags(VariableFlag_INITIALIZED) == false);
-            variable->set_flags(VariableFlag_DECLARED);
-            //
-            // TODO: implement a stack/heap
-            //
-            break;
+            throw std::runtime_error("Column \"" + column.name + "\" is not the program's input #" + std::to_string(i) + " (\"" + inputs[i] + "\")");
         }
-
-        case OpCode_pop_var:
+        if ( column.type != bool_type && column.type != i32_type && column.type != double_type )
         {
-            ASSERT(false); // not implemented!
-//            advance_cursor();
-//            VariableNode* variable = next_instr->push.var;
-//            ASSERT(variable->has_vflags(VariableFlag_DECLARED))
-//            variable->clear_vflags(VariableFlag_DECLARED);
-//            if(variable->has_vflags(VariableFlag_INITIALIZED) ) // Might not have been initialized, check needed.
-//                variable->clear_vflags(VariableFlag_INITIALIZED);
-            //
-            // TODO: implement a stack/heap
-            //
-            break;
+            throw std::runtime_error("Column \"" + column.name + "\" type must be bool, i32_t or double");
         }
-
-        case OpCode_push_stack_frame: // ensure variable declared in this scope are unitialized before/after scope
-        case OpCode_pop_stack_frame:
+        if ( column.data == nullptr && _row_count != 0 )
         {
-            advance_cursor();
-            //
-            // not implemented, currently we use VariableNode's data instead of a dedicated stack/heap.
-            //
-            break;
+            throw std::runtime_error("Column \"" + column.name + "\" has no data");
         }
+    }
 
-        case OpCode_call:
-        {
-//            auto update_input__by_value_only = [](Node* _node)
-//            {
-//                for(Slot* slot: _node->filter_slots( SlotFlag_INPUT ) )
-//                {
-//                    if( slot->adjacent_count() == 0)
-//                        continue;
-//
-//                    Property* property = slot->get_property();
-//                    if( !property->has_flags(PropertyFlag_IS_REF) )
-//                    {
-//                        ASSERT(false)// not implemented!
-//                        //*property->value() = *slot->first_adjacent()->get_property()->value();
-//                        // TODO: copy by value in vmem
-//                    }
-//                }
-//            };
-//
-//            if( auto variable = cast<VariableNode>(next_instr->eval.node))
-//            {
-//                if( !variable->has_flags(VariableFlag_INITIALIZED) )
-//                {
-//                    variable->set_flags(VariableFlag_INITIALIZED);
-//                    update_input__by_value_only(variable);
-//                }
-//            }
-//            else
-//            {
-//                update_input__by_value_only(next_instr->eval.node);
-//            }
-
-            VERIFY(false, "not implemented yet");
-            // const std::vector<variant*> args = TODO: get args from stack
-            // next_instr->call.invokable->invoke(args);
-
-            advance_cursor();
+    LOG_MESSAGE("Interpreter", "Running program over %zu row(s) ...\n", _row_count);
+    m_is_program_running = true;
+    m_cpu.clear_registers();
+    m_visited_nodes.clear();
+    m_next_node     = nullptr;
+    m_batch_columns = &_columns;
 
-            break;
+    // the program stays loaded, only the stack and the instruction pointer are reset between two rows
+    std::vector<qword> results;
+    results.reserve(_row_count);
+    try
+    {
+        for ( m_batch_row = 0; m_batch_row < _row_count; ++m_batch_row )
+        {
+            m_stack.clear();
+            m_cpu.write(Register_eip, qword());
+            m_cpu.write(Register_rax, qword());
+            execute(m_code->data());
+            results.push_back( m_cpu.read(Register_rax) );
         }
+    }
+    catch (...)
+    {
+        m_batch_columns = nullptr;
+        stop_program();
+        throw;
+    }
+
+    m_batch_columns = nullptr;
+    stop_program();
+    LOG_MESSAGE("Interpreter", "Batch terminated\n");
+    return results;
+}
+
+void Interpreter::execute(const Instruction* _instructions, bool _sliced)
+{
+    // the dispatch loop is instantiated for each option, so profiling, tracing or slicing costs nothing when disabled
+    typedef void (Interpreter::*Execute)(const Instruction*);
+    static constexpr Execute execute_ex_table[] =
+    {
+        &Interpreter::execute_ex<false, false, false>,
+        &Interpreter::execute_ex<false, false, true>,
+        &Interpreter::execute_ex<false, true,  false>,
+        &Interpreter::execute_ex<false, true,  true>,
+        &Interpreter::execute_ex<true,  false, false>,
+        &Interpreter::execute_ex<true,  false, true>,
+        &Interpreter::execute_ex<true,  true,  false>,
+        &Interpreter::execute_ex<true,  true,  true>,
+    };
+
+    if ( m_profiler != nullptr )
+    {
+        m_profiler->begin(m_code);
+    }
+    const size_t options = (m_profiler != nullptr) << 2 | (m_trace != nullptr) << 1 | (size_t)_sliced;
+    (this->*execute_ex_table[options])(_instructions);
+}
+
+template<bool PROFILE, bool TRACE, bool SLICED>
+void Interpreter::execute_ex(const Instruction* _instructions)
+{
+    // The instruction pointer is kept in a local, and is written back to Register_eip only when exiting.
+    // load_program() ensures the code ends with OpCode_ret, so no bound check is required when stepping.
+    const Instruction* const begin = _instructions;
+    const Instruction*       instr = begin + m_cpu.read(Register_eip).u64;
 
-        case OpCode_jmp:
+    // when sliced, instructions are counted down, the slice is checked each time the count reaches zero
+    [[maybe_unused]] u64_t slice_steps = 0;
+    if constexpr ( SLICED )
+    {
+        slice_steps = next_slice_steps();
+        if ( slice_steps == 0 )
         {
-            advance_cursor(next_instr->jmp.offset);
-            break;
+            return;
         }
+    }
+
+    // an instruction's time is measured from its dispatch to the next one
+    [[maybe_unused]] Profiler::Sample* samples        = nullptr;
+    [[maybe_unused]] Profiler::Sample* current_sample = nullptr;
+    [[maybe_unused]] u64_t             sample_begin   = 0;
+    if constexpr ( PROFILE )
+    {
+        samples        = m_profiler->data();
+        current_sample = samples + (instr - begin);
+        current_sample->count++;
+        sample_begin   = clock_now();
+    }
+    if constexpr ( TRACE )
+    {
+        m_trace->push((u64_t)(instr - begin), instr->opcode, m_cpu.read(Register_rax));
+    }
 
-        case OpCode_jne:
+#if NDBL_COMPUTED_GOTO
+    // initialized once per instantiation, in OpCode order (labels are constant addresses)
+#   define NDBL_DISPATCH_OPERATOR(name, ...) &&label_OpCode_##name,
+    static void* const dispatch_table[] = {
+        &&label_OpCode_cmp,
+        &&label_OpCode_call,
+        &&label_OpCode_jmp,
+        &&label_OpCode_jne,
+        &&label_OpCode_mov,
+        &&label_OpCode_deref_qword,
+        &&label_OpCode_pop_stack_frame,
+        &&label_OpCode_push_stack_frame,
+        &&label_OpCode_push_var,
+        &&label_OpCode_push_const,
+        &&label_OpCode_load,
+        &&label_OpCode_load_ref,
+        &&label_OpCode_store,
+        &&label_OpCode_pop,
+        &&label_OpCode_ret,
+        &&label_OpCode_pop_jne,
+        NDBL_TYPED_OPERATORS(NDBL_DISPATCH_OPERATOR)
+        &&label_OpCode_load_reg,
+        &&label_OpCode_store_reg,
+        &&label_OpCode_dataflow,
+        &&label_OpCode_load_input,
+        &&label_OpCode_call_native,
+        &&label_OpCode_trap,
+    };
+#   undef NDBL_DISPATCH_OPERATOR
+    static_assert(std::size(dispatch_table) == OpCode_COUNT, "dispatch_table must have a label per OpCode");
+    static_assert(OpCode_pop_jne + 1 == OpCode_add_i32 && OpCode_ne_bool + 1 == OpCode_load_reg && OpCode_trap + 1 == OpCode_COUNT, "dispatch_table is out of OpCode order");
+#   define VM_DISPATCH()   goto *dispatch_table[instr->opcode]
+#   define VM_CASE(opcode) label_##opcode:
+#   define VM_INVALID()    [[maybe_unused]] label_invalid: /* every OpCode has its label */
+#   define VM_LOOP()       VM_DISPATCH();
+#else
+#   define VM_DISPATCH()   continue
+#   define VM_CASE(opcode) case opcode:
+#   define VM_INVALID()    default:
+#   define VM_LOOP()       for(;;) switch ( instr->opcode )
+#endif
+#define VM_PROFILE() \
+    if constexpr ( PROFILE ) \
+    { \
+        const u64_t now = clock_now(); \
+        current_sample->nanoseconds += now - sample_begin; \
+        current_sample = samples + (instr - begin); \
+        current_sample->count++; \
+        sample_begin   = now; \
+    }
+#define VM_TRACE() \
+    if constexpr ( TRACE ) \
+    { \
+        m_trace->push((u64_t)(instr - begin), instr->opcode, m_cpu.read(Register_rax)); \
+    }
+#define VM_SLICE() \
+    if constexpr ( SLICED ) \
+    { \
+        if ( --slice_steps == 0 && (slice_steps = next_slice_steps()) == 0 ) \
+            goto exit; \
+    }
+#define VM_MEMORY() \
+    if constexpr ( SLICED ) \
+    { \
+        if ( m_budget.memory != 0 && !check_memory(instr[-1]) ) \
+        { \
+            --slice_steps; /* this instruction was run */ \
+            goto exit; \
+        } \
+    }
+#define VM_NEXT() VM_SLICE() VM_PROFILE() VM_TRACE() VM_DISPATCH()
+#define VM_EXEC(opcode) VM_CASE(OpCode_##opcode) exec_##opcode(*instr); ++instr; VM_NEXT();
+#define VM_EXEC_CALL(opcode) VM_CASE(OpCode_##opcode) exec_##opcode(*instr); ++instr; VM_MEMORY() VM_NEXT();
+#define VM_EXEC_WRITE(opcode) VM_EXEC_CALL(opcode) // an instruction copying a value to a slot, measured as a call
+#define VM_EXEC_JUMP(opcode) VM_CASE(OpCode_##opcode) instr += exec_##opcode(*instr); ASSERT(instr >= begin && instr < begin + m_code->size()); VM_NEXT();
+#define VM_EXEC_OPERATOR(opcode, ...) VM_CASE(OpCode_##opcode) exec_##opcode(m_stack); ++instr; VM_NEXT();
+
+    try
+    {
+        VM_LOOP()
         {
-            qword rax = m_cpu.read(Register_rax);
-            i64_t offset{1};
-            if ( rax.b ) // last comparison result is stored in rax
-                offset = next_instr->jmp.offset; // jump if NOT equal
-            advance_cursor( offset );
-            break;
+            VM_EXEC(cmp)
+            VM_EXEC_CALL(call)
+            VM_EXEC_CALL(dataflow)
+            VM_EXEC_CALL(call_native)
+            VM_EXEC(load_input)
+            VM_EXEC(mov)
+            VM_EXEC(deref_qword)
+            VM_EXEC(pop_stack_frame)
+            VM_EXEC(push_stack_frame)
+            VM_EXEC_WRITE(push_var)
+            VM_EXEC_WRITE(push_const)
+            VM_EXEC_WRITE(load)
+            VM_EXEC(load_ref)
+            VM_EXEC_WRITE(store)
+            VM_EXEC(load_reg)
+            VM_EXEC(store_reg)
+            VM_EXEC(pop)
+
+            VM_EXEC_JUMP(jmp)
+            VM_EXEC_JUMP(jne)
+            VM_EXEC_JUMP(pop_jne)
+
+            NDBL_TYPED_OPERATORS(VM_EXEC_OPERATOR)
+
+            VM_CASE(OpCode_ret)
+                goto exit;
+
+            VM_CASE(OpCode_trap) // breakpoint, cf. debug_continue()
+                goto exit;
+
+            VM_INVALID()
+                VERIFY(false, "Unhandled OpCode");
+                goto exit;
         }
+    }
+    catch (...)
+    {
+        qword eip;
+        eip.u64 = (u64_t)(instr - begin);
+        m_cpu.write(Register_eip, eip ); // so the faulty instruction can be retrieved
+        throw;
+    }
+#undef VM_EXEC_OPERATOR
+#undef VM_EXEC_JUMP
+#undef VM_EXEC_CALL
+#undef VM_EXEC_WRITE
+#undef VM_EXEC
+#undef VM_NEXT
+#undef VM_TRACE
+#undef VM_PROFILE
+#undef VM_SLICE
+#undef VM_MEMORY
+#undef VM_LOOP
+#undef VM_INVALID
+#undef VM_CASE
+#undef VM_DISPATCH
+
+exit:
+    if constexpr ( SLICED )
+    {
+        m_slice.granted -= slice_steps; // granted, but not run
+    }
+    if constexpr ( PROFILE )
+    {
+        current_sample->nanoseconds += clock_now() - sample_begin; // last instruction run (the program might be suspended after a long one)
+    }
+    qword eip;
+    eip.u64 = (u64_t)(instr - begin);
+    m_cpu.write(Register_eip, eip );
+}
+
+void Interpreter::stop_program()
+{
+    if ( m_is_program_running )
+    {
+        m_is_program_running = false;
+        m_is_debugging       = false;
+        m_next_node          = {};
+        LOG_MESSAGE("Interpreter", "Program stopped\n");
+    }
+    else
+    {
+        LOG_ERROR("Interpreter", "stop_program() failed, program is not running\n");
+    }
+}
+
+const Code* Interpreter::release_program()
+{
+    if( m_is_program_running )
+    {
+        LOG_VERBOSE("Interpreter", "stopping program before continue\n");
+        stop_program();
+    }
+
+    m_cpu.clear_registers(); // will also clear reset instruction pointer (stored in a register Register_eip)
+    m_stack.clear();
+    LOG_VERBOSE("Interpreter", "registers and stack cleared\n");
+
+    LOG_VERBOSE("Interpreter", "program released\n");
+    const Code* copy = m_code;
+    m_code = nullptr;
+    m_breakpoints.bind(nullptr);
+    m_trap_code.clear();
+    update_jit_code();
+    return copy;
+}
+
+bool Interpreter::step_over()
+{
+    const Instruction* next_instr = get_next_instr();
+
+    if ( m_trace != nullptr )
+    {
+        m_trace->push(m_cpu.read(Register_eip).u64, next_instr->opcode, m_cpu.read(Register_rax));
+    }
+
+    switch ( next_instr->opcode )
+    {
+        case OpCode_cmp:              exec_cmp(*next_instr); break;
+        case OpCode_deref_qword:      exec_deref_qword(*next_instr); break;
+        case OpCode_mov:              exec_mov(*next_instr); break;
+        case OpCode_push_var:         exec_push_var(*next_instr); break;
+        case OpCode_push_stack_frame: exec_push_stack_frame(*next_instr); break;
+        case OpCode_pop_stack_frame:  exec_pop_stack_frame(*next_instr); break;
+        case OpCode_push_const:       exec_push_const(*next_instr); break;
+        case OpCode_load:             exec_load(*next_instr); break;
+        case OpCode_load_ref:         exec_load_ref(*next_instr); break;
+        case OpCode_store:            exec_store(*next_instr); break;
+        case OpCode_load_reg:         exec_load_reg(*next_instr); break;
+        case OpCode_store_reg:        exec_store_reg(*next_instr); break;
+        case OpCode_pop:              exec_pop(*next_instr); break;
+        case OpCode_call:             exec_call(*next_instr); break;
+        case OpCode_dataflow:         exec_dataflow(*next_instr); break;
+        case OpCode_call_native:      exec_call_native(*next_instr); break;
+        case OpCode_load_input:       exec_load_input(*next_instr); break;
+#define CASE_OPERATOR(name, ...) case OpCode_##name: exec_##name(m_stack); break;
+        NDBL_TYPED_OPERATORS(CASE_OPERATOR)
+#undef CASE_OPERATOR
+
+        case OpCode_jmp:              advance_cursor( exec_jmp(*next_instr) ); return false;
+        case OpCode_jne:              advance_cursor( exec_jne(*next_instr) ); return false;
+        case OpCode_pop_jne:          advance_cursor( exec_pop_jne(*next_instr) ); return false;
 
         case OpCode_ret:
-            //advance_cursor();
-            success = false;
-            break;
+            return false;
 
         default:
-            advance_cursor();
-            success = false;
+            break;
     }
 
-    return success;
+    advance_cursor();
+    return false;
 }
 
 bool Interpreter::debug_step_over()
 {
     auto must_break = [&]() -> bool {
         return
-                get_next_instr()->opcode == OpCode_call
+                ( get_next_instr()->opcode == OpCode_call || get_next_instr()->opcode == OpCode_call_native || get_next_instr()->opcode == OpCode_dataflow || get_next_instr()->is_operator() )
                && m_last_step_next_instr != get_next_instr();
     };
 
@@ -309,42 +957,102 @@ bool Interpreter::debug_step_over()
     }
     else
     {
-        // update m_current_node and m_last_step_instr
+        // update m_next_node and m_last_step_instr
         m_last_step_next_instr = get_next_instr();
-        auto next_instr = get_next_instr();
+        m_next_node            = m_breakpoints.get_node(m_cpu.read(Register_eip).u64);
+        LOG_MESSAGE("Interpreter", "Step over (current line %#1llx)\n", m_cpu.read(Register_eip).u64);
+    }
 
-        switch ( next_instr->opcode )
-        {
-            case OpCode_call:
-            {
-                VERIFY(false, "Not implemented, we might add break points in a dedicated data structure instead of storing a child reference in the instruction");
-//                m_next_node = next_instr->eval.invokable;
-                break;
-            }
+    return continue_execution;
+}
 
-            default:
-                break;
-        }
-        LOG_MESSAGE("Interpreter", "Step over (current line %#1llx)\n", next_instr->line);
+bool Interpreter::debug_continue()
+{
+    ASSERT(m_is_debugging);
+
+    // when paused on a breakpoint, its instruction is run first (otherwise it would trap again)
+    if ( m_breakpoints.has_instruction(m_cpu.read(Register_eip).u64) && m_last_step_next_instr == get_next_instr() )
+    {
+        step_over();
     }
 
-    return continue_execution;
+    try
+    {
+        execute(m_trap_code.empty() ? m_code->data() : m_trap_code.data());
+    }
+    catch (...)
+    {
+        stop_program();
+        throw;
+    }
+
+    const u64_t eip = m_cpu.read(Register_eip).u64;
+    if ( m_trap_code.empty() || m_trap_code[eip].opcode != OpCode_trap )
+    {
+        stop_program();
+        m_last_step_next_instr = {};
+        LOG_MESSAGE("Interpreter", "Program terminated\n");
+        return false;
+    }
+
+    m_last_step_next_instr = get_next_instr();
+    m_next_node            = m_breakpoints.get_node(eip);
+    LOG_MESSAGE("Interpreter", "Breakpoint hit (current line %#1llx)\n", eip);
+    return true;
+}
+
+void Interpreter::set_breakpoint(const Node* _node, bool _enabled)
+{
+    m_breakpoints.set(_node, _enabled);
+    update_trap_code();
+}
+
+void Interpreter::clear_breakpoints()
+{
+    m_breakpoints.clear();
+    update_trap_code();
+}
+
+void Interpreter::update_trap_code()
+{
+    m_trap_code.clear();
+    if ( m_code == nullptr || m_breakpoints.empty() )
+    {
+        return;
+    }
+    m_trap_code.assign(m_code->data(), m_code->data() + m_code->size());
+    for ( size_t i = 0; i < m_trap_code.size(); ++i )
+    {
+        if ( m_breakpoints.has_instruction(i) )
+        {
+            m_trap_code[i].opcode = OpCode_trap;
+        }
+    }
 }
 
 void Interpreter::debug_program()
 {
+    // debugging steps node by node, a code without graph can't be debugged (ex: loaded from a bytecode file, cf. Bytecode::load())
+    if ( graph() == nullptr )
+    {
+        LOG_ERROR("Interpreter", "Unable to debug program. Code has no graph.\n");
+        return;
+    }
+
     Optional<Node*> root = graph()->root();
-    if( root )
+    if( !root )
     {
         LOG_ERROR("Interpreter", "Unable to debug program. Graph has no root.\n");
         return;
     }
 
-    m_is_debugging       = true;
-    m_is_program_running = true;
-    m_next_node          = root.get();
+    m_is_debugging         = true;
+    m_is_program_running   = true;
+    m_next_node            = root.get();
+    m_last_step_next_instr = {};
 
     m_cpu.clear_registers();
+    m_stack.clear();
     m_visited_nodes.clear();
 
     LOG_MESSAGE("Interpreter", "Debugging program ...\n");
@@ -361,7 +1069,7 @@ qword Interpreter::get_last_result()const
     return m_cpu.read(Register_rax);
 }
 
-Instruction* Interpreter::get_next_instr() const
+const Instruction* Interpreter::get_next_instr() const
 {
     if ( is_there_a_next_instr() )
     {
@@ -376,43 +1084,74 @@ bool Interpreter::load_program(const Code *_code)
     ASSERT(!m_code);     // dev must unload before to load.
 
     m_code = _code;
+    if ( !m_code || m_code->size() == 0 )
+    {
+        return false;
+    }
 
-    return m_code && m_code->size() != 0;
+    // run_program() does not check bounds when stepping, the last instruction must stop the program.
+    if ( m_code->get_instructions().back().opcode != OpCode_ret )
+    {
+        LOG_ERROR("Interpreter", "Unable to load program, it must end with an OpCode_ret\n");
+        return false;
+    }
+
+    m_stack.reserve( m_code->get_meta_data().stack_size );
+    m_breakpoints.bind(m_code);
+    update_trap_code();
+    update_jit_code();
+    return true;
 }
 
-qword Interpreter::read_cpu_register(Register _register)const
+void Interpreter::set_jit_enabled(bool _enabled)
 {
-    return m_cpu.read(_register);
+    ASSERT(!m_is_program_running);
+    m_jit_enabled = _enabled && Jit::is_supported();
+    update_jit_code();
 }
 
-const Code *Interpreter::get_program_asm_code()
+void Interpreter::update_jit_code()
 {
-    return m_code;
+    if ( !m_jit_enabled || m_code == nullptr )
+    {
+        if ( m_jit != nullptr )
+            m_jit->release();
+        return;
+    }
+    if ( m_jit == nullptr )
+    {
+        m_jit = std::make_unique<Jit>();
+    }
+    if ( !m_jit->compile(m_code) )
+    {
+        LOG_VERBOSE("Interpreter", "Unable to compile the program to machine code, it will be interpreted\n");
+    }
 }
 
-bool Interpreter::was_visited(const Node* node) const
+Interpreter::Operator Interpreter::get_operator(OpCode _opcode)
 {
-    return m_visited_nodes.find(node) != m_visited_nodes.end();
+    switch ( _opcode )
+    {
+#define CASE_OPERATOR(name, ...) case OpCode_##name: return &exec_##name;
+        NDBL_TYPED_OPERATORS(CASE_OPERATOR)
+#undef CASE_OPERATOR
+        default:
+            return nullptr;
+    }
 }
 
-Interpreter* ndbl::get_interpreter()
+qword Interpreter::read_cpu_register(Register _register)const
 {
-    return g_interpreter;
+    return m_cpu.read(_register);
 }
 
-Interpreter* ndbl::init_interpreter()
+const Code *Interpreter::get_program_asm_code()
 {
-    ASSERT(g_interpreter == nullptr); // singleton
-    g_interpreter = new Interpreter();
-    return g_interpreter;
+    return m_code;
 }
 
-void ndbl::shutdown_interpreter(Interpreter* _interpreter)
+bool Interpreter::was_visited(const Node* node) const
 {
-    ASSERT(g_interpreter == _interpreter); // singleton
-    ASSERT(g_interpreter != nullptr);
-    g_interpreter->release_program();
-    delete g_interpreter;
-    g_interpreter = nullptr;
+    return m_visited_nodes.find(node) != m_visited_nodes.end();
 }
 
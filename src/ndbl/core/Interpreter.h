@@ -1,9 +1,23 @@
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
 #include "tools/core/types.h"
+#include "tools/core/reflection/variant.h"
 
+#include "Breakpoints.h"
 #include "Compiler.h"
+#include "Jit.h"
+#include "Profiler.h"
 #include "Register.h"
+#include "Trace.h"
+
+namespace tools
+{
+    // forward declarations
+    class ThreadPool;
+}
 
 namespace ndbl
 {
@@ -22,51 +36,213 @@ namespace ndbl
         void          clear_registers();             // Clear all registers
 
     private:
+        friend class Jit;
         tools::qword& read_write(Register); // Read a given register by reference with write mode
         tools::qword  m_register[Register_COUNT]; // Store all registers
     };
 
+    /**
+     * Contiguous stack of values, split in frames (one per Scope being executed).
+     * Storage is reserved when a program is loaded and reused between runs, push/pop never allocate.
+     * A frame is an arena: its variable slots are reserved at once when it is pushed, and released at once (with any temporary on top) when popped.
+     */
+    class Stack
+    {
+    public:
+        void            reserve(size_t _size);                   // Ensure the stack can store a given slot count (invalidates any pointer to a slot)
+        void            clear();                                 // Pop all the values and frames (storage is kept)
+        tools::variant* push()                                   { ASSERT(m_top < m_values.size()); return &m_values[m_top++]; } // Push a new slot on top, returns its address (value is the previous one stored in that slot)
+        void            pop(size_t _count = 1)                   { ASSERT(m_top >= _count); m_top -= _count; } // Pop a given slot count
+        tools::variant& top(size_t _offset = 0)                  { ASSERT(_offset < m_top); return m_values[m_top - 1 - _offset]; } // Get the slot at a given offset from the top
+        tools::variant& at(size_t _index)                        { ASSERT(_index < m_top); return m_values[_index]; } // Get the slot at a given absolute index
+        size_t          size() const                             { return m_top; }
+        size_t          capacity() const                         { return m_values.size(); }
+        size_t          get_memory() const                       { return m_values.capacity() * sizeof(tools::variant) + m_frame.capacity() * sizeof(size_t) + m_held_total; } // Get the bytes held by the slots, their values included (ex: strings) as last measured. Popped slots are included, they keep their value.
+        void            measure();                               // Measure the bytes held by each slot's value (cf. get_memory())
+        void            measure(const tools::variant* _slot);    // Measure the bytes held by a given slot's value again, once it is written (constant time)
+        void            push_frame(size_t _size = 0)             { ASSERT(m_top + _size <= m_values.size()); m_frame.push_back(m_top); m_top += _size; } // Start a new frame at the current top, reserving a given slot count (slots keep their previous value)
+        void            pop_frame()                              { ASSERT(!m_frame.empty()); m_top = m_frame.back(); m_frame.pop_back(); } // Pop all the slots pushed since the last push_frame()
+    private:
+        friend class Jit;
+        std::vector<tools::variant> m_values;  // Slots storage (size is the stack capacity)
+        std::vector<size_t>         m_frame;   // Top index when each frame was pushed
+        std::vector<size_t>         m_held;    // Bytes held by each slot's value, as last measured (ex: a string's capacity)
+        size_t                      m_held_total = 0; // Sum of m_held
+        size_t                      m_top = 0; // Index of the next free slot
+    };
+
+    // Status of a program run (cf. Interpreter::run_program(), Interpreter::run_steps(), Interpreter::run_for())
+    typedef int RunStatus;
+    enum RunStatus_
+    {
+        RunStatus_DONE            = 0, // The program returned, it is stopped.
+        RunStatus_SUSPENDED       = 1, // The slice is over, the program is still running: the next slice resumes it.
+        RunStatus_BUDGET_EXCEEDED = 2, // The program exceeded its budget, it is stopped (cf. Usage::exceeded).
+    };
+
+    // Limits of a program run, 0 for none (cf. Interpreter::set_budget())
+    struct Budget
+    {
+        u64_t  instructions = 0; // instruction count
+        u64_t  nanoseconds  = 0; // time spent running (the time between two slices does not count)
+        size_t memory       = 0; // bytes held by the stack (cf. Stack::get_memory())
+    };
+
+    typedef int BudgetFlags;
+    enum BudgetFlag_
+    {
+        BudgetFlag_NONE         = 0,
+        BudgetFlag_INSTRUCTIONS = 1 << 0,
+        BudgetFlag_TIME         = 1 << 1,
+        BudgetFlag_MEMORY       = 1 << 2,
+    };
+
+    // Resources used by a program run limited by a budget or run by slices (cf. Interpreter::get_usage())
+    struct Usage
+    {
+        u64_t       instructions = 0;
+        u64_t       nanoseconds  = 0;
+        size_t      memory       = 0;                // maximum reached when the memory is limited, measured after each instruction writing a slot (a string is only created by a call or copied)
+        BudgetFlags exceeded     = BudgetFlag_NONE;  // limits exceeded (cf. RunStatus_BUDGET_EXCEEDED)
+    };
+
+    /**
+     * Values of an input variable, one per row (cf. Interpreter::run_batch()).
+     * Values are not copied, they must stay valid while the batch runs.
+     */
+    struct Column
+    {
+        std::string                  name;   // input variable's identifier
+        const tools::TypeDescriptor* type;   // values type: bool, i32_t or double
+        const void*                  data;   // values, contiguous
+
+        template<typename T>
+        static Column of(const std::string& _name, const T* _values) { return { _name, tools::type::get<T>(), _values }; }
+    };
+
     /**
      * The Interpreter is able to run the Code produced by the Compiler
+     *
+     * Thread-safety: an Interpreter owns its CPU and Stack, several instances can run at the same time (one thread each),
+     * the same Code or different ones. While they run, the Code, its Graph and the language (Nodlang, reflected types) are
+     * only read, they must not be modified. A single instance is not thread-safe.
     */
     class Interpreter
     {
     public:
-        [[nodiscard]] bool    load_program(const Code *_code);
+        static constexpr u64_t SLICE_CLOCK_PERIOD = 1024; // Instruction count between two clock reads when running for a given duration (cf. run_for())
+
+        [[nodiscard]] bool    load_program(const Code *_code); // Load a given program, it must end with an OpCode_ret.
         const Code*           release_program();  // Release any loaded program
-        void                  run_program(); // Run loaded program. Check load_program()'s return value before to run.*/
+        RunStatus             run_program(); // Run loaded program. Check load_program()'s return value before to run. Returns RunStatus_BUDGET_EXCEEDED when stopped by the budget (cf. set_budget()), RunStatus_DONE otherwise.
+        void                  start_program(); // Start the loaded program without running it, it is then run by slices (cf. run_steps(), run_for()).
+        RunStatus             run_steps(u64_t _count); // Resume the program started, run at most a given instruction count. The program is stopped once it returns (cf. RunStatus).
+        RunStatus             run_for(u64_t _nanoseconds); // Same as run_steps() for a given duration, the clock is read every SLICE_CLOCK_PERIOD instructions (a slow function call can't be preempted).
+        void                  set_budget(const Budget& _budget) { m_budget = _budget; if ( m_budget.memory != 0 ) m_stack.measure(); } // Limit the next runs (run_program(), or a program started then run by slices), a run exceeding it is stopped. run_batch() and debugging ignore it.
+        const Budget&         get_budget() const { return m_budget; }
+        bool                  has_budget() const { return m_budget.instructions != 0 || m_budget.nanoseconds != 0 || m_budget.memory != 0; }
+        const Usage&          get_usage() const { return m_usage; } // Get the resources used by the last run limited by a budget, or run by slices.
+        std::vector<tools::qword> run_batch(const std::vector<Column>&, size_t _row_count); // Run the loaded program once per row (cf. Compiler::compile_batch()), columns must be in the program's input order. Returns each row's result (cf. get_last_result()).
         void                  stop_program();
-        void                  debug_program(); // Run the program in debug mode. Then call step_over() to advance step by step.
+        void                  debug_program(); // Run the program in debug mode. Then call step_over() to advance step by step. The code must have a graph (a code loaded from a bytecode file has none).
         bool                  debug_step_over(); // Execute the next instruction. Works only in debug mode, use debug_program() and is_debugging()
+        bool                  debug_continue(); // Run until the next breakpoint (returns true, the program is still debugged) or until the end (returns false). Works only in debug mode.
+        void                  set_breakpoint(const Node*, bool _enabled = true); // Break before a given node runs (cf. debug_continue()), the code must have debug info (cf. CompilerFlag_DEBUG_INFO).
+        bool                  has_breakpoint(const Node* _node) const { return m_breakpoints.has(_node); }
+        void                  clear_breakpoints();
+        const Breakpoints&    get_breakpoints() const { return m_breakpoints; }
         inline bool           is_program_running() const{ return m_is_program_running; }
         inline bool           is_debugging() const{ return m_is_debugging; }
         inline bool           is_program_stopped() const{ return !m_is_debugging && !m_is_program_running; }
         inline const Node*    get_next_node() const {return m_next_node; } // Get the next node to be executed. Works in debug mode only.
         tools::qword          get_last_result() const; // Get the last instruction's result
         bool                  is_there_a_next_instr() const; // Check if there is a next instruction (internally check instruction pointer's position)
-        Instruction*          get_next_instr() const; // Get the next instruction to execute
+        const Instruction*    get_next_instr() const; // Get the next instruction to execute
         tools::qword          read_cpu_register(Register _register) const; // Read a given CPU register
+        const Stack&          get_stack() const { return m_stack; } // Get the value stack
         const Code *          get_program_asm_code(); // Get current program ptr
         bool                  is_next_node(const Node* _node)const { return m_next_node == _node; } // Check if a given Node is the next to be executed
         bool                  was_visited(const Node *) const;
+        void                  set_profiler(Profiler* _profiler) { m_profiler = _profiler; } // Profile the next runs with a given Profiler (nullptr to stop profiling).
+        Profiler*             get_profiler() const { return m_profiler; }
+        void                  set_trace(Trace* _trace) { m_trace = _trace; } // Record each instruction executed into a given Trace (nullptr to stop tracing).
+        Trace*                get_trace() const { return m_trace; }
+        void                  set_thread_pool(tools::ThreadPool* _pool) { m_thread_pool = _pool; } // Run the dataflows' tasks (cf. OpCode_dataflow) with a given pool (nullptr for the shared one).
+        tools::ThreadPool*    get_thread_pool() const { return m_thread_pool != nullptr ? m_thread_pool : &get_shared_thread_pool(); }
+        static tools::ThreadPool& get_shared_thread_pool(); // Get the pool used by the interpreters having none set (cf. set_thread_pool()), created on first use.
+        void                  set_jit_enabled(bool _enabled); // Translate the programs loaded to machine code (cf. Jit), run_program() then runs it unless the run is limited by a budget, profiled or traced. Ignored when unsupported (cf. Jit::is_supported()).
+        bool                  is_jit_enabled() const { return m_jit_enabled; }
+        bool                  is_jit_compiled() const { return m_jit != nullptr && m_jit->is_compiled(); } // Check if the program loaded was translated to machine code (a code having an instruction without template is not).
 
     private:
+        friend class Jit;
+        typedef void (*Operator)(Stack&);
+
+        // Budget of the slice being run (cf. run_steps(), run_for())
+        struct Slice
+        {
+            u64_t steps     = 0;     // instructions left to run
+            u64_t deadline  = 0;     // time point (in nanoseconds) to suspend at, 0 for none
+            u64_t begin     = 0;     // time point the slice began at
+            u64_t granted   = 0;     // instructions the dispatch loop runs before to check the slice again (cf. next_slice_steps())
+            bool  suspended = false; // true when the slice ended before the program returned
+        };
+
         void                  advance_cursor(i64_t _amount = 1);// Advance the instruction pointer of a given amount
-        bool                  step_over(); // Step over common code (for both "run" and "debug" modes)
-        inline const Graph*   graph() { ASSERT(m_code); return m_code->get_meta_data().graph; }
+        void                  update_trap_code(); // Copy the code with an OpCode_trap swapped in at each breakpoint (cf. m_trap_code).
+        void                  update_jit_code(); // Translate the code loaded to machine code when the JIT is enabled, release it otherwise (cf. m_jit).
+        static Operator       get_operator(OpCode); // Get the function of a typed operator (cf. Instruction::is_operator()), nullptr for other opcodes.
+        bool                  step_over(); // Step over a single instruction (debug mode), run_program() has its own dispatch loop.
+        void                  execute(const Instruction*, bool _sliced = false); // Run given instructions (the code's, or m_trap_code) from the instruction pointer until an OpCode_ret or an OpCode_trap (or the end of the slice when sliced, cf. m_slice), the instruction pointer is written back when exiting (even on error).
+        template<bool PROFILE, bool TRACE, bool SLICED>
+        void                  execute_ex(const Instruction*); // Same as execute(), PROFILE records each instruction's samples (cf. Profiler), TRACE records each instruction (cf. Trace), SLICED counts them (cf. m_slice). Without all, this is the regular dispatch loop.
+        RunStatus             run_slice(u64_t _steps, u64_t _deadline); // Common part of run_steps() and run_for(), and run_program() when limited by a budget.
+        u64_t                 next_slice_steps(); // Get the instruction count the dispatch loop can run before to call this again, 0 when the slice is over or the budget is exceeded.
+        bool                  check_memory(const Instruction&); // Measure the memory used once a given instruction ran (only the slots it wrote), returns false when it exceeds the budget.
+        // Opcode semantics, shared by step_over() and run_program() (ret is handled by the callers)
+        void                  exec_cmp(const Instruction&);
+        void                  exec_deref_qword(const Instruction&);
+        void                  exec_mov(const Instruction&);
+        void                  exec_push_var(const Instruction&);
+        void                  exec_push_stack_frame(const Instruction&);
+        void                  exec_pop_stack_frame(const Instruction&);
+        void                  exec_push_const(const Instruction&);
+        void                  exec_load(const Instruction&);
+        void                  exec_load_ref(const Instruction&);
+        void                  exec_store(const Instruction&);
+        void                  exec_load_reg(const Instruction&);
+        void                  exec_store_reg(const Instruction&);
+        void                  exec_pop(const Instruction&);
+        void                  exec_call(const Instruction&);
+        void                  exec_call_native(const Instruction&);
+        void                  exec_dataflow(const Instruction&);
+        void                  exec_load_input(const Instruction&);
+        i64_t                 exec_jmp(const Instruction&);     // Returns the offset to apply to the instruction pointer.
+        i64_t                 exec_jne(const Instruction&);     // Returns the offset to apply to the instruction pointer.
+        i64_t                 exec_pop_jne(const Instruction&); // Returns the offset to apply to the instruction pointer.
+        inline const Graph*   graph() { ASSERT(m_code); return m_code->get_meta_data().graph; } // nullptr when the code has no graph (cf. Bytecode::load())
         CPU                   m_cpu;
+        Stack                 m_stack;
+        std::vector<tools::variant*> m_call_args;                     // Arguments buffer for OpCode_call, reused to avoid allocations
+        tools::ThreadPool*    m_thread_pool          = nullptr;       // Runs the dataflows' tasks when set (cf. set_thread_pool())
+        const std::vector<Column>* m_batch_columns = nullptr;         // Input columns of the batch being run (cf. run_batch())
+        size_t                m_batch_row            = 0;             // Row being run
+        Profiler*             m_profiler             = nullptr;       // Samples the runs when set (cf. set_profiler())
+        Trace*                m_trace                = nullptr;       // Records the instructions executed when set (cf. set_trace())
+        Breakpoints           m_breakpoints;
+        Slice                 m_slice;
+        Budget                m_budget;
+        Usage                 m_usage;
+        std::vector<Instruction> m_trap_code;                         // Copy of the code run by debug_continue(), with an OpCode_trap at each breakpoint (empty without breakpoints)
+        std::unique_ptr<Jit>  m_jit;                                  // Machine code of the program loaded (cf. set_jit_enabled()), created on first use
+        bool                  m_jit_enabled          = false;
         bool                  m_is_program_running   = false; // TODO: use StateMachine
         bool                  m_is_debugging         = false; // TODO: use StateMachine
         const Code*           m_code                 = nullptr;
         const Node*           m_next_node            = nullptr;
-        Instruction*          m_last_step_next_instr = nullptr;
+        const Instruction*    m_last_step_next_instr = nullptr;
         std::set<const Node*> m_visited_nodes;
     };
-
-    [[nodiscard]]
-    Interpreter* init_interpreter(); // note: store ptr, you'll need it to shut it down.
-    Interpreter* get_interpreter();
-    void         shutdown_interpreter(Interpreter*); // Undo init_interpreter()
 }
 
 
@@ -1,16 +1,22 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "fixtures/core.h"
 #include "glm/exponential.hpp" // for pow()
 
 using namespace ndbl;
-typedef ::testing::Core DISABLED_Interpreter_;
+typedef ::testing::Core Interpreter_;
 
-TEST_F(DISABLED_Interpreter_, variable_1 )
+TEST_F(Interpreter_, variable_1 )
 {
     EXPECT_EQ(eval<i32_t>("int i = 10"), 10);
 }
 
-TEST_F(DISABLED_Interpreter_, Cond_1)
+TEST_F(Interpreter_, Cond_1)
 {
     std::string program =
         "if(false)"
@@ -23,7 +29,7 @@ TEST_F(DISABLED_Interpreter_, Cond_1)
     EXPECT_EQ(eval<i32_t>(program), 42);
 }
 
-TEST_F(DISABLED_Interpreter_, Cond_2)
+TEST_F(Interpreter_, Cond_2)
 {
     std::string program =
             "int bob   = 50;"
@@ -42,7 +48,7 @@ TEST_F(DISABLED_Interpreter_, Cond_2)
     EXPECT_EQ(eval<i32_t>(program), 50);
 }
 
-TEST_F(DISABLED_Interpreter_, Cond_3)
+TEST_F(Interpreter_, Cond_3)
 {
     std::string program =
             "int bob   = 0;"
@@ -61,7 +67,7 @@ TEST_F(DISABLED_Interpreter_, Cond_3)
     EXPECT_EQ(eval<std::string>(program), "false");
 }
 
-TEST_F(DISABLED_Interpreter_, Loop_1_using_global_var)
+TEST_F(Interpreter_, Loop_1_using_global_var)
 {
     std::string program =
             "string str = \"\";"
@@ -74,7 +80,7 @@ TEST_F(DISABLED_Interpreter_, Loop_1_using_global_var)
     EXPECT_EQ(eval<std::string>(program), "0123456789");
 }
 
-TEST_F(DISABLED_Interpreter_, Loop_1_using_local_var)
+TEST_F(Interpreter_, Loop_1_using_local_var)
 {
     std::string program =
             "string str = \"\";"
@@ -88,7 +94,7 @@ TEST_F(DISABLED_Interpreter_, Loop_1_using_local_var)
     EXPECT_EQ(eval<std::string>(program), "0123456789");
 }
 
-TEST_F(DISABLED_Interpreter_, Loop_2_using_global_var)
+TEST_F(Interpreter_, Loop_2_using_global_var)
 {
     std::string program =
             "int n;"
@@ -112,7 +118,7 @@ TEST_F(DISABLED_Interpreter_, Loop_2_using_global_var)
     EXPECT_EQ(eval<std::string>(program), "__49162536496481");
 }
 
-TEST_F(DISABLED_Interpreter_, Loop_2_using_local_var)
+TEST_F(Interpreter_, Loop_2_using_local_var)
 {
     std::string program =
             "string str = \"\";"
@@ -133,7 +139,7 @@ TEST_F(DISABLED_Interpreter_, Loop_2_using_local_var)
     EXPECT_EQ(eval<std::string>(program), "__49162536496481");
 }
 
-TEST_F(DISABLED_Interpreter_, For_loop_without_var_decl)
+TEST_F(Interpreter_, For_loop_without_var_decl)
 {
     std::string program =
             "int score;"
@@ -145,7 +151,7 @@ TEST_F(DISABLED_Interpreter_, For_loop_without_var_decl)
     EXPECT_EQ(eval<i32_t>(program), 9 * 2);
 }
 
-TEST_F(DISABLED_Interpreter_, For_loop_with_var_decl)
+TEST_F(Interpreter_, For_loop_with_var_decl)
 {
     std::string program =
             "int score = 1;"
@@ -157,7 +163,7 @@ TEST_F(DISABLED_Interpreter_, For_loop_with_var_decl)
     EXPECT_EQ(eval<i32_t>(program), 1 * glm::pow(2, 10));
 }
 
-TEST_F(DISABLED_Interpreter_, declare_then_define)
+TEST_F(Interpreter_, declare_then_define)
 {
     std::string program_01 =
             "int b;"
@@ -166,7 +172,7 @@ TEST_F(DISABLED_Interpreter_, declare_then_define)
     EXPECT_EQ(eval<i32_t>(program_01), 5);
 }
 
-TEST_F(DISABLED_Interpreter_, declare_and_define_then_reassign)
+TEST_F(Interpreter_, declare_and_define_then_reassign)
 {
     std::string program_01 =
             "int b = 6;"
@@ -175,7 +181,7 @@ TEST_F(DISABLED_Interpreter_, declare_and_define_then_reassign)
     EXPECT_EQ(eval<i32_t>(program_01), 5);
 }
 
-TEST_F(DISABLED_Interpreter_, declare_then_define_then_reassign)
+TEST_F(Interpreter_, declare_then_define_then_reassign)
 {
     std::string program_01 =
             "int b;"
@@ -185,7 +191,7 @@ TEST_F(DISABLED_Interpreter_, declare_then_define_then_reassign)
     EXPECT_EQ(eval<i32_t>(program_01), 5);
 }
 
-TEST_F(DISABLED_Interpreter_, condition_which_contains_alterated_var)
+TEST_F(Interpreter_, condition_which_contains_alterated_var)
 {
     std::string program =
             "int b = 6;"
@@ -199,7 +205,7 @@ TEST_F(DISABLED_Interpreter_, condition_which_contains_alterated_var)
     EXPECT_EQ(eval<std::string>(program), "ok");
 }
 
-TEST_F(DISABLED_Interpreter_, else_elseif_else)
+TEST_F(Interpreter_, else_elseif_else)
 {
 
     std::string program_end =
@@ -223,14 +229,14 @@ TEST_F(DISABLED_Interpreter_, else_elseif_else)
     EXPECT_EQ(eval<std::string>(program3), "a == b");
 }
 
-TEST_F(DISABLED_Interpreter_, integers)
+TEST_F(Interpreter_, integers)
 {
     EXPECT_EQ(eval<i32_t>("int i = 1"), 1);
     EXPECT_EQ(eval<i32_t>("int i = 3 + 5"), 8);
     EXPECT_EQ(eval<i32_t>("int i = 1-2"), -1);
 }
 
-TEST_F(DISABLED_Interpreter_, while_loop)
+TEST_F(Interpreter_, while_loop)
 {
     tools::log::set_verbosity(tools::log::Verbosity_Message);
     std::string program =
@@ -241,4 +247,320 @@ TEST_F(DISABLED_Interpreter_, while_loop)
             "return(i)";
 
     EXPECT_EQ( eval<i32_t>(program), 42);
-}
\ No newline at end of file
+}
+TEST_F(Interpreter_, typed_operators_i32)
+{
+    const std::string vars = "int a = 7; int b = 2; ";
+    EXPECT_EQ(eval<i32_t>(vars + "int r = a + b; return(r);"), 9);
+    EXPECT_EQ(eval<i32_t>(vars + "int r = a - b; return(r);"), 5);
+    EXPECT_EQ(eval<i32_t>(vars + "int r = a * b; return(r);"), 14);
+    EXPECT_EQ(eval<i32_t>(vars + "int r = a / b; return(r);"), 3);
+    EXPECT_EQ(eval<i32_t>(vars + "int r = -a; return(r);"), -7);
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a > b; return(r);"));
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a >= b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a < b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a <= b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a == b; return(r);"));
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a != b; return(r);"));
+}
+
+TEST_F(Interpreter_, typed_operators_f64)
+{
+    const std::string vars = "double a = 1.5; double b = 0.5; ";
+    EXPECT_EQ(eval<double>(vars + "double r = a + b; return(r);"), 2.0);
+    EXPECT_EQ(eval<double>(vars + "double r = a - b; return(r);"), 1.0);
+    EXPECT_EQ(eval<double>(vars + "double r = a * b; return(r);"), 0.75);
+    EXPECT_EQ(eval<double>(vars + "double r = a / b; return(r);"), 3.0);
+    EXPECT_EQ(eval<double>(vars + "double r = -a; return(r);"), -1.5);
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a > b; return(r);"));
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a >= b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a < b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a <= b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a == b; return(r);"));
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a != b; return(r);"));
+}
+
+TEST_F(Interpreter_, typed_operators_bool)
+{
+    const std::string vars = "bool a = true; bool b = false; ";
+    EXPECT_FALSE(eval<bool>(vars + "bool r = !a; return(r);"));
+    EXPECT_TRUE(eval<bool>(vars + "bool r = a != b; return(r);"));
+    EXPECT_FALSE(eval<bool>(vars + "bool r = a <=> b; return(r);"));
+}
+
+TEST_F(Interpreter_, operators_are_compiled_to_typed_opcodes)
+{
+    const Code* code = app.compile( app.parse("int a = 7; int b = 2; int r = a + b * a; return(r);") );
+    EXPECT_EQ(count_opcode(code, OpCode_call, OpCode_call_native), 1); // return(r) only, "+" is resolved to int +(int, int) since "b * a" is an int
+    delete code;
+}
+
+TEST_F(Interpreter_, mixed_type_operators_are_compiled_to_calls)
+{
+    const Code* code = app.compile( app.parse("int a = 7; double b = 2.0; double r = b * a; return(r);") );
+    EXPECT_EQ(count_opcode(code, OpCode_call, OpCode_call_native), 2); // double * int has no typed opcode
+    EXPECT_EQ(eval<double>("int a = 7; double b = 2.0; double r = b * a; return(r);"), 14.0);
+    delete code;
+}
+
+TEST_F(Interpreter_, calls_with_exact_argument_types_are_native)
+{
+    const char* program = "double a = 9.0; int n = 2; double r = pow(a, 0.5) + mod(a, n); return(r);";
+    const Code* code    = app.compile( app.parse(program) );
+    size_t native_count = 0;
+    size_t call_count   = 0;
+    for( const Instruction& each : code->get_instructions() )
+    {
+        native_count += each.opcode == OpCode_call_native;
+        call_count   += each.opcode == OpCode_call;
+    }
+    EXPECT_EQ(native_count, 2); // pow(double, double) and return(double)
+    EXPECT_EQ(call_count, 1);   // mod(double, double) called with an int needs a conversion
+    EXPECT_EQ(eval<double>(program), 4.0);
+    delete code;
+}
+
+TEST_F(Interpreter_, run_batch_runs_the_program_once_per_row)
+{
+    const double x[] = { 0.0, 1.5, -2.0, 10.0 };
+    const i32_t  n[] = { 1, 2, 3, 4 };
+    app.parse("double x = 0.0; int n = 0; double r = x * 2.0; if( n > 2 ){ r = r + n; } return(r);");
+
+    const std::vector<tools::qword> results = app.run_batch({ Column::of("x", x), Column::of("n", n) }, 4);
+
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_DOUBLE_EQ(results[0].d, 0.0);
+    EXPECT_DOUBLE_EQ(results[1].d, 3.0);
+    EXPECT_DOUBLE_EQ(results[2].d, -1.0);
+    EXPECT_DOUBLE_EQ(results[3].d, 24.0);
+}
+
+TEST_F(Interpreter_, run_batch_loads_back_the_previous_program)
+{
+    const double x[] = { 1.0, 2.0 };
+    app.parse("double x = 4.0; double r = x * x; return(r);");
+    const Code* code = app.compile( app.get_graph() );
+    ASSERT_TRUE(app.load_program(code));
+
+    const std::vector<tools::qword> results = app.run_batch({ Column::of("x", x) }, 2);
+    EXPECT_DOUBLE_EQ(results[1].d, 4.0);
+
+    // the initializer is used again when the program runs without a batch
+    ASSERT_TRUE(app.run_program());
+    EXPECT_DOUBLE_EQ(app.get_last_result_as<double>(), 16.0);
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_batch_rejects_unknown_inputs)
+{
+    const double x[] = { 1.0 };
+    app.parse("double a = 4.0; return(a);");
+    EXPECT_THROW(app.run_batch({ Column::of("x", x) }, 1), std::runtime_error);
+}
+
+TEST_F(Interpreter_, concurrent_interpreters_run_their_own_program_or_the_same_one)
+{
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t RUN_COUNT    = 100;
+    tools::log::set_verbosity(tools::log::Verbosity_Warning);
+
+    // codes are shared, each thread has its own Interpreter
+    const Code* loop_code = app.compile( app.parse("int sum = 0; for(int i = 0; i < 100; i = i+1){ sum = sum + i; } return(sum);") );
+    const Code* call_code = app.compile( app.parse("double a = 0.5; double r = sin(a) * 2.0; if( r > 0.5 ){ r = r + 1.0; } return(r);") );
+
+    std::atomic<size_t>      success_count{0};
+    std::vector<std::thread> threads;
+    for ( size_t t = 0; t < THREAD_COUNT; ++t )
+    {
+        threads.emplace_back([&, t]()
+        {
+            const bool  is_loop = t % 2 == 0;
+            Interpreter interpreter;
+            if ( !interpreter.load_program(is_loop ? loop_code : call_code) )
+                return;
+            for ( size_t i = 0; i < RUN_COUNT; ++i )
+            {
+                interpreter.run_program();
+                const tools::qword result = interpreter.get_last_result();
+                if ( is_loop ? result.i32 == 4950 : result.d == std::sin(0.5) * 2.0 + 1.0 )
+                    ++success_count;
+            }
+            interpreter.release_program();
+        });
+    }
+    for ( std::thread& each : threads )
+        each.join();
+
+    EXPECT_EQ(success_count, THREAD_COUNT * RUN_COUNT);
+    delete loop_code;
+    delete call_code;
+}
+
+TEST_F(Interpreter_, concurrent_interpreters_run_the_same_batch_with_different_inputs)
+{
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t ROW_COUNT    = 1000;
+    tools::log::set_verbosity(tools::log::Verbosity_Warning);
+
+    Compiler    compiler;
+    const Code* code = compiler.compile_batch(app.parse("double x = 0.0; double r = x * 2.0 + 1.0; return(r);"), {"x"}, CompilerFlag_NONE, OptLevel_O1);
+    ASSERT_TRUE(code != nullptr);
+
+    std::atomic<size_t>      success_count{0};
+    std::vector<std::thread> threads;
+    for ( size_t t = 0; t < THREAD_COUNT; ++t )
+    {
+        threads.emplace_back([&, t]()
+        {
+            std::vector<double> x(ROW_COUNT);
+            for ( size_t i = 0; i < ROW_COUNT; ++i )
+                x[i] = (double)(t * ROW_COUNT + i);
+
+            Interpreter interpreter;
+            if ( !interpreter.load_program(code) )
+                return;
+            const std::vector<tools::qword> results = interpreter.run_batch({ Column::of("x", x.data()) }, ROW_COUNT);
+            for ( size_t i = 0; i < ROW_COUNT; ++i )
+                if ( results[i].d == x[i] * 2.0 + 1.0 )
+                    ++success_count;
+            interpreter.release_program();
+        });
+    }
+    for ( std::thread& each : threads )
+        each.join();
+
+    EXPECT_EQ(success_count, THREAD_COUNT * ROW_COUNT);
+    delete code;
+}
+
+TEST_F(Interpreter_, run_steps_runs_the_program_by_slices)
+{
+    const Code*  code        = app.compile(app.parse("int sum = 0; for(int i = 0; i < 100; i = i + 1){ sum = sum + i; } return(sum);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    // the program is suspended after each slice, and resumed by the next one
+    interpreter->start_program();
+    size_t slice_count = 0;
+    while ( interpreter->run_steps(10) == RunStatus_SUSPENDED )
+    {
+        ++slice_count;
+        EXPECT_TRUE(interpreter->is_program_running());
+    }
+    EXPECT_GT(slice_count, 10);
+    EXPECT_TRUE(interpreter->is_program_stopped());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 4950);
+
+    // same instruction count as run_program()
+    Trace trace;
+    interpreter->set_trace(&trace);
+    ASSERT_TRUE(app.run_program());
+    const u64_t step_count = trace.get_count();
+    interpreter->start_program();
+    EXPECT_EQ(interpreter->run_steps(step_count - 1), RunStatus_SUSPENDED);
+    EXPECT_EQ(interpreter->get_next_instr()->opcode, OpCode_ret);
+    EXPECT_EQ(interpreter->run_steps(1), RunStatus_DONE);
+    interpreter->set_trace(nullptr);
+
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_for_suspends_an_infinite_loop)
+{
+    const Code*  code        = app.compile(app.parse("int i = 0; while(true){ i = i + 1; } return(i);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    interpreter->start_program();
+    for ( int i = 0; i < 3; ++i )
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        EXPECT_EQ(interpreter->run_for(1000000), RunStatus_SUSPENDED); // 1 ms
+        EXPECT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(1));
+    }
+    interpreter->stop_program();
+    EXPECT_TRUE(interpreter->is_program_stopped());
+
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_program_stops_when_the_instruction_budget_is_exceeded)
+{
+    const Code*  code        = app.compile(app.parse("int i = 0; while(true){ i = i + 1; } return(i);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    Budget budget;
+    budget.instructions = 10000;
+    interpreter->set_budget(budget);
+    EXPECT_EQ(interpreter->run_program(), RunStatus_BUDGET_EXCEEDED);
+    EXPECT_TRUE(interpreter->is_program_stopped());
+    EXPECT_EQ(interpreter->get_usage().exceeded, BudgetFlag_INSTRUCTIONS);
+    EXPECT_EQ(interpreter->get_usage().instructions, budget.instructions);
+
+    interpreter->set_budget({});
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_program_stops_when_the_time_budget_is_exceeded)
+{
+    const Code*  code        = app.compile(app.parse("int i = 0; while(true){ i = i + 1; } return(i);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    Budget budget;
+    budget.nanoseconds = 5000000; // 5 ms
+    interpreter->set_budget(budget);
+    EXPECT_EQ(interpreter->run_program(), RunStatus_BUDGET_EXCEEDED);
+    EXPECT_EQ(interpreter->get_usage().exceeded, BudgetFlag_TIME);
+    EXPECT_GE(interpreter->get_usage().nanoseconds, budget.nanoseconds);
+
+    interpreter->set_budget({});
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_program_stops_when_the_memory_budget_is_exceeded)
+{
+    const Code*  code        = app.compile(app.parse("string s = \"\"; while(true){ s = s + \"abcdefgh\"; } return(s);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    Budget budget;
+    budget.memory = 1 << 16; // 64 KB
+    interpreter->set_budget(budget);
+    EXPECT_EQ(interpreter->run_program(), RunStatus_BUDGET_EXCEEDED);
+    EXPECT_EQ(interpreter->get_usage().exceeded, BudgetFlag_MEMORY);
+    EXPECT_GT(interpreter->get_usage().memory, budget.memory);
+
+    interpreter->set_budget({});
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Interpreter_, run_program_within_its_budget_is_done)
+{
+    const Code*  code        = app.compile(app.parse("int a = 0; for(int i = 0; i < 10; i = i + 1) { a = a + i; } return(a);"));
+    Interpreter* interpreter = app.get_interpreter();
+    ASSERT_TRUE(app.load_program(code));
+
+    Budget budget;
+    budget.instructions = 100000;
+    budget.nanoseconds  = 1000000000; // 1 s
+    budget.memory       = 1 << 20;    // 1 MB
+    interpreter->set_budget(budget);
+    EXPECT_EQ(interpreter->run_program(), RunStatus_DONE);
+    EXPECT_EQ(interpreter->get_usage().exceeded, BudgetFlag_NONE);
+    EXPECT_GT(interpreter->get_usage().instructions, 0);
+    EXPECT_LT(interpreter->get_usage().instructions, budget.instructions);
+    EXPECT_GT(interpreter->get_usage().memory, 0);
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 45);
+
+    interpreter->set_budget({});
+    app.release_program();
+    delete code;
+}
@@ -0,0 +1,398 @@
+#include "Jit.h"
+
+#include <cstring>
+#include <vector>
+#if NDBL_JIT
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+#include "tools/core/assertions.h"
+#include "tools/core/log.h"
+#include "Code.h"
+#include "Interpreter.h"
+
+using namespace ndbl;
+using namespace tools;
+
+#if NDBL_JIT
+namespace
+{
+    // Byte offset of the data (qword) in a variant, the stack slots are accessed natively.
+    i32_t variant_data_offset()
+    {
+        static const variant v;
+        return (i32_t)( (const char*)v.data() - (const char*)&v );
+    }
+
+    // Minimal x86-64 encoder, only the few instructions emitted by the templates are supported.
+    // Registers used by the machine code (callee-saved, they survive the helper calls):
+    // rbx: Interpreter*, r12: first stack slot, r13: pointer to the stack top index, r14: first CPU register.
+    struct Assembler
+    {
+        std::vector<u8_t> bytes;
+
+        size_t size() const { return bytes.size(); }
+
+        void emit(std::initializer_list<u8_t> _bytes) { bytes.insert(bytes.end(), _bytes); }
+
+        void emit_u32(u32_t _value)
+        {
+            for ( int i = 0; i < 4; ++i ) bytes.push_back( u8_t(_value >> (8 * i)) );
+        }
+
+        void emit_u64(u64_t _value)
+        {
+            for ( int i = 0; i < 8; ++i ) bytes.push_back( u8_t(_value >> (8 * i)) );
+        }
+
+        // Emit a 32-bit relative displacement to patch later (cf. patch_rel32()), returns its position.
+        size_t emit_rel32()
+        {
+            const size_t position = size();
+            emit_u32(0);
+            return position;
+        }
+
+        void patch_rel32(size_t _position, size_t _target)
+        {
+            const i32_t rel = (i32_t)( (i64_t)_target - (i64_t)(_position + 4) );
+            memcpy(&bytes[_position], &rel, sizeof(rel));
+        }
+
+        void prologue()
+        {
+            emit({ 0x53 });              // push rbx
+            emit({ 0x41, 0x54 });        // push r12
+            emit({ 0x41, 0x55 });        // push r13
+            emit({ 0x41, 0x56 });        // push r14
+            emit({ 0x41, 0x57 });        // push r15 (keeps rsp 16-byte aligned for the calls)
+            emit({ 0x48, 0x89, 0xfb });  // mov rbx, rdi
+            emit({ 0x49, 0x89, 0xf4 });  // mov r12, rsi
+            emit({ 0x49, 0x89, 0xd5 });  // mov r13, rdx
+            emit({ 0x49, 0x89, 0xce });  // mov r14, rcx
+        }
+
+        void epilogue()
+        {
+            emit({ 0x41, 0x5f });        // pop r15
+            emit({ 0x41, 0x5e });        // pop r14
+            emit({ 0x41, 0x5d });        // pop r13
+            emit({ 0x41, 0x5c });        // pop r12
+            emit({ 0x5b });              // pop rbx
+            emit({ 0xc3 });              // ret
+        }
+
+        void mov_eax_imm32(u32_t _value) { emit({ 0xb8 }); emit_u32(_value); }
+
+        void store_register_imm64(Register _register, u64_t _value)
+        {
+            emit({ 0x48, 0xb8 }); emit_u64(_value);                  // mov rax, imm64
+            store_register_rax(_register);
+        }
+
+        void store_register_rax(Register _register)
+        {
+            emit({ 0x49, 0x89, 0x86 }); emit_u32(_register * 8);     // mov [r14 + register], rax
+        }
+
+        // Call a given helper with the Interpreter, a given instruction and operator, returns the rel32 to patch with the error exit.
+        size_t call_helper(const void* _helper, const Instruction* _instr, const void* _operator)
+        {
+            emit({ 0x48, 0x89, 0xdf });                              // mov rdi, rbx
+            emit({ 0x48, 0xbe }); emit_u64((u64_t)_instr);           // mov rsi, imm64
+            emit({ 0x48, 0xba }); emit_u64((u64_t)_operator);        // mov rdx, imm64
+            emit({ 0x48, 0xb8 }); emit_u64((u64_t)_helper);          // mov rax, imm64
+            emit({ 0xff, 0xd0 });                                    // call rax
+            emit({ 0x85, 0xc0 });                                    // test eax, eax
+            emit({ 0x0f, 0x85 });                                    // jnz error
+            return emit_rel32();
+        }
+
+        // Pop the top slot, rcx is then the byte offset of the slot popped.
+        void pop_slot()
+        {
+            emit({ 0x49, 0x8b, 0x4d, 0x00 });                        // mov rcx, [r13]
+            emit({ 0x48, 0xff, 0xc9 });                              // dec rcx
+            emit({ 0x49, 0x89, 0x4d, 0x00 });                        // mov [r13], rcx
+            emit({ 0x48, 0x69, 0xc9 }); emit_u32(sizeof(variant));  // imul rcx, rcx, sizeof(variant)
+        }
+
+        size_t jmp()  { emit({ 0xe9 }); return emit_rel32(); }
+        size_t jz()   { emit({ 0x0f, 0x84 }); return emit_rel32(); }
+    };
+
+    // Type of the value left on the stack by a given typed operator (cf. Instruction::is_operator()), nullptr for other opcodes.
+    const TypeDescriptor* get_result_type(OpCode _opcode)
+    {
+        if ( _opcode >= OpCode_add_i32 && _opcode <= OpCode_neg_i32 ) return type::get<i32_t>();
+        if ( _opcode >= OpCode_add_f64 && _opcode <= OpCode_neg_f64 ) return type::get<double>();
+        if ( _opcode >= OpCode_lt_i32  && _opcode <= OpCode_ne_i32 )  return type::get<bool>();
+        if ( _opcode >= OpCode_lt_f64  && _opcode <= OpCode_ne_bool ) return type::get<bool>();
+        return nullptr;
+    }
+} // namespace
+#endif
+
+template<void (Interpreter::*EXEC)(const Instruction&)>
+int Jit::exec(Interpreter* _interpreter, const Instruction* _instr, Operator) noexcept
+{
+    try
+    {
+        (_interpreter->*EXEC)(*_instr);
+        return 0;
+    }
+    catch (...)
+    {
+        catch_exception(_interpreter, _instr);
+        return 1;
+    }
+}
+
+int Jit::exec_operator(Interpreter* _interpreter, const Instruction* _instr, Operator _operator) noexcept
+{
+    try
+    {
+        _operator(_interpreter->m_stack);
+        return 0;
+    }
+    catch (...)
+    {
+        catch_exception(_interpreter, _instr);
+        return 1;
+    }
+}
+
+void Jit::catch_exception(Interpreter* _interpreter, const Instruction* _instr)
+{
+    Jit* jit = _interpreter->m_jit.get();
+    jit->m_exception = std::current_exception();
+    qword eip;
+    eip.u64 = (u64_t)(_instr - jit->m_code->data());
+    _interpreter->m_cpu.write(Register_eip, eip); // so the faulty instruction can be retrieved
+}
+
+Jit::Helper Jit::get_helper(OpCode _opcode)
+{
+    switch ( _opcode )
+    {
+        case OpCode_cmp:              return &exec<&Interpreter::exec_cmp>;
+        case OpCode_call:             return &exec<&Interpreter::exec_call>;
+        case OpCode_dataflow:         return &exec<&Interpreter::exec_dataflow>;
+        case OpCode_call_native:      return &exec<&Interpreter::exec_call_native>;
+        case OpCode_load_input:       return &exec<&Interpreter::exec_load_input>;
+        case OpCode_mov:              return &exec<&Interpreter::exec_mov>;
+        case OpCode_deref_qword:      return &exec<&Interpreter::exec_deref_qword>;
+        case OpCode_pop_stack_frame:  return &exec<&Interpreter::exec_pop_stack_frame>;
+        case OpCode_push_stack_frame: return &exec<&Interpreter::exec_push_stack_frame>;
+        case OpCode_push_var:         return &exec<&Interpreter::exec_push_var>;
+        case OpCode_push_const:       return &exec<&Interpreter::exec_push_const>;
+        case OpCode_load:             return &exec<&Interpreter::exec_load>;
+        case OpCode_load_ref:         return &exec<&Interpreter::exec_load_ref>;
+        case OpCode_store:            return &exec<&Interpreter::exec_store>;
+        case OpCode_load_reg:         return &exec<&Interpreter::exec_load_reg>;
+        case OpCode_store_reg:        return &exec<&Interpreter::exec_store_reg>;
+        case OpCode_pop:              return &exec<&Interpreter::exec_pop>;
+        default:
+            return Interpreter::get_operator(_opcode) != nullptr ? &exec_operator : nullptr;
+    }
+}
+
+bool Jit::compile(const Code* _code)
+{
+    release();
+#if NDBL_JIT
+    ASSERT(_code != nullptr);
+    const size_t count = _code->size();
+    const i32_t  data  = variant_data_offset();
+
+    // positions to patch once the instructions (or the exits) are emitted
+    struct Fixup
+    {
+        size_t position;
+        size_t target; // instruction index
+    };
+    std::vector<size_t> labels(count);
+    std::vector<Fixup>  fixups;
+    std::vector<size_t> error_fixups;
+    std::vector<size_t> exit_fixups;
+
+    // instructions a jump lands on, the previous instruction is not always the one run before them
+    std::vector<bool> is_target(count, false);
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const Instruction& instr = _code->get_instructions()[i];
+        i64_t offset = 0;
+        switch ( instr.opcode )
+        {
+            case OpCode_jmp:
+            case OpCode_jne:
+            case OpCode_pop_jne: offset = instr.jmp.offset; break;
+            default: continue;
+        }
+        const i64_t target = (i64_t)i + offset;
+        if ( target >= 0 && target < (i64_t)count )
+            is_target[target] = true;
+    }
+
+    Assembler a;
+    a.prologue();
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        const Instruction& instr = _code->get_instructions()[i];
+        labels[i] = a.size();
+
+        // native jumps, their target must be in the code
+        auto jump_to = [&](size_t _position, i64_t _offset) -> bool
+        {
+            const i64_t target = (i64_t)i + _offset;
+            if ( target < 0 || target >= (i64_t)count )
+                return false;
+            fixups.push_back({ _position, (size_t)target });
+            return true;
+        };
+
+        switch ( instr.opcode )
+        {
+            case OpCode_ret:
+                a.store_register_imm64(Register_eip, i);
+                exit_fixups.push_back( a.jmp() );
+                break;
+
+            case OpCode_jmp:
+                if ( !jump_to(a.jmp(), instr.jmp.offset) ) return false;
+                break;
+
+            case OpCode_jne:
+                a.emit({ 0x41, 0x80, 0xbe }); a.emit_u32(Register_rax * 8); a.emit({ 0x00 }); // cmp byte [r14 + rax], 0
+                if ( !jump_to(a.jz(), instr.jmp.offset) ) return false;
+                break;
+
+            case OpCode_pop_jne:
+                a.pop_slot();
+                a.emit({ 0x49, 0x8b, 0x84, 0x0c }); a.emit_u32(data);                     // mov rax, [r12 + rcx + data]
+                a.store_register_rax(Register_rax);
+                a.emit({ 0x84, 0xc0 });                                                   // test al, al
+                if ( !jump_to(a.jz(), instr.jmp.offset) ) return false;
+                break;
+
+            // left (deepest) = left op right, right is popped
+            case OpCode_add_i32:
+            case OpCode_sub_i32:
+                a.pop_slot();
+                a.emit({ 0x41, 0x8b, 0x94, 0x0c }); a.emit_u32(data);                     // mov edx, [r12 + rcx + data]
+                a.emit({ 0x41, u8_t(instr.opcode == OpCode_add_i32 ? 0x01 : 0x29), 0x94, 0x0c });
+                a.emit_u32(data - (i32_t)sizeof(variant));                                // add/sub [r12 + rcx + data - slot], edx
+                break;
+
+            case OpCode_mul_i32:
+                a.pop_slot();
+                a.emit({ 0x41, 0x8b, 0x94, 0x0c }); a.emit_u32(data);                     // mov edx, [r12 + rcx + data]
+                a.emit({ 0x41, 0x8b, 0x84, 0x0c }); a.emit_u32(data - (i32_t)sizeof(variant)); // mov eax, [r12 + rcx + data - slot]
+                a.emit({ 0x0f, 0xaf, 0xc2 });                                             // imul eax, edx
+                a.emit({ 0x41, 0x89, 0x84, 0x0c }); a.emit_u32(data - (i32_t)sizeof(variant)); // mov [r12 + rcx + data - slot], eax
+                break;
+
+            case OpCode_add_f64:
+            case OpCode_sub_f64:
+            case OpCode_mul_f64:
+            {
+                const u8_t op = instr.opcode == OpCode_add_f64 ? 0x58 : instr.opcode == OpCode_sub_f64 ? 0x5c : 0x59;
+                a.pop_slot();
+                a.emit({ 0xf2, 0x41, 0x0f, 0x10, 0x8c, 0x0c }); a.emit_u32(data);                     // movsd xmm1, [r12 + rcx + data]
+                a.emit({ 0xf2, 0x41, 0x0f, 0x10, 0x84, 0x0c }); a.emit_u32(data - (i32_t)sizeof(variant)); // movsd xmm0, [r12 + rcx + data - slot]
+                a.emit({ 0xf2, 0x0f, op, 0xc1 });                                                    // addsd/subsd/mulsd xmm0, xmm1
+                a.emit({ 0xf2, 0x41, 0x0f, 0x11, 0x84, 0x0c }); a.emit_u32(data - (i32_t)sizeof(variant)); // movsd [r12 + rcx + data - slot], xmm0
+                break;
+            }
+
+            // the value stored is a typed operator's result (right before), it has the register's type already: no conversion
+            case OpCode_store_reg:
+                if ( i != 0 && !is_target[i] && get_result_type(_code->get_instructions()[i - 1].opcode) == instr.reg.type )
+                {
+                    a.pop_slot();
+                    a.emit({ 0x49, 0x8b, 0x84, 0x0c }); a.emit_u32(data);                 // mov rax, [r12 + rcx + data]
+                    a.store_register_rax(instr.reg.reg);
+                    a.store_register_rax(Register_rax);
+                    break;
+                }
+                [[fallthrough]];
+
+            default:
+            {
+                Helper helper = get_helper(instr.opcode);
+                if ( helper == nullptr )
+                {
+                    LOG_VERBOSE("Jit", "Unable to compile, no template for %s\n", Instruction::to_string(instr, i).c_str());
+                    return false;
+                }
+                error_fixups.push_back( a.call_helper((const void*)helper, &instr, (const void*)Interpreter::get_operator(instr.opcode)) );
+            }
+        }
+    }
+
+    const size_t exit_label = a.size();
+    a.emit({ 0x31, 0xc0 });  // xor eax, eax
+    a.epilogue();
+    const size_t error_label = a.size();
+    a.mov_eax_imm32(1);
+    a.epilogue();
+
+    for ( const Fixup& each : fixups )      a.patch_rel32(each.position, labels[each.target]);
+    for ( size_t each : exit_fixups )       a.patch_rel32(each, exit_label);
+    for ( size_t each : error_fixups )      a.patch_rel32(each, error_label);
+
+    // copy to a writable mapping, then make it executable (never both)
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t size      = (a.size() + page_size - 1) / page_size * page_size;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( memory == MAP_FAILED )
+    {
+        LOG_ERROR("Jit", "Unable to map memory\n");
+        return false;
+    }
+    memcpy(memory, a.bytes.data(), a.size());
+    if ( mprotect(memory, size, PROT_READ | PROT_EXEC) != 0 )
+    {
+        LOG_ERROR("Jit", "Unable to make memory executable\n");
+        munmap(memory, size);
+        return false;
+    }
+
+    m_code   = _code;
+    m_memory = memory;
+    m_size   = size;
+    m_entry  = (Entry)memory;
+    LOG_VERBOSE("Jit", "Code compiled (%zu instructions, %zu bytes)\n", count, a.size());
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::release()
+{
+#if NDBL_JIT
+    if ( m_memory != nullptr )
+    {
+        munmap(m_memory, m_size);
+    }
+#endif
+    m_code   = nullptr;
+    m_memory = nullptr;
+    m_size   = 0;
+    m_entry  = nullptr;
+}
+
+void Jit::run(Interpreter* _interpreter)
+{
+    ASSERT(is_compiled());
+    ASSERT(_interpreter->m_code == m_code);
+    Stack& stack = _interpreter->m_stack;
+    if ( m_entry(_interpreter, stack.m_values.data(), &stack.m_top, _interpreter->m_cpu.m_register) != 0 )
+    {
+        std::exception_ptr exception = m_exception;
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
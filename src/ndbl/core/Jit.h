@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include "tools/core/types.h"
+#include "tools/core/reflection/qword.h"
+#include "tools/core/reflection/variant.h"
+#include "Instruction.h"
+
+// The Jit emits x86-64 machine code into executable memory (mmap/mprotect), it is available on Linux x86-64 only.
+#if defined(__x86_64__) && defined(__linux__)
+#   define NDBL_JIT 1
+#else
+#   define NDBL_JIT 0
+#endif
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+    class Interpreter;
+    class Stack;
+
+    /**
+     * @class Template JIT, translates a Code to x86-64 machine code run on an Interpreter's CPU and Stack (cf. Interpreter::set_jit_enabled()).
+     * Each instruction is translated to a fixed template: jumps are native jumps (no dispatch), the typed add/sub/mul are
+     * inlined on the stack slots, and the other instructions call their Interpreter::exec_*() through a helper specific to their opcode.
+     * The machine code runs a whole program at once, it does not count, profile or trace the instructions run: sliced, budgeted,
+     * profiled, traced or debugged runs are always interpreted. A code having an instruction without template (ex: OpCode_trap) is not compiled.
+     */
+    class Jit
+    {
+    public:
+        Jit() = default;
+        Jit(const Jit&) = delete;
+        Jit& operator=(const Jit&) = delete;
+        ~Jit() { release(); }
+
+        static bool     is_supported() { return NDBL_JIT; } // Check if machine code can be emitted on this platform.
+        bool            compile(const Code*);                // Translate a given code (the previous one is released), returns false when it can't be.
+        void            release();                           // Release the machine code.
+        bool            is_compiled() const { return m_entry != nullptr; }
+        const Code*     get_code() const { return m_code; }  // Get the code compiled, nullptr when none.
+        size_t          get_size() const { return m_size; }  // Get the machine code size (in bytes).
+        void            run(Interpreter*);                   // Run the machine code on a given Interpreter, from the first instruction until OpCode_ret. An exception thrown by an instruction is rethrown, the instruction pointer is written back.
+    private:
+        typedef void (*Operator)(Stack&);
+        typedef int  (*Entry)(Interpreter*, tools::variant* _stack, size_t* _top, tools::qword* _registers); // Returns 0, or 1 when an exception was caught (cf. m_exception).
+        typedef int  (*Helper)(Interpreter*, const Instruction*, Operator);                                   // Returns 0, or 1 when an exception was caught.
+
+        template<void (Interpreter::*EXEC)(const Instruction&)>
+        static int      exec(Interpreter*, const Instruction*, Operator) noexcept;          // Helper calling a given Interpreter::exec_*()
+        static int      exec_operator(Interpreter*, const Instruction*, Operator) noexcept; // Helper calling a given typed operator
+        static void     catch_exception(Interpreter*, const Instruction*);                 // Store the exception being handled, and write the instruction pointer back.
+        static Helper   get_helper(OpCode);                                                // Get the helper of a given opcode, nullptr when none.
+
+        const Code*        m_code      = nullptr;
+        void*              m_memory    = nullptr; // executable mapping
+        size_t             m_size      = 0;
+        Entry              m_entry     = nullptr;
+        std::exception_ptr m_exception;           // exception thrown by the last run, if any
+    };
+} // namespace ndbl
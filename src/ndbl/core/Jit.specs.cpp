@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "fixtures/core.h"
+#include "ndbl/core/Jit.h"
+
+using namespace ndbl;
+using namespace tools;
+typedef ::testing::Core Jit_;
+
+// Run a given program, with or without the JIT, and return the interpreter's registers after the run
+static std::vector<qword> run(NodableHeadless& _app, const std::string& _program, bool _jit, bool* _compiled = nullptr)
+{
+    Interpreter* interpreter = _app.get_interpreter();
+    const Code*  code        = _app.compile(_app.parse(_program));
+    _app.set_jit_enabled(_jit);
+    if ( !_app.load_program(code) )
+    {
+        ADD_FAILURE() << "Unable to load: " << _program;
+        _app.set_jit_enabled(false);
+        delete code;
+        return { qword(), qword() };
+    }
+    if ( _compiled != nullptr )
+        *_compiled = interpreter->is_jit_compiled();
+    _app.run_program();
+    const std::vector<qword> registers = {
+        interpreter->read_cpu_register(Register_rax),
+        interpreter->read_cpu_register(Register_eip),
+    };
+    _app.release_program();
+    _app.set_jit_enabled(false);
+    delete code;
+    return registers;
+}
+
+TEST_F(Jit_, runs_the_programs_as_the_interpreter_does)
+{
+    if ( !Jit::is_supported() )
+        GTEST_SKIP() << "JIT is not supported on this platform";
+
+    for ( const std::string& program : PROGRAMS )
+    {
+        bool compiled = false;
+        const std::vector<qword> interpreted = run(app, program, false);
+        const std::vector<qword> jitted      = run(app, program, true, &compiled);
+        EXPECT_TRUE(compiled) << program;
+        for ( size_t i = 0; i < interpreted.size(); ++i )
+            EXPECT_EQ(jitted[i].u64, interpreted[i].u64) << program;
+    }
+}
+
+TEST_F(Jit_, exceptions_stop_at_the_faulty_instruction)
+{
+    if ( !Jit::is_supported() )
+        GTEST_SKIP() << "JIT is not supported on this platform";
+
+    const std::string program = "int a = 0; int b = 1; for(int i = 0; i < 3; i = i + 1) { b = b + 2 / a; } return(b);";
+    bool compiled = false;
+    const std::vector<qword> interpreted = run(app, program, false);
+    const std::vector<qword> jitted      = run(app, program, true, &compiled);
+    EXPECT_TRUE(compiled);
+    EXPECT_EQ(jitted[1].u64, interpreted[1].u64); // same instruction pointer
+    EXPECT_FALSE(app.get_interpreter()->is_program_running());
+}
+
+TEST_F(Jit_, code_without_template_is_interpreted)
+{
+    Code code(nullptr);
+    code.push_instr(OpCode_trap);
+    code.push_instr(OpCode_ret);
+
+    Jit jit;
+    EXPECT_FALSE(jit.compile(&code));
+    EXPECT_FALSE(jit.is_compiled());
+
+    // same for the Interpreter, the program is run anyway
+    Interpreter interpreter;
+    interpreter.set_jit_enabled(true);
+    ASSERT_TRUE(interpreter.load_program(&code));
+    EXPECT_FALSE(interpreter.is_jit_compiled());
+    interpreter.release_program();
+}
+
+TEST_F(Jit_, profiled_and_traced_runs_are_interpreted)
+{
+    if ( !Jit::is_supported() )
+        GTEST_SKIP() << "JIT is not supported on this platform";
+
+    const Code* code = app.compile(app.parse(PROGRAMS[1]));
+    app.set_jit_enabled(true);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.get_interpreter()->is_jit_compiled());
+
+    Trace trace;
+    app.get_interpreter()->set_trace(&trace);
+    ASSERT_TRUE(app.run_program());
+    app.get_interpreter()->set_trace(nullptr);
+    EXPECT_GT(trace.get_count(), code->size());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 1024);
+
+    app.release_program();
+    app.set_jit_enabled(false);
+    delete code;
+}
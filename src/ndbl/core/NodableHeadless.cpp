@@ -1,4 +1,7 @@
 #include "NodableHeadless.h"
+
+#include <memory>
+#include <stdexcept>
 #include "Interpreter.h"
 #include "ndbl/core/language/Nodlang.h"
 #include "tools/core/memory/PoolManager.h"
@@ -13,7 +16,7 @@ void NodableHeadless::init()
     m_language        = init_language();
     m_node_factory    = init_node_factory();
     m_component_factory = init_component_factory();
-    m_interpreter     = init_interpreter();
+    m_interpreter     = new Interpreter();
     m_graph           = new Graph(m_node_factory);
 }
 
@@ -24,7 +27,9 @@ void NodableHeadless::shutdown()
     tools::shutdown_task_manager(m_task_manager);
     shutdown_language(m_language);
     shutdown_node_factory(m_node_factory);
-    shutdown_interpreter(m_interpreter);
+    m_interpreter->release_program();
+    delete m_interpreter;
+    m_interpreter = nullptr;
     shutdown_component_factory(m_component_factory);
 }
 
@@ -44,7 +49,11 @@ bool NodableHeadless::run_program() const
     VERIFY(m_interpreter != nullptr, "Did you call reset_name() ?");
 
     try {
-        m_interpreter->run_program();
+        if ( m_interpreter->run_program() == RunStatus_BUDGET_EXCEEDED )
+        {
+            LOG_ERROR("NodableHeadless", "Unable to run the program! Budget exceeded.\n");
+            return false;
+        }
     }
     catch ( std::runtime_error& error)
     {
@@ -63,16 +72,60 @@ bool NodableHeadless::run_program() const
     return true;
 }
 
+std::vector<tools::qword> NodableHeadless::run_batch(const std::vector<Column>& _columns, size_t _row_count, OptLevel _opt_level)
+{
+    std::vector<std::string> inputs;
+    for ( const Column& each : _columns )
+    {
+        inputs.push_back(each.name);
+    }
+
+    // batch code is specific to its inputs, it is not cached
+    std::unique_ptr<const Code> code( m_compiler.compile_batch(m_graph, inputs, CompilerFlag_NONE, _opt_level) );
+    if ( code == nullptr )
+    {
+        throw std::runtime_error("Unable to compile the program for a batch");
+    }
+
+    const Code* loaded_code = m_interpreter->release_program();
+    auto        load_back   = [&]()
+    {
+        m_interpreter->release_program();
+        if ( loaded_code != nullptr && !m_interpreter->load_program(loaded_code) )
+        {
+            LOG_ERROR("NodableHeadless", "Unable to load back the program after a batch\n");
+        }
+    };
+
+    std::vector<tools::qword> results;
+    try
+    {
+        if ( !m_interpreter->load_program(code.get()) )
+        {
+            throw std::runtime_error("Unable to load the program for a batch");
+        }
+        results = m_interpreter->run_batch(_columns, _row_count);
+    }
+    catch (...)
+    {
+        load_back();
+        throw;
+    }
+    load_back();
+    return results;
+}
+
 const Code* NodableHeadless::compile()
 {
-    m_asm_code = m_compiler.compile_syntax_tree(m_graph);
+    m_interpreter->release_program(); // the code loaded might be evicted from the cache
+    m_asm_code = m_code_cache.compile(m_compiler, m_graph);
     return m_asm_code;
 }
 
-const Code* NodableHeadless::compile(Graph* _graph)
+const Code* NodableHeadless::compile(Graph* _graph, CompilerFlags _flags, OptLevel _opt_level)
 {
     ASSERT(_graph != nullptr);
-    return m_compiler.compile_syntax_tree(_graph);
+    return m_compiler.compile_syntax_tree(_graph, _flags, _opt_level);
 }
 
 bool NodableHeadless::load_program(const Code* code)
@@ -106,9 +159,10 @@ void NodableHeadless::update()
 
 void NodableHeadless::clear()
 {
-    delete m_asm_code;
-    m_graph->clear();
     release_program();
+    m_asm_code = nullptr;
+    m_code_cache.clear(); // codes refer to the graph's nodes
+    m_graph->clear();
     m_source_code.clear();
 }
 
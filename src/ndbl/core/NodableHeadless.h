@@ -3,6 +3,7 @@
 #include <string>
 #include "Interpreter.h"
 #include "Compiler.h"
+#include "CodeCache.h"
 
 namespace tools
 {
@@ -26,15 +27,20 @@ namespace ndbl
         bool                should_stop() const;
         virtual std::string& serialize( std::string& out ) const;
         virtual Graph*      parse( const std::string& in );
-        virtual const Code* compile(Graph*);
-        const Code*         compile();
+        virtual const Code* compile(Graph*, CompilerFlags = CompilerFlag_DEFAULT, OptLevel = OptLevel_DEFAULT);
+        const Code*         compile(); // Compile the current graph, the code is reused when the graph did not change (cf. CodeCache). Releases the program loaded, the cache might evict it.
         bool                load_program(const Code*);
         bool                run_program() const;
+        std::vector<tools::qword> run_batch(const std::vector<Column>&, size_t _row_count, OptLevel = OptLevel_DEFAULT); // Compile the current graph with the given columns as inputs, and run it once per row (cf. Interpreter::run_batch()). The program loaded (if any) is loaded back after.
         bool                release_program();
         Nodlang*            get_language() const;
+        Interpreter*        get_interpreter() const { return m_interpreter; }
         Graph*              get_graph() const;
         tools::qword        get_last_result() const;
         const std::string&  get_source_code() const;
+        const CodeCache&    get_code_cache() const { return m_code_cache; }
+        void                set_jit_enabled(bool _enabled) { m_interpreter->set_jit_enabled(_enabled); } // Run the programs as machine code when supported (cf. Interpreter::set_jit_enabled()).
+        bool                is_jit_enabled() const { return m_interpreter->is_jit_enabled(); }
 
         template<typename ResultT>
         ResultT get_last_result_as()
@@ -49,9 +55,10 @@ namespace ndbl
         bool                m_should_stop{false};
         Graph*              m_graph{};
         std::string         m_source_code;
-        const Code*         m_asm_code{};
+        const Code*         m_asm_code{}; // owned by m_code_cache
         bool                m_auto_completion{false};
         Compiler            m_compiler{}; // TODO: move this to a global (like VirtualMachine.h)
+        CodeCache           m_code_cache{};
     };
 }
 
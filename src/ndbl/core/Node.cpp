@@ -2,6 +2,7 @@
 
 #include <algorithm> // for std::find
 
+#include "tools/core/Hash.h"
 #include "Scope.h"
 #include "Graph.h"
 #include "Utils.h"
@@ -299,6 +300,36 @@ const Slot* Node::flow_in() const
     return find_slot_by_property(m_value, SlotFlag_FLOW_IN );
 }
 
+u64_t Node::hash(u64_t _seed) const
+{
+    u64_t result = tools::Hash::combine(_seed, this);
+    result = tools::Hash::combine(result, m_type);
+    result = tools::Hash::combine(result, m_name);
+
+    for ( const Property* property : m_props )
+    {
+        result = tools::Hash::combine(result, property->get_type());
+        result = tools::Hash::combine(result, property->name());
+        const Token& token = property->token();
+        result = tools::Hash::combine(result, token.m_type);
+        if ( token.has_buffer() )
+        {
+            result = tools::Hash::_hash(token.word(), token.word_len(), result);
+        }
+    }
+
+    for ( const Slot* slot : m_slots )
+    {
+        result = tools::Hash::combine(result, slot);
+        result = tools::Hash::combine(result, slot->flags());
+        for ( const Slot* adjacent : slot->adjacent() )
+        {
+            result = tools::Hash::combine(result, adjacent);
+        }
+    }
+    return result;
+}
+
 bool Node::update()
 {
     //
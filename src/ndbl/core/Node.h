@@ -54,6 +54,7 @@ namespace ndbl
 
         void                 init(NodeType type, const std::string& name);
         bool                 update();
+        u64_t                hash(u64_t _seed) const; // Combine a given hash with this node's structure (address, type, name, properties and slots with their adjacent slots)
         inline NodeType      type() const { return m_type; }
         bool                 is_invokable() const;
         bool                 is_expression() const;
@@ -0,0 +1,299 @@
+#include "Optimizer.h"
+
+#include <set>
+#include <vector>
+#include "tools/core/assertions.h"
+#include "tools/core/log.h"
+#include "Code.h"
+
+using namespace ndbl;
+using namespace tools;
+
+// Flag each instruction targeted by a jump
+static std::vector<bool> find_jump_targets(const Code* _code)
+{
+    std::vector<bool> is_target(_code->size() + 1, false);
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        const Instruction* instr = _code->get_instruction_at(i);
+        if ( instr->is_jump() )
+        {
+            i64_t target = (i64_t)i + instr->get_jump_offset();
+            ASSERT(target >= 0 && target <= (i64_t)_code->size());
+            is_target[target] = true;
+        }
+    }
+    return is_target;
+}
+
+size_t Optimizer::optimize(Code* _code, OptLevel _level)
+{
+    ASSERT(_code);
+
+    static const Pass passes_O1[] = {
+        remove_empty_stack_frames,
+        remove_unreachable_instructions,
+        thread_jumps,
+        remove_useless_jumps
+    };
+    static const Pass passes_O2[] = {
+        fuse_instructions
+    };
+
+    const size_t initial_size = _code->size();
+    size_t total_change_count = 0;
+    size_t change_count;
+    do
+    {
+        change_count = 0;
+        if ( _level >= OptLevel_O1 )
+            for( Pass each_pass : passes_O1 )
+                change_count += each_pass(_code);
+        if ( _level >= OptLevel_O2 )
+            for( Pass each_pass : passes_O2 )
+                change_count += each_pass(_code);
+        total_change_count += change_count;
+    }
+    while( change_count != 0 );
+
+    LOG_MESSAGE("Optimizer", "Code optimized (O%i): %zu change(s), %zu instruction(s) instead of %zu.\n", _level, total_change_count, _code->size(), initial_size);
+    return total_change_count;
+}
+
+size_t Optimizer::remove_empty_stack_frames(Code* _code)
+{
+    ASSERT(_code);
+
+    // The Compiler pushes a scope's variables right after its stack frame, a frame not followed by a push_var is empty.
+    std::set<const Scope*> empty_scopes;
+    std::vector<bool>      erase(_code->size(), false);
+    size_t                 erase_count = 0;
+
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        const Instruction* instr = _code->get_instruction_at(i);
+        if ( instr->opcode != OpCode_push_stack_frame )
+            continue;
+        if ( i + 1 < _code->size() && _code->get_instruction_at(i + 1)->opcode == OpCode_push_var )
+            continue;
+        empty_scopes.insert(instr->push.scope);
+        erase[i] = true;
+        ++erase_count;
+    }
+
+    if ( erase_count == 0 )
+    {
+        return 0;
+    }
+
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        const Instruction* instr = _code->get_instruction_at(i);
+        if ( instr->opcode == OpCode_pop_stack_frame && empty_scopes.find(instr->pop.scope) != empty_scopes.end() )
+        {
+            erase[i] = true;
+            ++erase_count;
+        }
+    }
+
+    _code->erase_instructions( erase );
+    return erase_count;
+}
+
+size_t Optimizer::remove_unreachable_instructions(Code* _code)
+{
+    ASSERT(_code);
+    if ( _code->size() == 0 )
+    {
+        return 0;
+    }
+
+    // Walk through each execution path from the first instruction
+    std::vector<bool>   reachable(_code->size(), false);
+    std::vector<size_t> to_visit{ 0 };
+    while( !to_visit.empty() )
+    {
+        size_t i = to_visit.back();
+        to_visit.pop_back();
+        if ( i >= _code->size() || reachable[i] )
+            continue;
+        reachable[i] = true;
+
+        const Instruction* instr = _code->get_instruction_at(i);
+        if ( instr->is_jump() )
+            to_visit.push_back( (size_t)((i64_t)i + instr->get_jump_offset()) );
+        if ( instr->opcode != OpCode_jmp && instr->opcode != OpCode_ret )
+            to_visit.push_back( i + 1 );
+    }
+
+    // The Interpreter requires the code to end with a ret, the last instruction is kept unless the last reachable one is a ret.
+    size_t last_reachable = _code->size() - 1;
+    while( last_reachable > 0 && !reachable[last_reachable] )
+        --last_reachable;
+    const bool keep_last = _code->get_instruction_at(last_reachable)->opcode != OpCode_ret;
+
+    std::vector<bool> erase(_code->size(), false);
+    size_t            erase_count = 0;
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        if ( !reachable[i] && !(keep_last && i == _code->size() - 1) )
+        {
+            erase[i] = true;
+            ++erase_count;
+        }
+    }
+
+    if ( erase_count != 0 )
+    {
+        _code->erase_instructions( erase );
+    }
+    return erase_count;
+}
+
+size_t Optimizer::thread_jumps(Code* _code)
+{
+    ASSERT(_code);
+    size_t change_count = 0;
+
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        Instruction* instr = _code->get_instruction_at(i);
+        if ( !instr->is_jump() )
+            continue;
+
+        // follow the unconditional jumps (hop count is bounded to stop on infinite loops)
+        i64_t target = (i64_t)i + instr->get_jump_offset();
+        for( size_t hop = 0; hop < _code->size() && target < (i64_t)_code->size(); ++hop )
+        {
+            const Instruction* target_instr = _code->get_instruction_at(target);
+            if ( target_instr->opcode != OpCode_jmp || target == (i64_t)i )
+                break;
+            target += target_instr->jmp.offset;
+        }
+
+        i64_t offset = target - (i64_t)i;
+        if ( offset != instr->get_jump_offset() )
+        {
+            instr->set_jump_offset(offset);
+            ++change_count;
+        }
+    }
+    return change_count;
+}
+
+size_t Optimizer::remove_useless_jumps(Code* _code)
+{
+    ASSERT(_code);
+    std::vector<bool> erase(_code->size(), false);
+    size_t            erase_count  = 0;
+    size_t            change_count = 0;
+
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        Instruction* instr = _code->get_instruction_at(i);
+        if ( !instr->is_jump() || instr->get_jump_offset() != 1 )
+            continue;
+
+        switch ( instr->opcode )
+        {
+            case OpCode_jmp:
+            case OpCode_jne:
+                erase[i] = true;
+                ++erase_count;
+                break;
+            case OpCode_pop_jne:
+            {
+                Instruction pop(OpCode_pop); // the pop is still required
+                pop.pop_reg.dst = Register_rax;
+                *instr = pop;
+                ++change_count;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if ( erase_count != 0 )
+    {
+        _code->erase_instructions( erase );
+    }
+    return erase_count + change_count;
+}
+
+size_t Optimizer::fuse_instructions(Code* _code)
+{
+    ASSERT(_code);
+
+    const std::vector<bool> is_target = find_jump_targets(_code);
+    std::vector<bool>       erase(_code->size(), false);
+    size_t                  erase_count = 0;
+
+    // Check if a sequence of a given length starting at a given index can be fused
+    // (instructions after the first must exist and must not be targeted by a jump)
+    auto can_fuse = [&](size_t _index, size_t _length) -> bool
+    {
+        if ( _index + _length > _code->size() )
+            return false;
+        for( size_t i = _index + 1; i < _index + _length; ++i )
+            if ( is_target[i] || erase[i] )
+                return false;
+        return true;
+    };
+
+    auto opcode_at = [&](size_t _index) -> OpCode
+    {
+        return _code->get_instruction_at(_index)->opcode;
+    };
+
+    for( size_t i = 0; i < _code->size(); ++i )
+    {
+        if ( erase[i] )
+        {
+            continue;
+        }
+
+        Instruction* instr = _code->get_instruction_at(i);
+
+        // pop rax            =>     pop_jne <offset>
+        // jne <offset>
+        if ( instr->opcode == OpCode_pop
+             && instr->pop_reg.dst == Register_rax
+             && can_fuse(i, 2)
+             && opcode_at(i + 1) == OpCode_jne )
+        {
+            Instruction fused(OpCode_pop_jne);
+            fused.set_jump_offset( _code->get_instruction_at(i + 1)->jmp.offset + 1 );
+            *instr = fused;
+            erase[i + 1] = true;
+            erase_count += 1;
+            continue;
+        }
+
+        // store [x]          =>     store [x]    (store already writes the stored value to rax)
+        // load [x]
+        // pop rax
+        if ( instr->opcode == OpCode_store
+             && can_fuse(i, 3)
+             && opcode_at(i + 1) == OpCode_load
+             && opcode_at(i + 2) == OpCode_pop )
+        {
+            const Instruction* load = _code->get_instruction_at(i + 1);
+            const Instruction* pop  = _code->get_instruction_at(i + 2);
+            if ( load->slot.index == instr->slot.index && pop->pop_reg.dst == Register_rax )
+            {
+                erase[i + 1] = erase[i + 2] = true;
+                erase_count += 2;
+                continue;
+            }
+        }
+    }
+
+    if ( erase_count != 0 )
+    {
+        _code->erase_instructions( erase );
+    }
+
+    LOG_VERBOSE("Optimizer", "fuse_instructions() removed %zu instruction(s)\n", erase_count);
+    return erase_count;
+}
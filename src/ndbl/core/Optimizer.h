@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include "tools/core/types.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+
+    // Optimization levels, each level includes the previous ones
+    typedef int OptLevel;
+    enum OptLevel_
+    {
+        OptLevel_O0      = 0, // No optimization, code is run as the Compiler emitted it.
+        OptLevel_O1      = 1, // Fold constant expressions and allocate registers (done by the Compiler), remove dead code (empty stack frames, unreachable instructions, useless jumps) and thread jumps.
+        OptLevel_O2      = 2, // Hoist loop-invariant expressions out of the loops (done by the Compiler), fuse common instruction sequences into superinstructions.
+        OptLevel_DEFAULT = OptLevel_O1,
+    };
+
+    /**
+     * @class Rewrite the Code produced by the Compiler to run faster, with the same result.
+     * The optimizations are split in passes, a level runs its passes until the code is stable.
+     */
+    class Optimizer
+    {
+    public:
+        typedef size_t (*Pass)(Code*);                             // A pass rewrites a given code and returns its change count (0 when nothing changed).
+        static size_t optimize(Code*, OptLevel);                   // Run the passes of a given level until the code is stable. Returns the total change count.
+        static size_t remove_empty_stack_frames(Code*);            // Remove push/pop_stack_frame pairs of scopes having no variable.
+        static size_t remove_unreachable_instructions(Code*);      // Remove the instructions no execution path can reach (ex: after a return).
+        static size_t thread_jumps(Code*);                         // Make each jump to an unconditional jump go directly to its final destination.
+        static size_t remove_useless_jumps(Code*);                 // Remove the jumps to the next instruction.
+        static size_t fuse_instructions(Code*);                    // Peephole pass, replace common instruction sequences by superinstructions.
+    };
+} // namespace ndbl
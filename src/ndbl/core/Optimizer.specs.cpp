@@ -0,0 +1,404 @@
+#include <gtest/gtest.h>
+#include "fixtures/core.h"
+#include "ndbl/core/Optimizer.h"
+#include "ndbl/core/Trace.h"
+
+using namespace ndbl;
+typedef ::testing::Core Optimizer_;
+
+// Count the node evaluations (function calls and typed operators)
+static size_t count_evaluations(const Code* _code)
+{
+    size_t count = 0;
+    for( const Instruction& each : _code->get_instructions() )
+        if ( each.opcode == OpCode_call || each.opcode == OpCode_call_native || each.is_operator() )
+            ++count;
+    return count;
+}
+
+// Run a given code, return the count of instructions executed
+static u64_t run_and_count(NodableHeadless& _app, const Code* _code)
+{
+    Trace trace(1);
+    _app.get_interpreter()->set_trace(&trace);
+    EXPECT_TRUE(_app.load_program(_code));
+    EXPECT_TRUE(_app.run_program());
+    _app.get_interpreter()->set_trace(nullptr);
+    return trace.get_count();
+}
+
+// Build a code comparing rax (initialized with a given value) with true, rax is 42 if equal, 13 otherwise
+static Code* make_condition_code(bool _condition)
+{
+    Code* code = new Code(nullptr);
+
+    Instruction* instr = code->push_instr(OpCode_mov);
+    instr->mov.dst     = Register_rax;
+    instr->mov.src.b   = _condition;
+
+    instr              = code->push_instr(OpCode_mov);
+    instr->mov.dst     = Register_rdx;
+    instr->mov.src.b   = true;
+
+    instr              = code->push_instr(OpCode_cmp);
+    instr->cmp.left    = Register_rax;
+    instr->cmp.right   = Register_rdx;
+
+    instr              = code->push_instr(OpCode_jne);
+    instr->jmp.offset  = 3;
+
+    instr              = code->push_instr(OpCode_mov);
+    instr->mov.dst     = Register_rax;
+    instr->mov.src.i32 = 42;
+
+    code->push_instr(OpCode_ret);
+
+    instr              = code->push_instr(OpCode_mov);
+    instr->mov.dst     = Register_rax;
+    instr->mov.src.i32 = 13;
+
+    code->push_instr(OpCode_ret);
+
+    return code;
+}
+
+static i32_t run(const Code* _code)
+{
+    Interpreter interpreter;
+    EXPECT_TRUE(interpreter.load_program(_code));
+    interpreter.run_program();
+    i32_t result = interpreter.get_last_result().i32;
+    interpreter.release_program();
+    return result;
+}
+
+TEST_F(Optimizer_, condition_is_compiled_as_a_single_branch)
+{
+    const Code* code = app.compile( app.parse("int i = 0; while( i < 10 ){ i = i + 1; } return(i);") );
+
+    EXPECT_EQ(count_opcode(code, OpCode_cmp), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_pop_jne), 1);
+    delete code;
+}
+
+TEST_F(Optimizer_, empty_condition_is_not_compiled)
+{
+    // an empty condition is always true, there is nothing to test
+    const Code* code = app.compile( app.parse("int i = 0; for(;;){ i = i + 1; }"), CompilerFlag_NONE, OptLevel_O0 );
+
+    EXPECT_EQ(count_opcode(code, OpCode_jne), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_pop_jne), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_jmp), 1); // back to the loop's beginning
+
+    // the loop never ends, until its budget does
+    Interpreter* interpreter = app.get_interpreter();
+    Budget       budget;
+    budget.instructions = 1000;
+    ASSERT_TRUE(app.load_program(code));
+    interpreter->set_budget(budget);
+    EXPECT_EQ(interpreter->run_program(), RunStatus_BUDGET_EXCEEDED);
+    interpreter->set_budget({});
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Optimizer_, fuse_instructions_ignores_jump_targets)
+{
+    // pop rax, jne => pop_jne
+    auto make_code = []() -> Code*
+    {
+        Code* code = new Code(nullptr);
+        code->push_instr(OpCode_pop)->pop_reg.dst = Register_rax;
+        code->push_instr(OpCode_jne)->jmp.offset  = 2;
+        code->push_instr(OpCode_ret);
+        code->push_instr(OpCode_ret);
+        return code;
+    };
+
+    Code* code = make_code();
+    EXPECT_EQ(Optimizer::fuse_instructions(code), 1);
+    EXPECT_EQ(count_opcode(code, OpCode_pop_jne), 1);
+    delete code;
+
+    // jump to "jne", so "pop" can't be fused with it
+    code = make_code();
+    Instruction* jmp = code->push_instr(OpCode_jmp);
+    jmp->jmp.offset  = -3;
+    EXPECT_EQ(Optimizer::fuse_instructions(code), 0);
+    delete code;
+}
+
+TEST_F(Optimizer_, remove_useless_jumps)
+{
+    Code* code = new Code(nullptr);
+    Instruction* instr = code->push_instr(OpCode_jmp);
+    instr->jmp.offset  = 1;
+    instr              = code->push_instr(OpCode_mov);
+    instr->mov.dst     = Register_rax;
+    instr->mov.src.i32 = 42;
+    code->push_instr(OpCode_ret);
+
+    EXPECT_EQ(Optimizer::remove_useless_jumps(code), 1);
+    EXPECT_EQ(code->size(), 2);
+    EXPECT_EQ(run(code), 42);
+    delete code;
+}
+
+TEST_F(Optimizer_, thread_jumps)
+{
+    Code* code = make_condition_code(false);
+
+    // jne (index 3) now lands on a jmp to the last "mov rax, 13"
+    code->get_instruction_at(3)->jmp.offset = 5;
+    Instruction* jmp = code->push_instr(OpCode_jmp);
+    jmp->jmp.offset  = -2;
+    code->push_instr(OpCode_ret);
+
+    EXPECT_EQ(run(code), 13);
+    EXPECT_EQ(Optimizer::thread_jumps(code), 1);
+    EXPECT_EQ(code->get_instruction_at(3)->jmp.offset, 3);
+    EXPECT_EQ(run(code), 13);
+    delete code;
+}
+
+TEST_F(Optimizer_, remove_unreachable_instructions)
+{
+    Code* code = make_condition_code(true);
+    Instruction* instr = code->push_instr(OpCode_mov); // after the last ret, never reached
+    instr->mov.dst     = Register_rax;
+    code->push_instr(OpCode_ret);
+
+    EXPECT_EQ(Optimizer::remove_unreachable_instructions(code), 2);
+    EXPECT_EQ(code->size(), 8);
+    EXPECT_EQ(code->get_instructions().back().opcode, OpCode_ret);
+    EXPECT_EQ(run(code), 42);
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_removes_dead_code)
+{
+    Graph*      graph     = app.parse("int sum = 0; for(int i = 0; i < 10; i = i + 1){ sum = sum + i; } return(sum);");
+    const Code* code      = app.compile(graph, CompilerFlag_NONE, OptLevel_O0);
+    const Code* optimized = app.compile(graph, CompilerFlag_NONE, OptLevel_O1);
+
+    // the empty scope of the loop body, and the code after the fake return must be removed
+    EXPECT_EQ(count_opcode(optimized, OpCode_push_stack_frame), count_opcode(code, OpCode_push_stack_frame) - 1);
+    EXPECT_EQ(count_opcode(optimized, OpCode_ret), 1);
+    EXPECT_LT(optimized->size(), code->size());
+    delete code;
+    delete optimized;
+}
+
+TEST_F(Optimizer_, O2_removes_more_instructions_than_O1)
+{
+    Graph*      graph     = app.parse("int sum = 0; for(int i = 0; i < 10; i = i + 1){ sum = sum + i; } return(sum);");
+    const Code* code      = app.compile(graph, CompilerFlag_NONE, OptLevel_O1);
+    const Code* optimized = app.compile(graph, CompilerFlag_NONE, OptLevel_O2);
+
+    EXPECT_LT(optimized->size(), code->size());
+    delete code;
+    delete optimized;
+}
+
+TEST_F(Optimizer_, O1_folds_constant_expressions)
+{
+    Graph*      graph  = app.parse("double a = 3.0 * 4.0 + 2.0; return(a);");
+    const Code* code   = app.compile(graph, CompilerFlag_NONE, OptLevel_O0);
+    const Code* folded = app.compile(graph, CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_EQ(count_evaluations(code), 3);
+    EXPECT_EQ(count_evaluations(folded), 1); // return(a) can't be folded, "a" is a variable
+    EXPECT_EQ(eval<double>("double a = 3.0 * 4.0 + 2.0; return(a);", OptLevel_O1), 14.0);
+    delete code;
+    delete folded;
+}
+
+TEST_F(Optimizer_, O1_folds_constant_sub_expressions)
+{
+    const Code* code = app.compile(app.parse("int a = 2; int b = a + 3 * 4; return(b);"), CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_EQ(count_evaluations(code), 2); // "+" and return(), "3 * 4" is folded
+    EXPECT_EQ(eval<i32_t>("int a = 2; int b = a + 3 * 4; return(b);", OptLevel_O1), 14);
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_does_not_fold_impure_functions)
+{
+    const Code* code = app.compile(app.parse("print(42);"), CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_EQ(count_evaluations(code), 1);
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_does_not_fold_failing_functions)
+{
+    const Code* code = app.compile(app.parse("int a = 1 / 0;"), CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_EQ(count_evaluations(code), 1); // error must happen at runtime
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_allocates_registers_to_loop_variables)
+{
+    const char* program = "int sum = 0; for(int i = 0; i < 10; i = i + 1){ sum = sum + i; } return(sum);";
+    const Code* code    = app.compile(app.parse(program), CompilerFlag_NONE, OptLevel_O1);
+
+    // "sum" and "i" are only accessed through registers
+    EXPECT_EQ(count_opcode(code, OpCode_load), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_store), 0);
+    EXPECT_GT(count_opcode(code, OpCode_load_reg), 0);
+    EXPECT_GT(count_opcode(code, OpCode_store_reg), 0);
+    EXPECT_EQ(eval<i32_t>(program, OptLevel_O1), 45);
+    delete code;
+}
+
+TEST_F(Optimizer_, O0_does_not_allocate_registers)
+{
+    const Code* code = app.compile(app.parse("int a = 1; int b = a + 2; return(b);"), CompilerFlag_NONE, OptLevel_O0);
+
+    EXPECT_EQ(count_opcode(code, OpCode_load_reg), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_store_reg), 0);
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_does_not_allocate_registers_to_strings)
+{
+    const Code* code = app.compile(app.parse("string s = \"a\"; s = s + \"b\"; return(s);"), CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_EQ(count_opcode(code, OpCode_load_reg), 0);
+    EXPECT_EQ(count_opcode(code, OpCode_store_reg), 0);
+    EXPECT_EQ(eval<std::string>("string s = \"a\"; s = s + \"b\"; return(s);", OptLevel_O1), "ab");
+    delete code;
+}
+
+TEST_F(Optimizer_, O1_spills_variables_when_out_of_registers)
+{
+    // 10 variables live at the same time, but only 8 registers
+    const char* program =
+            "int v1 = 1; int v2 = 2; int v3 = 3; int v4 = 4; int v5 = 5;"
+            "int v6 = 6; int v7 = 7; int v8 = 8; int v9 = 9; int v10 = 10;"
+            "int sum = v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8 + v9 + v10;"
+            "return(sum);";
+    const Code* code = app.compile(app.parse(program), CompilerFlag_NONE, OptLevel_O1);
+
+    EXPECT_GT(count_opcode(code, OpCode_load_reg), 0);
+    EXPECT_GT(count_opcode(code, OpCode_load), 0); // spilled variables stay in their stack slot
+    EXPECT_EQ(eval<i32_t>(program, OptLevel_O1), eval<i32_t>(program, OptLevel_O0));
+    EXPECT_EQ(eval<i32_t>(program, OptLevel_O1), 55);
+    delete code;
+}
+
+TEST_F(Optimizer_, register_is_displayed_in_instruction_string)
+{
+    Code* code = new Code(nullptr);
+    Instruction* instr = code->push_instr(OpCode_load_reg);
+    instr->reg.reg     = Register_r3;
+    instr->reg.type    = tools::type::get<i32_t>();
+
+    EXPECT_NE(code->instruction_to_string(0).find("r3"), std::string::npos);
+    delete code;
+}
+
+class Optimizer_levels : public ::testing::Core, public ::testing::WithParamInterface<OptLevel> {};
+
+TEST_F(Optimizer_, O2_hoists_loop_invariant_expressions)
+{
+    const char* program = "double a = 2.0; double b = 3.0; double sum = 0.0;"
+                          "for(int i = 0; i < 100; i = i + 1){ sum = sum + sin(a) * b / 2.0 + i; }"
+                          "return(sum);";
+    Graph*      graph     = app.parse(program);
+    const Code* code      = app.compile(graph, CompilerFlag_NONE, OptLevel_O1);
+    const Code* optimized = app.compile(graph, CompilerFlag_NONE, OptLevel_O2);
+
+    // "sin(a) * b / 2.0" is computed once, before the loop
+    const u64_t executed           = run_and_count(app, code);
+    const double result            = app.get_last_result_as<double>();
+    app.release_program();
+    const u64_t executed_optimized = run_and_count(app, optimized);
+    EXPECT_DOUBLE_EQ(app.get_last_result_as<double>(), result);
+    EXPECT_LT(executed_optimized + 100 * 3, executed);
+    EXPECT_EQ(count_evaluations(optimized), count_evaluations(code));
+
+    app.release_program();
+    delete code;
+    delete optimized;
+}
+
+TEST_F(Optimizer_, O2_keeps_the_loop_variant_expressions_in_the_loop)
+{
+    // "a * 2" depends on a variable written in the loop
+    std::string written = "int a = 1; int sum = 0; for(int i = 0; i < 5; i = i + 1){ sum = sum + a * 2; a = a + 1; } return(sum);";
+    EXPECT_EQ(eval<i32_t>(written, OptLevel_O2), eval<i32_t>(written, OptLevel_O1));
+
+    // "n * 2" depends on a variable declared in the loop
+    std::string declared = "int sum = 0; for(int i = 0; i < 5; i = i + 1){ int n = i; sum = sum + n * 2; } return(sum);";
+    EXPECT_EQ(eval<i32_t>(declared, OptLevel_O2), eval<i32_t>(declared, OptLevel_O1));
+
+    // the whole condition is invariant, the variable it depends on is written in a nested scope
+    std::string nested = "int n = 0; int count = 0; while(n < 3){ count = count + 1; if(count > 4){ n = 3; } } return(count);";
+    EXPECT_EQ(eval<i32_t>(nested, OptLevel_O2), eval<i32_t>(nested, OptLevel_O1));
+
+    // nested loops, "a + b" is hoisted out of the outer loop, "a * i" out of the inner one
+    std::string nested_loops = "int a = 2; int b = 3; int sum = 0;"
+                               "for(int i = 0; i < 4; i = i + 1){ for(int j = 0; j < 4; j = j + 1){ sum = sum + (a + b) * j + a * i; } }"
+                               "return(sum);";
+    EXPECT_EQ(eval<i32_t>(nested_loops, OptLevel_O2), eval<i32_t>(nested_loops, OptLevel_O1));
+}
+
+TEST_F(Optimizer_, O2_does_not_hoist_a_division_that_may_throw)
+{
+    // the loop never runs, "10 / n" must not be computed
+    const Code* code = app.compile(app.parse("int n = 0; int r = 0; while(r > 10){ r = r + 10 / n; } return(r);"), CompilerFlag_NONE, OptLevel_O2);
+    ASSERT_TRUE(app.load_program(code));
+    EXPECT_TRUE(app.run_program());
+    EXPECT_EQ(app.get_last_result_as<i32_t>(), 0);
+    app.release_program();
+    delete code;
+}
+
+TEST_P(Optimizer_levels, same_results_as_O0)
+{
+    const OptLevel level = GetParam();
+
+    std::string loop =
+            "string str = \"\";"
+            "for(int n=0; n<10; n=n+1)"
+            "{"
+            "   int p = pow(n,2);"
+            "   if( p != n )"
+            "   {"
+            "      str = str + to_string(p);"
+            "   }"
+            "   else"
+            "   {"
+            "      str = str + \"_\";"
+            "   }"
+            "}"
+            "return(str);";
+    EXPECT_EQ(eval<std::string>(loop, level), eval<std::string>(loop, OptLevel_O0));
+
+    std::string else_if =
+            "double a = 4;"
+            "double b = 5;"
+            "string msg;"
+            "if ( a > b ) {"
+            "    msg = \"a > b\";"
+            "} else if ( a < b ) {"
+            "    msg = \"a < b\";"
+            "} else {"
+            "    msg = \"a == b\";"
+            "}"
+            "return(msg)";
+    EXPECT_EQ(eval<std::string>(else_if, level), eval<std::string>(else_if, OptLevel_O0));
+
+    std::string while_loop = "int i = 0; while(i < 42){ i = i+1; } return(i)";
+    EXPECT_EQ(eval<i32_t>(while_loop, level), eval<i32_t>(while_loop, OptLevel_O0));
+
+    std::string if_only = "int i = 1; if(i == 2){ i = 3; } return(i)";
+    EXPECT_EQ(eval<i32_t>(if_only, level), eval<i32_t>(if_only, OptLevel_O0));
+
+    EXPECT_EQ(eval<i32_t>("int i = 3 + 5", level), 8);
+    EXPECT_EQ(eval<i32_t>("int b; b = 6; b = 5; return(b);", level), 5);
+}
+
+INSTANTIATE_TEST_SUITE_P(Optimizer_, Optimizer_levels, ::testing::Values(OptLevel_O1, OptLevel_O2));
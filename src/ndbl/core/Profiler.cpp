@@ -0,0 +1,168 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include "tools/core/format.h"
+#include "Code.h"
+#include "ForLoopNode.h"
+#include "FunctionNode.h"
+#include "IfNode.h"
+#include "LiteralNode.h"
+#include "TokenRibbon.h"
+#include "VariableNode.h"
+#include "WhileLoopNode.h"
+
+using namespace ndbl;
+using namespace tools;
+
+static constexpr size_t HOTTEST_INSTRUCTION_COUNT = 10; // instructions listed after the nodes by to_string()
+
+// Get the token naming a given node in the source, nullptr when it has none
+static const Token* get_token(const Node* _node)
+{
+    switch ( _node->type() )
+    {
+        case NodeType_VARIABLE:         return &static_cast<const VariableNode*>(_node)->get_identifier_token();
+        case NodeType_FUNCTION:
+        case NodeType_OPERATOR:         return &static_cast<const FunctionNode*>(_node)->get_identifier_token();
+        case NodeType_LITERAL:          return &static_cast<const LiteralNode*>(_node)->token;
+        case NodeType_BLOCK_IF:         return &static_cast<const IfNode*>(_node)->token_if;
+        case NodeType_BLOCK_FOR_LOOP:   return &static_cast<const ForLoopNode*>(_node)->token_for;
+        case NodeType_BLOCK_WHILE_LOOP: return &static_cast<const WhileLoopNode*>(_node)->token_while;
+        default:                        return nullptr;
+    }
+}
+
+// Get a given node's name, the identifier for variables
+static std::string get_name(const Node* _node)
+{
+    if ( _node == nullptr )
+    {
+        return "(no node)";
+    }
+    if ( _node->type() == NodeType_VARIABLE )
+    {
+        return static_cast<const VariableNode*>(_node)->get_identifier();
+    }
+    return _node->name();
+}
+
+void Profiler::clear()
+{
+    m_code    = nullptr;
+    m_code_id = 0;
+    m_samples.clear();
+    m_nodes.clear();
+}
+
+void Profiler::begin(const Code* _code)
+{
+    if ( m_code_id == _code->get_id() && m_samples.size() == _code->size() )
+    {
+        return; // accumulate
+    }
+
+    m_code    = _code;
+    m_code_id = _code->get_id();
+    m_samples.assign(_code->size(), Sample{});
+    m_nodes.assign(_code->size(), nullptr);
+    for ( size_t i = 0; i < _code->size(); ++i )
+    {
+        if ( const Code::DebugInfo* debug_info = _code->get_debug_info(i) )
+        {
+            m_nodes[i] = debug_info->node;
+        }
+    }
+}
+
+u64_t Profiler::get_total_nanoseconds() const
+{
+    u64_t total = 0;
+    for ( const Sample& each : m_samples )
+    {
+        total += each.nanoseconds;
+    }
+    return total;
+}
+
+std::vector<Profiler::Entry> Profiler::get_report() const
+{
+    std::vector<Entry> report;
+    std::unordered_map<const Node*, size_t> entry_index;
+    for ( size_t i = 0; i < m_samples.size(); ++i )
+    {
+        auto [it, is_new] = entry_index.emplace(m_nodes[i], report.size());
+        if ( is_new )
+        {
+            report.push_back({ m_nodes[i], 0, 0, 0 });
+        }
+        Entry& entry = report[it->second];
+        entry.instruction_count++;
+        entry.count       += m_samples[i].count;
+        entry.nanoseconds += m_samples[i].nanoseconds;
+    }
+
+    std::stable_sort(report.begin(), report.end(), [](const Entry& a, const Entry& b) { return a.nanoseconds > b.nanoseconds; });
+    return report;
+}
+
+size_t Profiler::get_line(const Node* _node, const TokenRibbon& _tokens)
+{
+    // a node's token is a copy, the one parsed is found in the ribbon
+    const Token* token = get_token(_node);
+    if ( token == nullptr || token->m_index >= _tokens.size() || _tokens.at(token->m_index).m_type != token->m_type )
+    {
+        return 0;
+    }
+    return _tokens.get_line(token->m_index);
+}
+
+std::string Profiler::to_string(const TokenRibbon* _tokens) const
+{
+    const u64_t total = std::max<u64_t>(1, get_total_nanoseconds());
+    std::string result = format::title("Profile");
+    result.append("\n");
+
+    char line[256];
+    snprintf(line, sizeof(line), "  %12s %7s %12s %6s %6s  %s\n", "time (us)", "time %", "count", "instr", "line", "node");
+    result.append(line);
+    for ( const Entry& each : get_report() )
+    {
+        const size_t source_line = each.node != nullptr && _tokens != nullptr ? get_line(each.node, *_tokens) : 0;
+        snprintf(line, sizeof(line), "  %12.3f %6.2f%% %12llu %6zu %6s  %s\n",
+                 (double)each.nanoseconds / 1000.0,
+                 100.0 * (double)each.nanoseconds / (double)total,
+                 (unsigned long long)each.count,
+                 each.instruction_count,
+                 source_line != 0 ? std::to_string(source_line).c_str() : "-",
+                 get_name(each.node).c_str());
+        result.append(line);
+    }
+
+    // hottest instructions
+    std::vector<size_t> hottest(m_samples.size());
+    for ( size_t i = 0; i < hottest.size(); ++i )
+    {
+        hottest[i] = i;
+    }
+    const size_t hottest_count = std::min(HOTTEST_INSTRUCTION_COUNT, hottest.size());
+    std::partial_sort(hottest.begin(), hottest.begin() + (std::ptrdiff_t)hottest_count, hottest.end(),
+                      [this](size_t a, size_t b) { return m_samples[a].nanoseconds > m_samples[b].nanoseconds; });
+
+    snprintf(line, sizeof(line), "\n  %12s %7s %12s %6s  %s\n", "time (us)", "time %", "count", "index", "node");
+    result.append(line);
+    for ( size_t i = 0; i < hottest_count; ++i )
+    {
+        const size_t  index  = hottest[i];
+        const Sample& sample = m_samples[index];
+        snprintf(line, sizeof(line), "  %12.3f %6.2f%% %12llu %#6zx  %s\n",
+                 (double)sample.nanoseconds / 1000.0,
+                 100.0 * (double)sample.nanoseconds / (double)total,
+                 (unsigned long long)sample.count,
+                 index,
+                 get_name(m_nodes[index]).c_str());
+        result.append(line);
+    }
+    return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "tools/core/types.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+    class Node;
+    class TokenRibbon;
+
+    /**
+     * @class Execution count and time spent in each instruction of a Code, collected by an Interpreter (cf. Interpreter::set_profiler()).
+     * Samples are accumulated over the runs of the same Code, and can be summed per Node when the code has debug info (cf. CompilerFlag_DEBUG_INFO).
+     * Profiling is opt-in: an Interpreter without a Profiler runs its regular dispatch loop.
+     */
+    class Profiler
+    {
+    public:
+        // Samples of a single instruction
+        struct Sample
+        {
+            u64_t count       = 0; // number of executions
+            u64_t nanoseconds = 0; // time spent until the next instruction
+        };
+
+        // Samples of the instructions compiled from the same Node
+        struct Entry
+        {
+            const Node* node;              // nullptr for the instructions without a node (or when the code has no debug info).
+            size_t      instruction_count; // number of instructions compiled from this node.
+            u64_t       count;             // number of executions (sum of the node's instructions).
+            u64_t       nanoseconds;
+        };
+
+        void               clear();                                   // Forget the samples (and the code).
+        void               begin(const Code*);                        // Prepare to profile a given code, samples are kept when it is the same code (same id, cf. Code::get_id()).
+        Sample*            data() { return m_samples.data(); }        // Get the samples, one per instruction of the code (cf. begin()).
+        const Sample&      get_sample(size_t _index) const { return m_samples.at(_index); } // Get the samples of a given instruction.
+        size_t             size() const { return m_samples.size(); }
+        const Code*        get_code() const { return m_code; }         // Get the code being profiled (only its address is used, the code might be deleted since).
+        u64_t              get_total_nanoseconds() const;
+        std::vector<Entry> get_report() const;                        // Get the samples summed per node, sorted by time spent (descending).
+        std::string        to_string(const TokenRibbon* _tokens = nullptr) const; // Convert the report to a text table (nodes must be alive), lines are shown when the tokens parsed are given.
+        static size_t      get_line(const Node*, const TokenRibbon&); // Get the line (1-based) of a given node in the source its tokens were parsed from, 0 when unknown.
+    private:
+        const Code*              m_code    = nullptr;
+        u64_t                    m_code_id = 0;   // cf. Code::get_id(), the code's address might be reused by another code.
+        std::vector<Sample>      m_samples;   // one per instruction.
+        std::vector<const Node*> m_nodes;     // node of each instruction, copied from the code's debug info (cf. Code::DebugInfo).
+    };
+} // namespace ndbl
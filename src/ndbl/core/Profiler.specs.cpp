@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include "fixtures/core.h"
+#include "ndbl/core/Profiler.h"
+
+using namespace ndbl;
+typedef ::testing::Core Profiler_;
+
+static const std::string PROGRAM =
+        "int sum = 0;\n"
+        "for(int i = 0; i < 10; i = i + 1)\n"
+        "{\n"
+        "    sum = sum * 2;\n"
+        "}\n"
+        "return(sum);";
+
+// Get the report entry of the first node having a given name
+static const Profiler::Entry* find_entry(const std::vector<Profiler::Entry>& _report, const std::string& _name)
+{
+    for ( const Profiler::Entry& each : _report )
+        if ( each.node != nullptr && each.node->name() == _name )
+            return &each;
+    return nullptr;
+}
+
+TEST_F(Profiler_, counts_each_instruction_and_sums_them_per_node)
+{
+    const Code* code = app.compile(app.parse(PROGRAM), CompilerFlag_DEBUG_INFO);
+    Profiler profiler;
+    app.get_interpreter()->set_profiler(&profiler);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    app.get_interpreter()->set_profiler(nullptr);
+
+    EXPECT_EQ(profiler.size(), code->size());
+    EXPECT_EQ(profiler.get_sample(0).count, 1);
+    EXPECT_EQ(profiler.get_sample(code->size() - 1).count, 1); // ret
+
+    // "sum * 2" runs once per iteration
+    const std::vector<Profiler::Entry> report = profiler.get_report();
+    const Profiler::Entry* multiply = find_entry(report, "*");
+    ASSERT_TRUE(multiply != nullptr);
+    EXPECT_GT(multiply->instruction_count, 0);
+    EXPECT_EQ(multiply->count, 10 * multiply->instruction_count);
+
+    // sorted by time spent
+    for ( size_t i = 1; i < report.size(); ++i )
+        EXPECT_GE(report[i - 1].nanoseconds, report[i].nanoseconds);
+
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Profiler_, accumulates_the_runs_of_the_same_code)
+{
+    const Code* code = app.compile(app.parse(PROGRAM), CompilerFlag_DEBUG_INFO);
+    Profiler profiler;
+    app.get_interpreter()->set_profiler(&profiler);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(profiler.get_sample(0).count, 2);
+
+    // another code restarts from zero
+    app.release_program();
+    const Code* other_code = app.compile(app.parse("int a = 42; return(a);"), CompilerFlag_DEBUG_INFO);
+    ASSERT_TRUE(app.load_program(other_code));
+    ASSERT_TRUE(app.run_program());
+    EXPECT_EQ(profiler.get_code(), other_code);
+    EXPECT_EQ(profiler.get_sample(0).count, 1);
+
+    app.get_interpreter()->set_profiler(nullptr);
+    app.release_program();
+    delete code;
+    delete other_code;
+}
+
+TEST_F(Profiler_, restarts_from_zero_when_a_code_is_created_at_the_same_address)
+{
+    alignas(Code) unsigned char storage[sizeof(Code)];
+    Code* code = new (storage) Code(nullptr);
+    code->push_instr(OpCode_ret);
+    Profiler profiler;
+    profiler.begin(code);
+    profiler.data()[0].count = 1;
+
+    // same address and size, but another code
+    code->~Code();
+    Code* other_code = new (storage) Code(nullptr);
+    other_code->push_instr(OpCode_ret);
+    ASSERT_EQ(other_code, code);
+    profiler.begin(other_code);
+    EXPECT_EQ(profiler.get_sample(0).count, 0);
+    other_code->~Code();
+}
+
+TEST_F(Profiler_, to_string_shows_each_node_line)
+{
+    const std::string source = PROGRAM; // tokens refer to the source parsed, it must stay alive
+    const Code* code = app.compile(app.parse(source), CompilerFlag_DEBUG_INFO);
+    Profiler profiler;
+    app.get_interpreter()->set_profiler(&profiler);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    app.get_interpreter()->set_profiler(nullptr);
+
+    const std::vector<Profiler::Entry> entries = profiler.get_report();
+    const Profiler::Entry* multiply = find_entry(entries, "*");
+    ASSERT_TRUE(multiply != nullptr);
+    EXPECT_EQ(Profiler::get_line(multiply->node, app.get_language()->_state.tokens()), 4);
+
+    const std::string report = profiler.to_string(&app.get_language()->_state.tokens());
+    EXPECT_NE(report.find("*"), std::string::npos);
+
+    app.release_program();
+    delete code;
+}
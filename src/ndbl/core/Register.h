@@ -15,7 +15,17 @@ namespace ndbl
         Register_rax = 0x00,        // primary accumulator
         Register_rdx = 0x01,        // storage
         Register_eip = 0x02,        // The instruction pointer.
+        Register_r0  = 0x03,        // general purpose (cf. Compiler's register allocation)
+        Register_r1,
+        Register_r2,
+        Register_r3,
+        Register_r4,
+        Register_r5,
+        Register_r6,
+        Register_r7,
         Register_COUNT,
+        Register_GP_FIRST  = Register_r0,                     // first general purpose register
+        Register_GP_COUNT  = Register_COUNT - Register_r0,    // general purpose register count
         Register_undefined = 0xff , // undefined is the default value
     };
 
@@ -25,5 +35,13 @@ namespace ndbl
         REFLECT_ENUM_V(Register_rax)
         REFLECT_ENUM_V(Register_rdx)
         REFLECT_ENUM_V(Register_eip)
+        REFLECT_ENUM_V(Register_r0)
+        REFLECT_ENUM_V(Register_r1)
+        REFLECT_ENUM_V(Register_r2)
+        REFLECT_ENUM_V(Register_r3)
+        REFLECT_ENUM_V(Register_r4)
+        REFLECT_ENUM_V(Register_r5)
+        REFLECT_ENUM_V(Register_r6)
+        REFLECT_ENUM_V(Register_r7)
     )
 }
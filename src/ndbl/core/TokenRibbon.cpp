@@ -1,5 +1,7 @@
 #include "TokenRibbon.h"
 
+#include <algorithm>
+
 #include "tools/core/log.h"
 #include "tools/core/assertions.h"
 
@@ -106,6 +108,16 @@ void TokenRibbon::reset(const char* new_buffer, size_t new_size)
     m_cursor = 0;
 }
 
+size_t TokenRibbon::get_line(size_t _index) const
+{
+    const Token& token = m_tokens.at(_index);
+    if ( token.m_buffer.intern() || token.m_buffer.data() != m_global_token.m_buffer.data() )
+    {
+        return 0; // not a token of this buffer
+    }
+    return 1 + std::count(token.m_buffer.data(), token.word(), '\n');
+}
+
 bool TokenRibbon::can_eat(size_t count) const
 {
     ASSERT(count > 0);
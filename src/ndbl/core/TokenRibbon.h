@@ -23,6 +23,7 @@ namespace ndbl
 
         void                reset(const char* buffer = nullptr, size_t size = 0);
         Token&              at(size_t index) { return m_tokens.at(index); }
+        const Token&        at(size_t index) const { return m_tokens.at(index); }
         inline Token&       back() { return m_tokens.back(); };
         std::vector<Token>::iterator
                             begin() { return m_tokens.begin(); };
@@ -39,6 +40,7 @@ namespace ndbl
         Token&              push(Token&);
         inline Token&       global_token() { return m_global_token; }
         inline size_t       size()const { return m_tokens.size(); }
+        size_t              get_line(size_t _index) const; // Get the line (1-based) of a given token's word in the buffer, 0 when unknown (the buffer must still be alive)
         std::string         to_string() const; // Generate a colored string highlighting the current and past tokens
         void                start_transaction();    // Start a transaction by saving the cursor position in a stack (allows nested transactions).
         void                rollback(); // Restore the cursor position where the last transaction started.
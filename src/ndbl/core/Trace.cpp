@@ -0,0 +1,77 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include "tools/core/format.h"
+#include "Code.h"
+
+using namespace ndbl;
+using namespace tools;
+
+Trace::Trace(size_t _capacity)
+{
+    size_t capacity = 1;
+    while ( capacity < _capacity )
+    {
+        capacity <<= 1;
+    }
+    m_slots = std::make_unique<Slot[]>(capacity);
+    m_mask  = capacity - 1;
+}
+
+void Trace::clear()
+{
+    for ( size_t i = 0; i <= m_mask; ++i )
+    {
+        m_slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_release);
+}
+
+std::vector<Trace::Record> Trace::get_records(size_t _max_count) const
+{
+    const u64_t count = get_count();
+    const u64_t size  = std::min<u64_t>({ count, capacity(), _max_count });
+
+    std::vector<Record> records;
+    records.reserve(size);
+    for ( u64_t index = count - size; index < count; ++index )
+    {
+        const Slot& slot = m_slots[index & m_mask];
+        const u64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        Record record;
+        record.eip     = slot.eip.load(std::memory_order_relaxed);
+        record.opcode  = (OpCode)slot.opcode.load(std::memory_order_relaxed);
+        record.rax.u64 = slot.rax.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ( sequence != index + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence )
+        {
+            continue; // overwritten by a newer record
+        }
+        records.push_back(record);
+    }
+    return records;
+}
+
+std::string Trace::to_string(const Code* _code, size_t _max_count) const
+{
+    const std::vector<Record> records = get_records(_max_count);
+    std::string result = format::title("Trace");
+    char line[64];
+    snprintf(line, sizeof(line), "%zu record(s) of %llu\n", records.size(), (unsigned long long)get_count());
+    result.append(line);
+    for ( const Record& each : records )
+    {
+        if ( _code != nullptr && each.eip < _code->size() && _code->get_instructions()[each.eip].opcode == each.opcode )
+        {
+            result.append(_code->instruction_to_string(each.eip));
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "%#6llx: %s", (unsigned long long)each.eip, OpCode_to_string(each.opcode));
+            result.append(line);
+        }
+        result.append("  (rax: " + each.rax.to_string() + ")\n");
+    }
+    return result;
+}
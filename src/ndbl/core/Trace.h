@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tools/core/types.h"
+#include "tools/core/reflection/qword.h"
+#include "Instruction.h"
+
+namespace ndbl
+{
+    // forward declarations
+    class Code;
+
+    /**
+     * @class Fixed-size ring buffer of the last instructions executed by an Interpreter (cf. Interpreter::set_trace()).
+     * Each step records its instruction pointer, opcode and rax (before executing the instruction), older records are overwritten.
+     * Records are raw binary, they are decoded only when read (cf. to_string()), so a trace can stay enabled for post-mortems.
+     * A single Interpreter (thread) must push to a given Trace, but it can be read at any time from any thread without locking:
+     * each slot is a tiny seqlock, a record overwritten while being read is dropped.
+     */
+    class Trace
+    {
+    public:
+        static constexpr size_t DEFAULT_CAPACITY = 4096; // in records
+
+        struct Record
+        {
+            u64_t        eip;
+            OpCode       opcode;
+            tools::qword rax;
+        };
+
+        explicit Trace(size_t _capacity = DEFAULT_CAPACITY); // capacity is rounded up to a power of two
+        Trace(const Trace&) = delete;
+        Trace& operator=(const Trace&) = delete;
+
+        inline void         push(u64_t _eip, OpCode _opcode, tools::qword _rax);
+        void                clear();                                      // Forget the records, must not be called while pushing.
+        size_t              capacity() const { return m_mask + 1; }
+        u64_t               get_count() const { return m_count.load(std::memory_order_acquire); } // Get the count of records pushed since the last clear(), the last capacity() ones are kept.
+        std::vector<Record> get_records(size_t _max_count = SIZE_MAX) const; // Get the last records (at most _max_count), oldest first.
+        std::string         to_string(const Code* _code = nullptr, size_t _max_count = SIZE_MAX) const; // Decode the last records, instructions are detailed when the code traced is given.
+    private:
+        // A record, written with relaxed atomics (on x86 these are plain moves)
+        struct Slot
+        {
+            std::atomic<u64_t> sequence{0}; // index of the record + 1, 0 while being written
+            std::atomic<u64_t> eip{0};
+            std::atomic<u64_t> opcode{0};
+            std::atomic<u64_t> rax{0};
+        };
+
+        std::unique_ptr<Slot[]> m_slots;
+        size_t                  m_mask;
+        std::atomic<u64_t>      m_count{0};
+    };
+
+    inline void Trace::push(u64_t _eip, OpCode _opcode, tools::qword _rax)
+    {
+        const u64_t index = m_count.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[index & m_mask];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.eip.store(_eip, std::memory_order_relaxed);
+        slot.opcode.store(_opcode, std::memory_order_relaxed);
+        slot.rax.store(_rax.u64, std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+        m_count.store(index + 1, std::memory_order_release);
+    }
+} // namespace ndbl
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "fixtures/core.h"
+#include "ndbl/core/Trace.h"
+
+using namespace ndbl;
+using namespace tools;
+typedef ::testing::Core Trace_;
+
+TEST_F(Trace_, keeps_the_last_records)
+{
+    Trace trace(5);
+    EXPECT_EQ(trace.capacity(), 8);
+
+    for ( u64_t i = 0; i < 20; ++i )
+    {
+        qword rax;
+        rax.u64 = i * 10;
+        trace.push(i, OpCode_mov, rax);
+    }
+
+    const std::vector<Trace::Record> records = trace.get_records();
+    EXPECT_EQ(trace.get_count(), 20);
+    ASSERT_EQ(records.size(), 8);
+    EXPECT_EQ(records.front().eip, 12);
+    EXPECT_EQ(records.back().eip, 19);
+    EXPECT_EQ(records.back().rax.u64, 190);
+
+    EXPECT_EQ(trace.get_records(3).front().eip, 17);
+
+    trace.clear();
+    EXPECT_TRUE(trace.get_records().empty());
+}
+
+TEST_F(Trace_, records_each_instruction_run)
+{
+    const Code* code = app.compile(app.parse("int a = 0; for(int i = 0; i < 3; i = i + 1) { a = a + i; } return(a);"));
+    Trace trace;
+    app.get_interpreter()->set_trace(&trace);
+    ASSERT_TRUE(app.load_program(code));
+    ASSERT_TRUE(app.run_program());
+    app.get_interpreter()->set_trace(nullptr);
+
+    const std::vector<Trace::Record> records = trace.get_records();
+    ASSERT_FALSE(records.empty());
+    EXPECT_GT(records.size(), code->size()); // the loop runs several times
+    EXPECT_EQ(records.front().eip, 0);
+    EXPECT_EQ(records.back().opcode, OpCode_ret);
+    EXPECT_EQ(records.back().eip, code->size() - 1);
+    for ( const Trace::Record& each : records )
+        EXPECT_EQ(code->get_instructions()[each.eip].opcode, each.opcode);
+
+    EXPECT_NE(trace.to_string(code).find("ret"), std::string::npos);
+
+    app.release_program();
+    delete code;
+}
+
+TEST_F(Trace_, can_be_read_while_pushing)
+{
+    Trace trace(64);
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for ( u64_t i = 0; i < 100000; ++i )
+        {
+            qword rax;
+            rax.u64 = i;
+            trace.push(i, OpCode_mov, rax);
+        }
+        done = true;
+    });
+
+    // records are always consistent, and in order
+    while ( !done )
+    {
+        const std::vector<Trace::Record> records = trace.get_records();
+        for ( size_t i = 0; i < records.size(); ++i )
+        {
+            EXPECT_EQ(records[i].rax.u64, records[i].eip);
+            if ( i != 0 )
+            {
+                EXPECT_LT(records[i - 1].eip, records[i].eip);
+            }
+        }
+    }
+    writer.join();
+    EXPECT_EQ(trace.get_records().size(), 64);
+}
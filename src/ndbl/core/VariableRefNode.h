@@ -52,6 +52,11 @@ namespace ndbl
             CONNECT( m_variable->on_destroy, &VariableRefNode::clear_variable );
         }
 
+        VariableNode* get_variable() const
+        {
+            return m_variable;
+        }
+
         void clear_variable()
         {
             if ( m_variable == nullptr )
@@ -4,11 +4,14 @@
 #include "ndbl/core/Interpreter.h"
 #include "ndbl/core/language/Nodlang.h"
 #include "tools/core/FileSystem.h"
+#include <chrono>
+#include <cstdlib>
 #include <exception>
 #include <gtest/gtest.h>
 #include <string>
 #include <fstream>
 #include <filesystem>
+#include <vector>
 
 using namespace ndbl;
 
@@ -19,6 +22,21 @@ class Core : public Test
 public:
     NodableHeadless app;
 
+    // Programs covering each kind of instruction, each backend (JIT, AOT, bytecode) must run them as the interpreter does.
+    // Their result is not a string, so it can be compared bitwise.
+    inline static const std::vector<std::string> PROGRAMS = {
+        "int i = 10",
+        "int sum = 1; for(int i = 0; i < 10; i = i + 1) { sum = sum * 2; } return(sum);",
+        "int n = 0; while(n < 100) { n = n + 3; } return(n);",
+        "double x = 1.5; double y = 0.25; return(x * y - x + y * 3.0);",
+        "int bob = 50; int alice = 10; int val; if(bob>alice) { val = bob; } else { val = alice; } return(val);",
+        "bool a = true; bool b = false; bool r = !a != b; return(r);",
+        "int a = 7; int b = -3; return(a * b + a / 2 - b);",
+        "double d = 3.0; return(pow(d, 2.0) + sqrt(16.0));",
+        "string s = \"a\"; for(int i = 0; i < 3; i = i + 1) { s = s + \"b\"; } return(s == \"abbb\");",
+        "double a = 0.5; double b = 2.0; double r = sin(a) + cos(b) * sqrt(a); return(r);", // a dataflow with CompilerFlag_PARALLEL
+    };
+
     Core()
     {
     }
@@ -28,6 +46,9 @@ public:
         app.init();
         // in some tests, we call directly some method on the language that requires we pass a Graph* ahead of time
         app.get_language()->_state.reset_graph(app.get_graph() );
+        // NDBL_JIT=1 runs the programs as machine code (cf. test_ndbl_core_jit)
+        if ( std::getenv("NDBL_JIT") != nullptr )
+            app.set_jit_enabled(true);
 
         tools::log::set_verbosity( tools::log::Verbosity_Message );
         tools::log::set_verbosity( "Parser", tools::log::Verbosity_Verbose );
@@ -48,7 +69,7 @@ public:
     ~Core() = default;
 
     template<typename return_t>
-    return_t eval(const std::string &_source_code)
+    return_t eval(const std::string &_source_code, OptLevel _opt_level = OptLevel_DEFAULT)
     {
         static_assert(!std::is_pointer<return_t>::value, "returning a pointer from VM would fail (destroyed leaving scope)");
 
@@ -60,7 +81,7 @@ public:
         }
 
         // compile
-        auto asm_code = app.compile(graph);
+        auto asm_code = app.compile(graph, CompilerFlag_DEFAULT, _opt_level);
         if (!asm_code)
         {
             throw std::runtime_error("Compiler was not able to compile program's graph.");
@@ -149,6 +170,34 @@ public:
         return program;
     }
 
+    // Get the first node having a given name, nullptr when none
+    static Node* find_node(Graph* _graph, const std::string& _name)
+    {
+        for ( Node* each : _graph->nodes() )
+            if ( each->name() == _name )
+                return each;
+        return nullptr;
+    }
+
+    // Count the instructions having one of the given opcodes in a given code
+    template<typename ...OpCodes>
+    static size_t count_opcode(const Code* _code, OpCodes... _opcodes)
+    {
+        size_t count = 0;
+        for ( const Instruction& each : _code->get_instructions() )
+            if ( ((each.opcode == _opcodes) || ...) )
+                ++count;
+        return count;
+    }
+
+    // Get a path no other test uses, in the temporary directory
+    static std::string get_temp_path(const std::string& _extension)
+    {
+        static size_t count = 0;
+        const auto    now   = std::chrono::steady_clock::now().time_since_epoch().count();
+        return ( std::filesystem::temp_directory_path() / ("ndbl-" + std::to_string(now) + "-" + std::to_string(count++) + _extension) ).string();
+    }
+
     void log_ribbon() const
     {
         LOG_MESSAGE("fixture::core", "%s\n\n", get_language()->_state.string().c_str());
@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
 
 #include "ndbl/core/fixtures/core.h"
 #include "tools/core/reflection/reflection"
@@ -28,6 +30,100 @@ TEST_F(Language_basics, can_get_invert_operator_with_signature )
     EXPECT_TRUE(get_language()->find_operator_fct(&f));
 }
 
+TEST_F(Language_basics, math_functions_are_pure_print_is_not )
+{
+    FunctionDescriptor plus;
+    plus.init<double(double, double)>("+");
+    EXPECT_TRUE(get_language()->is_pure( get_language()->find_function(&plus) ));
+
+    FunctionDescriptor print;
+    print.init<std::string(i32_t)>("print");
+    EXPECT_FALSE(get_language()->is_pure( get_language()->find_function(&print) ));
+
+    // the math library is loaded as pure, but an assignment writes its left operand
+    FunctionDescriptor assign;
+    assign.init<double(double&, double)>("=");
+    const IInvokable* assign_invokable = get_language()->find_function(&assign);
+    ASSERT_NE(assign_invokable, nullptr);
+    EXPECT_FALSE(get_language()->is_pure(assign_invokable));
+}
+
+static i32_t int_mod(i32_t a, i32_t b) { return a % b; }
+
+TEST_F(Language_basics, find_function_is_memoized_until_a_function_is_added )
+{
+    FunctionDescriptor mod;
+    mod.init<i32_t(i32_t, i32_t)>("mod");
+
+    // only mod(double, double) exists, it is the fallback
+    const IInvokable* fallback = get_language()->find_function(&mod);
+    ASSERT_TRUE(fallback != nullptr);
+    EXPECT_TRUE(fallback->get_sig()->arg_at(0).type->is<double>());
+    EXPECT_EQ(get_language()->find_function_exact(&mod), nullptr);
+    EXPECT_EQ(get_language()->find_function(&mod), fallback);
+
+    // an exact match is found once added
+    static InvokableStaticFunction<i32_t(i32_t, i32_t)> exact("mod", &int_mod);
+    get_language()->add_function(&exact);
+    EXPECT_EQ(get_language()->find_function(&mod), &exact);
+    EXPECT_EQ(get_language()->find_function_exact(&mod), &exact);
+}
+
+static double i16_plus_double(i16_t a, double b) { return a + b; }
+
+TEST_F(Language_basics, find_operator_fct_is_memoized_until_a_function_is_added )
+{
+    FunctionDescriptor plus;
+    plus.init<double(i16_t, double)>("+");
+
+    // no "+" takes an i16_t, a fallback is resolved once
+    const size_t      resolution_count = get_language()->get_resolution_count();
+    const IInvokable* fallback         = get_language()->find_operator_fct(&plus);
+    ASSERT_TRUE(fallback != nullptr);
+    EXPECT_EQ(get_language()->get_resolution_count(), resolution_count + 1);
+
+    // the next lookups hit the cache
+    EXPECT_EQ(get_language()->find_operator_fct(&plus), fallback);
+    EXPECT_EQ(get_language()->find_operator_fct_exact(&plus), nullptr);
+    EXPECT_EQ(get_language()->get_resolution_count(), resolution_count + 1);
+
+    // an exact match is found once added
+    static InvokableStaticFunction<double(i16_t, double)> exact("+", &i16_plus_double);
+    get_language()->add_function(&exact);
+    EXPECT_EQ(get_language()->get_resolution_count(), 0);
+    EXPECT_EQ(get_language()->find_operator_fct(&plus), &exact);
+    EXPECT_EQ(get_language()->find_operator_fct_exact(&plus), &exact);
+}
+
+TEST_F(Language_basics, find_function_from_several_threads )
+{
+    FunctionDescriptor mod;
+    mod.init<double(i32_t, i32_t)>("mod");
+    FunctionDescriptor pow;
+    pow.init<double(double, double)>("pow");
+    const IInvokable* expected_mod = get_language()->find_function_fallback(&mod); // not memoized
+    const IInvokable* expected_pow = get_language()->find_function_fallback(&pow);
+    ASSERT_TRUE(expected_mod != nullptr);
+    ASSERT_TRUE(expected_pow != nullptr);
+
+    std::atomic<size_t> mismatch_count{0};
+    std::vector<std::thread> threads;
+    for ( int i = 0; i < 4; ++i )
+    {
+        threads.emplace_back([&]() {
+            for ( int j = 0; j < 1000; ++j )
+            {
+                mismatch_count += get_language()->find_function(&mod) != expected_mod;
+                mismatch_count += get_language()->find_function(&pow) != expected_pow;
+            }
+        });
+    }
+    for ( std::thread& each : threads )
+        each.join();
+
+    EXPECT_EQ(mismatch_count, 0);
+}
+
 TEST_F(Language_basics, by_ref_assign )
 {
     FunctionDescriptor f;
@@ -146,7 +146,24 @@ BENCHMARK_DEFINE_F(NodlangFixture, parse_token__a_single_identifier_starting_wit
     }
 }
 
+BENCHMARK_DEFINE_F(NodlangFixture, find_function__exact_and_fallback)(benchmark::State& state) {
+
+    // "+" has many overloads, the last two have no exact match
+    std::array<FunctionDescriptor, 4> signatures;
+    signatures[0].init<double(double, double)>("+");
+    signatures[1].init<i32_t(i32_t, i32_t)>("+");
+    signatures[2].init<double(i16_t, double)>("+");
+    signatures[3].init<double(i32_t, i16_t)>("mod");
+
+    size_t id = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize( language->find_function(&signatures[id++ % signatures.size()]) );
+    }
+}
+
 BENCHMARK_REGISTER_F(NodlangFixture, tokenize__some_code_to_graph);
+BENCHMARK_REGISTER_F(NodlangFixture, find_function__exact_and_fallback);
 BENCHMARK_REGISTER_F(NodlangFixture, parse_token__a_single_operator);
 BENCHMARK_REGISTER_F(NodlangFixture, parse_token__a_single_boolean);
 BENCHMARK_REGISTER_F(NodlangFixture, parse_token__a_single_double);
@@ -32,6 +32,7 @@
 #include "ndbl/core/VariableRefNode.h"
 #include "ndbl/core/WhileLoopNode.h"
 #include "ndbl/core/language/Nodlang_biology.h"
+#include "ndbl/core/language/Nodlang_io.h"
 #include "ndbl/core/language/Nodlang_math.h"
 
 using namespace ndbl;
@@ -143,8 +144,9 @@ Nodlang::Nodlang(bool _strict)
     // A.3. Load libraries
     //---------------------
 
-    load_library<Nodlang_math>();     // contains all operator implementations
-    load_library<Nodlang_biology>();  // a function to convert RNA (library is wip)
+    load_library<Nodlang_math>(FunctionFlag_PURE);     // contains all operator implementations
+    load_library<Nodlang_biology>(FunctionFlag_PURE);  // a function to convert RNA (library is wip)
+    load_library<Nodlang_io>();                        // print
 }
 
 Nodlang::~Nodlang()
@@ -1816,7 +1818,7 @@ const IInvokable* Nodlang::find_function(const char* _signature_hint) const
     return find_function( Hash::hash(_signature_hint) );
 }
 
-const tools::IInvokable* Nodlang::find_function(u32_t _hash) const
+const tools::IInvokable* Nodlang::find_function(u64_t _hash) const
 {
     auto found = m_functions_by_signature.find(_hash);
     if ( found != m_functions_by_signature.end())
@@ -1832,9 +1834,72 @@ const tools::IInvokable* Nodlang::find_function(const FunctionDescriptor* _type)
     {
         return nullptr;
     }
-    auto exact = find_function_exact(_type);
-    if (!exact) return find_function_fallback(_type);
-    return exact;
+    return resolve_function(_type, false).resolved;
+}
+
+Nodlang::FunctionResolution Nodlang::resolve_function(const FunctionDescriptor* _type, bool _is_operator) const
+{
+    // key is the identifier, the argument type ids and where to look, the resolutions sharing a key are compared to avoid any collision
+    const size_t arg_count = _type->arg_count();
+    u64_t        key       = Hash::combine(Hash::hash(_type->get_identifier()), _is_operator);
+    for ( size_t i = 0; i < arg_count; ++i )
+    {
+        key = Hash::combine(key, _type->arg_at(i).type->id().hash_code());
+    }
+
+    auto matches = [&](const ResolvedSignature& _signature) -> bool
+    {
+        if ( _signature.is_operator != _is_operator || _signature.arg_types.size() != arg_count || _signature.identifier != _type->get_identifier() )
+            return false;
+        for ( size_t i = 0; i < arg_count; ++i )
+            if ( !_signature.arg_types[i]->equals(_type->arg_at(i).type) )
+                return false;
+        return true;
+    };
+
+    {
+        std::shared_lock lock(m_resolutions_mutex);
+        auto range = m_resolutions.equal_range(key);
+        for ( auto it = range.first; it != range.second; ++it )
+        {
+            if ( matches(it->second) )
+            {
+                return it->second.resolution;
+            }
+        }
+    }
+
+    // not resolved yet, scan the functions (the exact one first)
+    FunctionResolution resolution;
+    for ( auto* invokable : _is_operator ? m_operators_impl : m_functions )
+    {
+        if ( invokable->get_sig()->is_exactly(_type) )
+        {
+            resolution.exact = invokable;
+            break;
+        }
+    }
+    if ( resolution.exact )
+        resolution.resolved = resolution.exact;
+    else
+        resolution.resolved = _is_operator ? find_operator_fct_fallback(_type) : find_function_fallback(_type);
+
+    std::unique_lock lock(m_resolutions_mutex);
+    auto range = m_resolutions.equal_range(key);
+    for ( auto it = range.first; it != range.second; ++it )
+    {
+        if ( matches(it->second) )
+        {
+            return it->second.resolution; // resolved by another thread meanwhile
+        }
+    }
+    ResolvedSignature signature{ _type->get_identifier(), {}, _is_operator, resolution };
+    for ( size_t i = 0; i < arg_count; ++i )
+    {
+        signature.arg_types.push_back(_type->arg_at(i).type);
+    }
+    m_resolutions.emplace(key, std::move(signature));
+    return resolution;
 }
 
 std::string& Nodlang::serialize_property(std::string& _out, const Property* _property) const
@@ -1844,10 +1909,11 @@ std::string& Nodlang::serialize_property(std::string& _out, const Property* _pro
 
 const tools::IInvokable* Nodlang::find_function_exact(const FunctionDescriptor* _other_type) const
 {
-    for(auto* invokable : m_functions)
-        if ( invokable->get_sig()->is_exactly(_other_type) )
-            return invokable;
-    return nullptr;
+    if (!_other_type)
+    {
+        return nullptr;
+    }
+    return resolve_function(_other_type, false).exact;
 }
 
 const tools::IInvokable* Nodlang::find_function_fallback(const FunctionDescriptor* _other_type) const
@@ -1862,12 +1928,7 @@ const tools::IInvokable* Nodlang::find_operator_fct_exact(const FunctionDescript
 {
     if (!_other_type)
         return nullptr;
-
-    for(auto* invokable : m_operators_impl)
-        if ( invokable->get_sig()->is_exactly(_other_type) )
-            return invokable;
-
-    return nullptr;
+    return resolve_function(_other_type, true).exact;
 }
 
 const tools::IInvokable* Nodlang::find_operator_fct(const FunctionDescriptor *_type) const
@@ -1876,10 +1937,7 @@ const tools::IInvokable* Nodlang::find_operator_fct(const FunctionDescriptor *_t
     {
         return nullptr;
     }
-    const tools::IInvokable* invokable = find_operator_fct_exact(_type);
-    if (invokable != nullptr)
-        return invokable;
-    return find_operator_fct_fallback(_type);
+    return resolve_function(_type, true).resolved;
 }
 
 const tools::IInvokable* Nodlang::find_operator_fct_fallback(const FunctionDescriptor* _other_type) const
@@ -1894,12 +1952,38 @@ const tools::IInvokable* Nodlang::find_operator_fct_fallback(const FunctionDescr
     return nullptr;
 }
 
-void Nodlang::add_function(const tools::IInvokable* _invokable)
+size_t Nodlang::get_resolution_count() const
 {
+    std::shared_lock lock(m_resolutions_mutex);
+    return m_resolutions.size();
+}
+
+void Nodlang::add_function(const tools::IInvokable* _invokable, FunctionFlags _flags)
+{
+    {
+        std::unique_lock lock(m_resolutions_mutex);
+        m_resolutions.clear(); // the new function might be a better match
+    }
+
+    // a function writing an argument passed by reference has a side effect (ex: "="), it can't be pure
+    const FunctionDescriptor* sig = _invokable->get_sig();
+    for ( size_t i = 0; i < sig->arg_count() && (_flags & FunctionFlag_PURE); ++i )
+    {
+        if ( sig->arg_at(i).pass_by_ref )
+        {
+            _flags &= ~FunctionFlag_PURE;
+        }
+    }
+
     m_functions.push_back(_invokable);
+    if ( _flags & FunctionFlag_PURE )
+    {
+        m_pure_functions.insert(_invokable);
+    }
 
     std::string type_as_string;
     serialize_func_sig(type_as_string, _invokable->get_sig());
+    m_functions_by_signature.emplace(Hash::hash(type_as_string.c_str()), _invokable);
 
     // Stops if no operator having the same identifier and argument count is found
     if (!find_operator(_invokable->get_sig()->get_identifier(), static_cast<Operator_t>(_invokable->get_sig()->arg_count())))
@@ -1913,6 +1997,11 @@ void Nodlang::add_function(const tools::IInvokable* _invokable)
     LOG_VERBOSE("Nodlang", "add operator: %s (in m_functions and m_operator_implems)\n", type_as_string.c_str());
 }
 
+bool Nodlang::is_pure(const tools::IInvokable* _invokable) const
+{
+    return m_pure_functions.find(_invokable) != m_pure_functions.end();
+}
+
 const Operator *Nodlang::find_operator(const std::string &_identifier, Operator_t operator_type) const
 {
     auto is_exactly = [&](const Operator *op) {
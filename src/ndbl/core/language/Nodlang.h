@@ -4,6 +4,9 @@
 #include <vector>
 #include <stack>
 #include <exception>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "tools/core/reflection/reflection"
 #include "tools/core/System.h"
@@ -38,6 +41,13 @@ namespace ndbl{
         SerializeFlag_WRAP_WITH_BRACES = 1 << 1
     };
 
+    typedef int FunctionFlags;
+    enum FunctionFlag_
+    {
+        FunctionFlag_NONE = 0,
+        FunctionFlag_PURE = 1 << 0  // Result only depends on the arguments, and calling it has no side effect (it can be evaluated at compile time). Ignored when an argument is passed by reference.
+    };
+
     /**
 	 * Nodlang is Nodable's language.
 	 * This class define Nodlang language, and provide a parser/serializer.
@@ -162,23 +172,41 @@ namespace ndbl{
         // Language definition -------------------------------------------------------------------------
 
     private:
-        const tools::IInvokable* find_function(u32_t _hash) const;
+        // Overload resolution of a signature (cf. resolve_function())
+        struct FunctionResolution
+        {
+            const tools::IInvokable* exact    = nullptr; // nullptr when none
+            const tools::IInvokable* resolved = nullptr; // exact, or fallback when no exact, nullptr when none
+        };
+
+        // A signature resolved previously
+        struct ResolvedSignature
+        {
+            std::string                               identifier;
+            std::vector<const tools::TypeDescriptor*> arg_types;
+            bool                                      is_operator;
+            FunctionResolution                        resolution;
+        };
+        FunctionResolution    resolve_function(const tools::FunctionDescriptor*, bool _is_operator) const; // Resolve a signature among the functions (or the operators' implementations only), memoized until a function is added (thread safe).
     public:
         const tools::IInvokable* find_function(const char* _signature ) const;           // Find a function by signature as string (ex:   "int multiply(int,int)" )
-        const tools::IInvokable* find_function(const tools::FunctionDescriptor*) const;               // Find a function by signature (strict first, then cast allowed)
-        const tools::IInvokable* find_function_exact(const tools::FunctionDescriptor*) const;         // Find a function by signature (no cast allowed).
+        const tools::IInvokable* find_function(u64_t _hash) const;                       // Find a function by the hash of its serialized signature (cf. serialize_func_sig()), nullptr when none.
+        const tools::IInvokable* find_function(const tools::FunctionDescriptor*) const;               // Find a function by signature (strict first, then cast allowed), the result is memoized (cf. resolve_function())
+        const tools::IInvokable* find_function_exact(const tools::FunctionDescriptor*) const;         // Find a function by signature (no cast allowed), memoized like find_function().
         const tools::IInvokable* find_function_fallback(const tools::FunctionDescriptor*) const;      // Find a function by signature (casts allowed).
-        const tools::IInvokable* find_operator_fct(const tools::FunctionDescriptor*) const;           // Find an operator's function by signature (strict first, then cast allowed)
-        const tools::IInvokable* find_operator_fct_exact(const tools::FunctionDescriptor*) const;     // Find an operator's function by signature (no cast allowed).
+        const tools::IInvokable* find_operator_fct(const tools::FunctionDescriptor*) const;           // Find an operator's function by signature (strict first, then cast allowed), memoized like find_function().
+        const tools::IInvokable* find_operator_fct_exact(const tools::FunctionDescriptor*) const;     // Find an operator's function by signature (no cast allowed), memoized like find_function().
         const tools::IInvokable* find_operator_fct_fallback(const tools::FunctionDescriptor*) const;  // Find an operator's function by signature (casts allowed).
         const tools::Operator* find_operator(const std::string& , tools::Operator_t) const;// Find an operator by symbol and type (unary, binary or ternary).
         const std::vector<const tools::IInvokable*>& get_api()const { return m_functions; } // Get all the functions registered in the language.
         Token_t               to_literal_token(const tools::TypeDescriptor*) const;
         const tools::TypeDescriptor*    get_type(Token_t _token)const;                              // Get the type corresponding to a given token_t (must be a type keyword)
-        void                  add_function(const tools::IInvokable*);                     // Adds a new function (regular or operator's implementation).
+        void                  add_function(const tools::IInvokable*, FunctionFlags = FunctionFlag_NONE); // Adds a new function (regular or operator's implementation).
+        bool                  is_pure(const tools::IInvokable*) const;                    // Check if a given function was added with FunctionFlag_PURE.
+        size_t                get_resolution_count() const;                               // Get the count of signatures resolved since the last function was added (cf. resolve_function()).
         int                   get_precedence(const tools::FunctionDescriptor*)const;                // Get the precedence of a given function (precedence may vary because function could be an operator implementation).
 
-        template<typename T> void load_library(); // Instantiate a library from its type (uses reflection to get all its static methods).
+        template<typename T> void load_library(FunctionFlags = FunctionFlag_NONE); // Instantiate a library from its type (uses reflection to get all its static methods), each function is added with the given flags.
     private:
         struct {
             std::vector<std::tuple<const char*, Token_t>>                  keywords;
@@ -190,7 +218,10 @@ namespace ndbl{
         std::vector<const tools::Operator*>               m_operators;                // the allowed operators (!= implementations).
         std::vector<const tools::IInvokable*>             m_operators_impl;           // operators' implementations.
         std::vector<const tools::IInvokable*>             m_functions;                // all the functions (including operator's).
-        std::unordered_map<u32_t , const tools::IInvokable*> m_functions_by_signature; // Functions indexed by signature hash
+        std::unordered_map<u64_t, const tools::IInvokable*> m_functions_by_signature; // Functions indexed by serialized signature's hash (the first one added wins)
+        std::unordered_set<const tools::IInvokable*>      m_pure_functions;           // functions added with FunctionFlag_PURE.
+        mutable std::unordered_multimap<u64_t, ResolvedSignature> m_resolutions;      // signatures resolved, by hash of their identifier and argument types (cleared by add_function()).
+        mutable std::shared_mutex                         m_resolutions_mutex;        // functions can be resolved from several threads (ex: concurrent compilations).
         std::unordered_map<Token_t, char>                 m_single_char_by_keyword;
         std::unordered_map<Token_t, const char*>          m_keyword_by_token_t;       // token_t to string (ex: Token_t::keyword_double => "double").
         std::unordered_map<std::type_index, const char*>  m_keyword_by_type_id;
@@ -201,14 +232,14 @@ namespace ndbl{
     };
 
     template<typename T>
-    void Nodlang::load_library()
+    void Nodlang::load_library(FunctionFlags _flags)
     {
         T library; // Libraries are static and this will force static code to run. TODO: add load/release methods
 
         auto class_desc = tools::type::get_class<T>();
         for(const tools::IInvokable* method : class_desc->get_statics() )
         {
-            add_function(method);
+            add_function(method, _flags);
         }
     }
 
@@ -0,0 +1,36 @@
+#include "Nodlang_io.h"
+
+#include <cstdio>
+#include <string>
+#include "tools/core/format.h"
+#include "tools/core/reflection/Initializer.h"
+#include "tools/core/types.h"
+
+using namespace ndbl;
+using namespace tools;
+
+namespace // anonymous, accessible only in that file
+{
+    std::string _to_string(bool b) { return b ? "true" : "false"; }
+    std::string _to_string(double n) { return format::number(n); }
+    std::string _to_string(i32_t i) { return std::to_string(i); }
+    std::string _to_string(std::string s) { return s; }
+    template<typename T>
+    std::string _print(T _value)
+    {
+        std::string result = _to_string(_value);
+        printf("print: %s\n", result.c_str());
+        return result;
+    }
+}
+
+REFLECT_STATIC_INITIALIZER
+(
+    DEFINE_REFLECT(Nodlang_io)
+        .add_method<std::string(bool)>(&_print, "print")
+        .add_method<std::string(double)>(&_print, "print")
+        .add_method<std::string(i32_t)>(&_print, "print")
+        .add_method<std::string(std::string)>(&_print, "print");
+);
+
+Nodlang_io::Nodlang_io(){} // necessary to trigger static code execution
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace ndbl
+{
+    /**
+     * Nodable's input/output library.
+     * Functions from this library have side effects, they can't be evaluated at compile time.
+     * See cpp for more information
+     */
+    class Nodlang_io
+    {
+    public:
+        Nodlang_io();
+    };
+}
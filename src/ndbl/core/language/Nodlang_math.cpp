@@ -1,74 +1,22 @@
 #include "Nodlang_math.h"
 
+#include <cmath>
+#include <stdexcept>
 #include <string>
 #include "tools/core/format.h"
 #include "tools/core/reflection/Initializer.h"
 #include "tools/core/types.h"
-#include "glm/common.hpp"
-#include "glm/trigonometric.hpp"
 
 using namespace ndbl;
 using namespace tools;
 
 namespace // anonymous, accessible only in that file
 {
-    bool _and(bool a, bool b) { return a && b; }
-    bool _implies(bool a, bool b) { return !a || b; }
-    bool _not(bool b) { return !b; }
-    bool _or(bool a, bool b) { return a || b; }
-    bool _to_bool(double n) { return n == 0.0; }
-    bool _xor(bool a, bool b){ return a ^ b; }
-    double _cos(double n) { return glm::cos(n); }
-    double _mod(double a, double b) { return glm::mod(a, b); }
-    double _secondDegreePolynomial(double a, double x, double b, double y, double c) { return a * x * x + b * y + c;}
-    double _sin(double n) { return glm::sin(n); }
-    std::string _to_string(bool b) { return b ? "true" : "false"; }
-    std::string _to_string(double n) { return format::number(n); }
-    std::string _to_string(i32_t i) { return std::to_string(i); }
-    std::string _to_string(std::string s) { return s; }
-    template<typename T, typename U>
-    T _minus(T a, U b){ return a - T(b); }
-    template<typename T, typename U>
-    T _multiply(T a, U b) { return a * T(b); }
-    template<typename T, typename U>
-    T _plus(T a, U b){ return a + T(b); }
-    template<typename T>
-    T _plus(T a, T b){ return a + T(b); }
-    template<>
-    std::string _plus(std::string left, double right) { return left + format::number(right); }
-    template<>
-    std::string _plus(std::string left, i32_t right) { return left + std::to_string(right); }
-    template<typename T, typename U>
-    T _divide(T a, U b) { if ( b == 0 ) throw std::runtime_error("division by zero !"); return a / T(b);}
-    template<typename T, typename U>
-    T _assign(T& a, U b) { return a = T(b); }
-    template<typename T>
-    T _sqrt(T n) { return (T)sqrt((float)n); }
-    template<typename T, typename U>
-    bool _greater(T a, U b) { return a > b; }
-    template<typename T, typename U>
-    bool _greater_or_eq(T a, U b) { return a >= b; }
-    template<typename T, typename U>
-    bool _lower(T a, U b) { return a < b; }
-    template<typename T, typename U>
-    bool _lower_or_eq(T a, U b) { return a <= b; }
-    template<typename T>
-    T _pow(T a, T b) { return (T)pow(a, b); }
-    template<typename T>
-    T _minus(T a) { return -a; }
-    template<typename T>
-    T _return(T value) { return value; }
-    template<typename T>
-    bool _equals(T a, T b) { return a == b; }
-    template<typename T>
-    bool _not_equals(T a, T b) { return a != b; }
-    template<typename T>
-    std::string _print(T _value)
-    {
-        std::string result = _to_string(_value);
-        printf("print: %s\n", result.c_str());
-        return result;
-    }
+    std::string _number(double n) { return format::number(n); }
+
+#   define NDBL_MATH_LIBRARY(...) __VA_ARGS__
+#   include "Nodlang_math.inl"
+#   undef NDBL_MATH_LIBRARY
 }
 
 REFLECT_STATIC_INITIALIZER
@@ -145,11 +93,7 @@ REFLECT_STATIC_INITIALIZER
         .add_method<std::string(bool)>(&_to_string, "to_string")
         .add_method<std::string(double)>(&_to_string, "to_string")
         .add_method<std::string(i32_t)>(&_to_string, "to_string")
-        .add_method<std::string(std::string)>(&_to_string, "to_string")
-        .add_method<std::string(bool)>(&_print, "print")
-        .add_method<std::string(double)>(&_print, "print")
-        .add_method<std::string(i32_t)>(&_print, "print")
-        .add_method<std::string(std::string)>(&_print, "print");
+        .add_method<std::string(std::string)>(&_to_string, "to_string");
 );
 
 Nodlang_math::Nodlang_math(){} // necessary to trigger static code execution
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Implementations of the math library (cf. Nodlang_math.cpp), also compiled ahead-of-time in each program emitted by CEmitter.
+// The includer defines NDBL_MATH_LIBRARY(...) to expand them as code or as a string, and provides:
+// - <cmath>, <stdexcept>, <string> and i32_t,
+// - std::string _number(double), formatting a number as tools::format::number() does.
+// Keep it free of comments and preprocessor directives inside the macro: it is stringified (cf. CEmitter.cpp).
+NDBL_MATH_LIBRARY(
+    bool _and(bool a, bool b) { return a && b; }
+    bool _implies(bool a, bool b) { return !a || b; }
+    bool _not(bool b) { return !b; }
+    bool _or(bool a, bool b) { return a || b; }
+    bool _to_bool(double n) { return n == 0.0; }
+    bool _xor(bool a, bool b){ return a ^ b; }
+    double _cos(double n) { return std::cos(n); }
+    double _mod(double a, double b) { return a - b * std::floor(a / b); }
+    double _secondDegreePolynomial(double a, double x, double b, double y, double c) { return a * x * x + b * y + c;}
+    double _sin(double n) { return std::sin(n); }
+    std::string _to_string(bool b) { return b ? "true" : "false"; }
+    std::string _to_string(double n) { return _number(n); }
+    std::string _to_string(i32_t i) { return std::to_string(i); }
+    std::string _to_string(std::string s) { return s; }
+    template<typename T, typename U>
+    T _minus(T a, U b){ return a - T(b); }
+    template<typename T, typename U>
+    T _multiply(T a, U b) { return a * T(b); }
+    template<typename T, typename U>
+    T _plus(T a, U b){ return a + T(b); }
+    template<typename T>
+    T _plus(T a, T b){ return a + T(b); }
+    template<>
+    std::string _plus(std::string left, double right) { return left + _number(right); }
+    template<>
+    std::string _plus(std::string left, i32_t right) { return left + std::to_string(right); }
+    template<typename T, typename U>
+    T _divide(T a, U b) { if ( b == 0 ) throw std::runtime_error("division by zero !"); return a / T(b);}
+    template<typename T, typename U>
+    T _assign(T& a, U b) { return a = T(b); }
+    template<typename T>
+    T _sqrt(T n) { return (T)sqrt((float)n); }
+    template<typename T, typename U>
+    bool _greater(T a, U b) { return a > b; }
+    template<typename T, typename U>
+    bool _greater_or_eq(T a, U b) { return a >= b; }
+    template<typename T, typename U>
+    bool _lower(T a, U b) { return a < b; }
+    template<typename T, typename U>
+    bool _lower_or_eq(T a, U b) { return a <= b; }
+    template<typename T>
+    T _pow(T a, T b) { return (T)pow(a, b); }
+    template<typename T>
+    T _minus(T a) { return -a; }
+    template<typename T>
+    T _return(T value) { return value; }
+    template<typename T>
+    bool _equals(T a, T b) { return a == b; }
+    template<typename T>
+    bool _not_equals(T a, T b) { return a != b; }
+)
@@ -150,6 +150,7 @@ ndbl::Config::Config(tools::Config* _tools_cfg)
     // Graph
     ui_graph_grid_color_major             = Color(0, 0, 0, 42);
     ui_graph_grid_color_minor             = Color(0, 0, 0, 17);
+    ui_graph_profiler_heat_color          = Color(255, 0, 0, 160);
     ui_grid_subdiv_count                  = 4;
     ui_grid_size                          = 100.0f;
 
@@ -158,6 +159,7 @@ ndbl::Config::Config(tools::Config* _tools_cfg)
                                           | ConfigFlag_EXPERIMENTAL_MULTI_SELECTION;
     isolation                             = Isolation_OFF;
     graph_view_unfold_duration            = 2.0f; // simulate 2sec
+    interpreter_slice_duration            = 8000000; // 8ms, half a frame at 60 fps
 
     // NodableView
     tools_cfg->dockspace_right_ratio       = 0.25f;
@@ -88,6 +88,7 @@ namespace ndbl
         Vec4           ui_overlay_text_color;
         Vec4           ui_graph_grid_color_major;
         Vec4           ui_graph_grid_color_minor;
+        Vec4           ui_graph_profiler_heat_color; // color of the hottest node when profiling, the others are more transparent
         i32_t          ui_grid_subdiv_count;
         i32_t          ui_grid_size;
         const char*    ui_file_info_window_label;
@@ -109,6 +110,7 @@ namespace ndbl
         float          ui_scope_gap(tools::Size size = tools::Size_DEFAULT) const;
         Isolation      isolation;
         float          graph_view_unfold_duration; // The virtual duration used to simulate a graph view unfolding, like accelerating time.
+        u64_t          interpreter_slice_duration; // Duration (in nanoseconds) the running program is given each frame, the rest of the frame is left to the views (cf. Interpreter::run_for()).
         ConfigFlags    flags;
         tools::Config* tools_cfg;
 
@@ -12,6 +12,7 @@
 #include "Event.h"
 #include "File.h"
 #include "GraphView.h"
+#include "Nodable.h"
 #include "NodeView.h"
 #include "commands/Cmd_ReplaceText.h"
 #include "commands/Cmd_WrappedTextEditorUndoRecord.h"
@@ -1,6 +1,8 @@
 #include "GraphView.h"
 
 #include <algorithm>
+#include <cstdio>
+#include <unordered_map>
 #include "tools/core/types.h"
 #include "tools/core/log.h"
 #include "tools/gui/ImGuiEx.h"
@@ -371,11 +373,50 @@ bool GraphView::draw(float dt)
                 ImGui::SetScrollHereY();
     }
 
+    // Profiler heat overlay (the node pointers of the report are only compared, they might be deleted since)
+    const Profiler* profiler = interpreter->get_profiler();
+    if ( profiler != nullptr && profiler->size() != 0 )
+    {
+        const float total = (float)std::max<u64_t>(1, profiler->get_total_nanoseconds());
+        std::unordered_map<const Node*, u64_t> nanoseconds;
+        for ( const Profiler::Entry& each : profiler->get_report() )
+            nanoseconds[each.node] = each.nanoseconds;
+
+        for (Node* node : graph()->nodes() )
+        {
+            NodeView* nodeview = node->get_component<NodeView>();
+            auto found = nanoseconds.find(node);
+            if ( !nodeview || !nodeview->state().visible() || found == nanoseconds.end() )
+                continue;
+
+            const float share = (float)found->second / total;
+            const Rect  rect  = nodeview->get_rect();
+            Vec4 heat_color   = cfg->ui_graph_profiler_heat_color;
+            heat_color.w     *= share;
+            draw_list->AddRectFilled(rect.min, rect.max, ImGui::GetColorU32(heat_color));
+
+            char label[16];
+            snprintf(label, sizeof(label), "%.1f%%", 100.f * share);
+            draw_list->AddText(rect.min - Vec2(0.f, ImGui::GetTextLineHeight()), ImColor(255, 255, 255), label);
+        }
+    }
+
+    // Breakpoints (the interpreter's nodes are only compared, they might be deleted since)
+    if ( !interpreter->get_breakpoints().empty() )
+    {
+        for (Node* node : graph()->nodes() )
+        {
+            const NodeView* view = node->get_component<NodeView>();
+            if ( view && view->state().visible() && interpreter->has_breakpoint(node) )
+                draw_list->AddCircleFilled(view->get_rect().top_left(), 6.0f, ImColor(220, 40, 40));
+        }
+    }
+
     // Virtual Machine cursor
-    if (interpreter->is_program_running())
+    const Node* next_node = interpreter->is_program_running() ? interpreter->get_next_node() : nullptr;
+    if ( next_node != nullptr )
     {
-        const Node* node = interpreter->get_next_node();
-        if (const NodeView* view = node->get_component<NodeView>())
+        if (const NodeView* view = next_node->get_component<NodeView>())
         {
             Vec2 left = view->get_rect().left();
             Vec2 interpreter_cursor_pos = Vec2::round(left);
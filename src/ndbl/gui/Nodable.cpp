@@ -1,6 +1,7 @@
 #include "Nodable.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 #include "tools/core/assertions.h"
 #include "tools/core/System.h"
@@ -30,6 +31,8 @@
 using namespace ndbl;
 using namespace tools;
 
+static Nodable* g_app{nullptr}; // app being run, its views display a single program at a time
+
 void Nodable::init()
 {
     LOG_VERBOSE("ndbl::Nodable", "init_ex ...\n");
@@ -38,9 +41,10 @@ void Nodable::init()
     m_view = new NodableView();
     m_base_app.init_ex(m_view->get_base_view_handle(), m_config->tools_cfg ); // the pointers are owned by this class, base app just use them.
     m_language          = init_language();
-    m_interpreter       = init_interpreter();
+    m_interpreter       = new Interpreter();
     m_node_factory      = init_node_factory();
     m_component_factory = init_component_factory();
+    g_app = this;
     m_view->init(this); // must be last
 
     log::set_verbosity("Physics", log::Verbosity_Error );
@@ -62,14 +66,27 @@ void Nodable::update()
     }
     m_flagged_to_delete_file.clear();
 
-    // 2. Update current file
+    // 2. Run the program for a slice of this frame (the graph must not change until it stops)
+    if ( m_interpreter->is_program_running() && !m_interpreter->is_debugging() )
+    {
+        try
+        {
+            m_interpreter->run_for( m_config->interpreter_slice_duration );
+        }
+        catch ( std::runtime_error& error )
+        {
+            LOG_ERROR("Nodable", "Unable to run the program! %s\n", error.what());
+        }
+    }
+
+    // 3. Update current file
     if (m_current_file && !m_interpreter->is_program_running())
     {
         m_current_file->set_isolation( m_config->isolation ); // might change
         m_current_file->update();
     }
 
-    // 3. Handle events
+    // 4. Handle events
 
     // Nodable events
     IEvent*       event = nullptr;
@@ -423,7 +440,10 @@ void Nodable::shutdown()
     }
 
     // shutdown managers & co.
-    shutdown_interpreter(m_interpreter);
+    m_interpreter->release_program();
+    m_code_cache.clear();
+    delete m_interpreter;
+    m_interpreter = nullptr;
     shutdown_node_factory(m_node_factory);
     shutdown_component_factory(m_component_factory);
     shutdown_language(m_language);
@@ -432,10 +452,16 @@ void Nodable::shutdown()
     shutdown_config(m_config);
 
     delete m_view;
+    g_app = nullptr;
 
     LOG_VERBOSE("ndbl::Nodable", "shutdown " OK "\n");
 }
 
+Interpreter* ndbl::get_interpreter()
+{
+    return g_app != nullptr ? g_app->get_interpreter() : nullptr;
+}
+
 File* Nodable::open_asset_file(const tools::Path& _path)
 {
     if ( _path.is_absolute() )
@@ -511,21 +537,20 @@ void Nodable::close_file( File* _file)
     }
 }
 
-bool Nodable::compile_and_load_program() const
+bool Nodable::compile_and_load_program()
 {
     if (!m_current_file)
     {
         return false;
     }
 
-    Compiler compiler{};
-    auto asm_code = compiler.compile_syntax_tree(&m_current_file->graph());
+    m_interpreter->release_program(); // the code loaded might be evicted from the cache
+    auto asm_code = m_code_cache.compile(m_compiler, &m_current_file->graph(), CompilerFlag_DEBUG_INFO); // debug info are required by the assembly view
     if (!asm_code)
     {
         return false;
     }
 
-    m_interpreter->release_program();
     bool loaded = m_interpreter->load_program(asm_code);
     return loaded;
 }
@@ -534,7 +559,7 @@ void Nodable::run_program()
 {
     if (compile_and_load_program() )
     {
-        m_interpreter->run_program();
+        m_interpreter->start_program(); // it runs by slices, one per frame (cf. update())
     }
 }
 
@@ -565,6 +590,43 @@ void Nodable::step_over_program()
     graph_view->selection().append( next_node->get_component<NodeView>() );
 }
 
+void Nodable::continue_program()
+{
+    m_interpreter->debug_continue();
+    GraphView* graph_view = m_current_file->graph().view();
+    graph_view->selection().clear();
+
+    if ( const Node* next_node = m_interpreter->get_next_node() )
+    {
+        graph_view->selection().append( next_node->get_component<NodeView>() );
+    }
+}
+
+void Nodable::toggle_breakpoints()
+{
+    if ( !m_current_file )
+    {
+        return;
+    }
+
+    for( NodeView* view : m_current_file->graph().view()->selection().collect<NodeView*>() )
+    {
+        const Node* node = view->node();
+        m_interpreter->set_breakpoint(node, !m_interpreter->has_breakpoint(node));
+    }
+}
+
+void Nodable::set_profiling(bool _enable)
+{
+    m_profiler.clear();
+    m_interpreter->set_profiler(_enable ? &m_profiler : nullptr);
+}
+
+bool Nodable::is_profiling() const
+{
+    return m_interpreter->get_profiler() != nullptr;
+}
+
 void Nodable::stop_program()
 {
     m_interpreter->stop_program();
@@ -578,6 +640,7 @@ void Nodable::reset_program()
     {
         m_interpreter->stop_program();
     }
+    m_interpreter->clear_breakpoints(); // nodes are about to be regenerated
 
     // n.b. nodable is still text oriented
     m_current_file->set_graph_dirty();
@@ -5,6 +5,9 @@
 #include <string>
 
 #include "tools/gui/App.h"
+#include "ndbl/core/CodeCache.h"
+#include "ndbl/core/Compiler.h"
+#include "ndbl/core/Profiler.h"
 
 #include "Config.h"
 #include "types.h"
@@ -50,12 +53,18 @@ namespace ndbl
 
         // Virtual Machine
 
-        void            run_program();
+        void            run_program(); // Start the current file's program, it then runs a little each frame so the views stay responsive (cf. Config::interpreter_slice_duration).
         void            debug_program();
         void            step_over_program();
+        void            continue_program(); // Run until the next breakpoint (cf. Interpreter::debug_continue()), works only when debugging.
+        void            toggle_breakpoints(); // Toggle a breakpoint on each selected node (cf. Interpreter::set_breakpoint()).
         void            stop_program();
         void            reset_program();
-        bool            compile_and_load_program() const;
+        bool            compile_and_load_program(); // Compile the current file's graph (or reuse its code, cf. CodeCache) and load it in the Interpreter.
+        Interpreter*    get_interpreter() const { return m_interpreter; }
+        void            set_profiling(bool); // Profile (or not) the next runs, samples are displayed over the graph (cf. GraphView).
+        bool            is_profiling() const;
+        const CodeCache& get_code_cache() const { return m_code_cache; }
 
     private:
         tools::App         m_base_app;
@@ -69,5 +78,10 @@ namespace ndbl
         u8_t               m_untitled_file_count = 0;
         std::vector<File*> m_loaded_files;
         std::vector<File*> m_flagged_to_delete_file;
+        Compiler           m_compiler;
+        CodeCache          m_code_cache;
+        Profiler           m_profiler;
     };
+
+    Interpreter* get_interpreter(); // Get the Interpreter of the running app, the one displayed by the views (nullptr when not initialized).
 }
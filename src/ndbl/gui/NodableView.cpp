@@ -175,7 +175,7 @@ void NodableView::draw()
 
     EventManager*   event_manager   = get_event_manager();
     Config*         cfg             = get_config();
-    Interpreter*    interpreter     = get_interpreter();
+    Interpreter*    interpreter     = m_app->get_interpreter();
     tools::Config*  tools_cfg       = tools::get_config();
     bool            redock_all      = true;
     File*           current_file    = m_app->get_current_file();
@@ -307,6 +307,12 @@ void NodableView::draw()
             if (ImGui::MenuItem(ICON_FA_ARROW_RIGHT" Step Over", "", false, interpreter_is_debugging))
                 m_app->step_over_program();
 
+            if (ImGui::MenuItem(ICON_FA_FAST_FORWARD" Continue", "", false, interpreter_is_debugging))
+                m_app->continue_program();
+
+            if (ImGui::MenuItem(ICON_FA_CIRCLE" Toggle Breakpoint", "", false, has_selection))
+                m_app->toggle_breakpoints();
+
             if (ImGui::MenuItem(ICON_FA_STOP" Stop", "", false, !interpreter_is_stopped))
                 m_app->stop_program();
 
@@ -551,7 +557,7 @@ void NodableView::draw_interpreter_window()
     Config* cfg = get_config();
     if (ImGui::Begin( cfg->ui_interpreter_window_label))
     {
-        auto* interpreter = get_interpreter();
+        auto* interpreter = m_app->get_interpreter();
 
         ImGui::Text("Interpreter:");
         ImGui::SameLine();
@@ -606,6 +612,12 @@ void NodableView::draw_interpreter_window()
             draw_register_value(Register_eip);
             ImGui::SameLine();
             ImGuiEx::DrawHelper("%s", "instruction pointer");
+            for ( int reg = Register_GP_FIRST; reg < Register_GP_FIRST + Register_GP_COUNT; ++reg )
+            {
+                draw_register_value((Register)reg);
+                ImGui::SameLine();
+                ImGuiEx::DrawHelper("%s", "general purpose, holds a variable (cf. Compiler's register allocation)");
+            }
 
             ImGui::Unindent();
         }
@@ -625,6 +637,10 @@ void NodableView::draw_interpreter_window()
             ImGuiEx::DrawHelper("%s", "The bytecode is the result of the Compilation process."
                                           "\nAfter source code has_flags been parsed to a syntax tree, "
                                           "\nthe tree (or graph) is converted by the Compiler to an Assembly-like code.");
+            const CodeCache& code_cache = m_app->get_code_cache();
+            ImGui::Text("cache: %zu hit(s), %zu miss(es), %zu KiB", code_cache.get_hit_count(), code_cache.get_miss_count(), code_cache.get_memory_usage() / 1024);
+            ImGui::SameLine();
+            ImGuiEx::DrawHelper("%s", "The code of a graph which did not change since its last compilation is reused.");
             ImGui::Checkbox("Auto-scroll ?", &m_scroll_to_curr_instr);
             ImGui::SameLine();
             ImGuiEx::DrawHelper("%s", "to scroll automatically to the current instruction");
@@ -634,9 +650,9 @@ void NodableView::draw_interpreter_window()
 
                 if (code) {
                     auto current_instr = interpreter->get_next_instr();
-                    for (Instruction *each_instr: code->get_instructions()) {
-                        auto str = Instruction::to_string(*each_instr);
-                        if (each_instr == current_instr) {
+                    for (size_t i = 0; i < code->size(); ++i) {
+                        auto str = code->instruction_to_string(i);
+                        if (code->get_instruction_at(i) == current_instr) {
                             if (m_scroll_to_curr_instr && interpreter->is_program_running()) {
                                 ImGui::SetScrollHereY();
                             }
@@ -914,7 +930,7 @@ void NodableView::draw_toolbar_window()
 
         if ( cfg->has_flags(ConfigFlag_EXPERIMENTAL_INTERPRETER) )
         {
-            Interpreter* interpreter = get_interpreter();
+            Interpreter* interpreter = m_app->get_interpreter();
             bool running             = interpreter->is_program_running();
             bool debugging           = interpreter->is_debugging();
             bool stopped             = interpreter->is_program_stopped();
@@ -950,11 +966,26 @@ void NodableView::draw_toolbar_window()
             }
             ImGui::SameLine();
 
+            // continue (until the next breakpoint)
+            if (ImGui::Button(ICON_FA_FAST_FORWARD " continue", button_size) && interpreter->is_debugging()) {
+                m_app->continue_program();
+            }
+            ImGui::SameLine();
+
             // stop
             if (ImGui::Button(ICON_FA_STOP " stop", button_size) && !stopped) {
                 m_app->stop_program();
             }
             ImGui::SameLine();
+
+            // profile
+            bool profiling = m_app->is_profiling();
+            if (profiling) ImGui::PushStyleColor(ImGuiCol_Button, cfg->tools_cfg->button_activeColor);
+            if (ImGui::Button(ICON_FA_STOPWATCH " profile", button_size) && stopped) {
+                m_app->set_profiling(!profiling);
+            }
+            if (profiling) ImGui::PopStyleColor();
+            ImGui::SameLine();
         }
 
         // reset
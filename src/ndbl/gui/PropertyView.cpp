@@ -3,6 +3,7 @@
 #include "ndbl/core/language/Nodlang.h"
 #include "ndbl/core/Node.h"
 #include "ndbl/core/Interpreter.h"
+#include "Nodable.h"
 #include "NodeView.h"
 #include "Config.h"
 
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstring>
+#include <string>
 #include <xxhash/xxhash32.h>
+#include <xxhash/xxhash64.h>
 
 namespace tools
 {
@@ -35,5 +37,17 @@ namespace tools
         {
             return XXHash64::hash(str, size, seed);
         }
+
+        // Combine a given hash with the hash of a given value (order matters)
+        template<typename T>
+        static u64_t combine(u64_t seed, const T& data)
+        {
+            return _hash(&data, sizeof(T), seed);
+        }
+
+        static u64_t combine(u64_t seed, const std::string& str)
+        {
+            return _hash(str.data(), str.size(), combine(seed, str.size()));
+        }
     };
 }
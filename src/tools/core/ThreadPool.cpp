@@ -0,0 +1,62 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include "assertions.h"
+
+using namespace tools;
+
+ThreadPool::ThreadPool(size_t _thread_count)
+{
+    VERIFY(_thread_count > 0, "A ThreadPool needs at least one thread");
+    m_threads.reserve(_thread_count);
+    for ( size_t i = 0; i < _thread_count; ++i )
+    {
+        m_threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stopping = true;
+    }
+    m_condition.notify_all();
+    for ( std::thread& each : m_threads )
+    {
+        each.join();
+    }
+}
+
+void ThreadPool::run(Job&& _job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(_job));
+    }
+    m_condition.notify_one();
+}
+
+size_t ThreadPool::get_default_thread_count()
+{
+    const size_t hardware_thread_count = std::thread::hardware_concurrency(); // can be 0 when unknown
+    return std::max<size_t>(1, hardware_thread_count > 0 ? hardware_thread_count - 1 : 1);
+}
+
+void ThreadPool::work()
+{
+    for(;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_is_stopping || !m_jobs.empty(); });
+            if ( m_jobs.empty() )
+            {
+                return; // stopping, and nothing left to do
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
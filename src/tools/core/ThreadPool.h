@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "types.h"
+
+namespace tools
+{
+    /**
+     * @class Fixed set of worker threads running the jobs pushed to a shared queue (first in, first out).
+     * Unlike TaskManager, threads are created once, a job costs a queue push (no thread is created per job).
+     * @example @code
+     * ThreadPool pool(4);
+     * pool.run([]() -> void {...});
+     * ... more jobs ...
+     * // pending jobs are run before the pool is destroyed
+     */
+    class ThreadPool
+    {
+    public:
+        typedef std::function<void(void)> Job;
+
+        explicit ThreadPool(size_t _thread_count = get_default_thread_count());
+        ~ThreadPool(); // Wait for the queued jobs, then join the threads.
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void          run(Job&&);                                            // Queue a job, the first idle thread will run it. A job must not throw.
+        size_t        size() const { return m_threads.size(); }              // Get the worker thread count.
+        static size_t get_default_thread_count();                            // Get the hardware thread count minus one (the thread pushing jobs usually works too), at least 1.
+
+    private:
+        void                     work();                                     // Worker thread's loop.
+        std::vector<std::thread> m_threads;
+        std::deque<Job>          m_jobs;
+        std::mutex               m_mutex;      // protects m_jobs and m_is_stopping
+        std::condition_variable  m_condition;  // notified when a job is queued, or when stopping
+        bool                     m_is_stopping = false;
+    };
+}
@@ -51,6 +51,8 @@ string32  format::time_point_to_string(const std::chrono::system_clock::time_poi
     ctime_s(str, sizeof str, &time);
     return {str, 24};
 #else
-    return {ctime(&time), 24};
+    char str[26];
+    ctime_r(&time, str); // reentrant, log can be used by several threads
+    return {str, 24};
 #endif
 }
\ No newline at end of file
@@ -11,6 +11,12 @@ log::MessageDeque& log::get_messages()
     return logs;
 }
 
+std::mutex& log::get_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
 std::map<std::string, log::Verbosity>& log::get_verbosity_by_category()
 {
     // use singleton pattern instead of static member to avoid static code issues
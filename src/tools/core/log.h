@@ -7,6 +7,7 @@
 #include <deque>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <string>
 
 #define RESET   "\033[0m"
@@ -113,6 +114,7 @@ namespace tools
                 Args... args); // Push a new message for a given category
 
     private:
+        static std::mutex&          get_mutex(); // protects the printing and the messages, log can be used by several threads
         static Verbosity            s_verbosity; // global verbosity level
         static std::map<std::string, Verbosity>& get_verbosity_by_category();
     };
@@ -138,6 +140,8 @@ namespace tools
         // text body
         message.text.append_fmt(_format, args...);
 
+        std::lock_guard<std::mutex> lock(get_mutex());
+
         // print if allowed
         if ( message.verbosity <= get_verbosity(_category) )
         {
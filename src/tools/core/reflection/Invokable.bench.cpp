@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "Invokable.h"
+
+using namespace tools;
+
+static double add(double a, double b) { return a + b; }
+
+static void BM_direct_call(benchmark::State& state)
+{
+    double (* volatile function)(double, double) = &add; // volatile: prevents inlining, like any indirect call
+    double a = 1.0;
+    for (auto _ : state)
+    {
+        a = function(a, 1.0);
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+static void BM_invoke(benchmark::State& state)
+{
+    InvokableStaticFunction<double(double, double)> invokable("add", &add);
+    variant a = 1.0;
+    variant b = 1.0;
+    for (auto _ : state)
+    {
+        a = invokable.invoke({ &a, &b });
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+static void BM_native_call(benchmark::State& state)
+{
+    InvokableStaticFunction<double(double, double)> invokable("add", &add);
+    const NativeCall& native = invokable.get_native();
+    variant args[2] = { 1.0, 1.0 };
+    for (auto _ : state)
+    {
+        native(args, &args[0]);
+        benchmark::DoNotOptimize(args[0]);
+    }
+}
+
+BENCHMARK(BM_direct_call);
+BENCHMARK(BM_invoke);
+BENCHMARK(BM_native_call);
+
+BENCHMARK_MAIN();
@@ -11,6 +11,25 @@
 
 namespace tools
 {
+    /**
+     * Allocation-free call of a native function (cf. IInvokable::get_native()).
+     * Arguments are contiguous variants (ex: stack slots) already holding the exact argument types, they are read as raw qwords,
+     * the result (if any) is written to a given variant (it may be one of the arguments).
+     * Only functions taking and returning bool, i16_t, i32_t or double by value (or returning void) have one.
+     */
+    struct NativeCall
+    {
+        typedef void (*FunctionPtr)(); // any function pointer, cast back by the thunk
+        typedef void (*Thunk)(FunctionPtr, const variant* _args, variant* _result);
+
+        Thunk       thunk      = nullptr;
+        FunctionPtr function   = nullptr;
+        size_t      arg_count  = 0;
+        bool        has_result = false; // false when returning void
+
+        bool valid() const { return thunk != nullptr; }
+        void operator()(const variant* _args, variant* _result) const { thunk(function, _args, _result); }
+    };
 
     class IInvokable
     {
@@ -18,6 +37,9 @@ namespace tools
         virtual ~IInvokable() = default;
         virtual const FunctionDescriptor* get_sig() const = 0;
         virtual variant invoke(const std::vector<variant *> &_args) const = 0;
+        const NativeCall& get_native() const { return m_native; } // Get the allocation-free call, not valid when the signature does not allow it.
+    protected:
+        NativeCall m_native;
     };
 
     class IInvokableMethod
@@ -177,6 +199,47 @@ namespace tools
         }
     };
 
+    // Check if a given type can be read/written as a raw qword by a NativeCall
+    template<typename T>
+    constexpr bool is_native_v = std::is_same_v<T, bool> || std::is_same_v<T, i16_t> || std::is_same_v<T, i32_t> || std::is_same_v<T, double>;
+
+    // Read a native type from a raw qword
+    template<typename T>
+    inline T native_get(const qword& _qword)
+    {
+        static_assert( is_native_v<T> );
+        if constexpr ( std::is_same_v<T, bool> )       return _qword.b;
+        else if constexpr ( std::is_same_v<T, i16_t> ) return _qword.i16;
+        else if constexpr ( std::is_same_v<T, i32_t> ) return _qword.i32;
+        else                                           return _qword.d;
+    }
+
+    // Thunk of a NativeCall, generated for a given function type (cf. InvokableStaticFunction)
+    template<typename FunctionT>
+    struct NativeThunk
+    {
+        static constexpr bool supported = false;
+    };
+
+    template<typename ResultT, typename ...Args>
+    struct NativeThunk<ResultT(Args...)>
+    {
+        static constexpr bool supported = ( std::is_void_v<ResultT> || is_native_v<ResultT> ) && ( is_native_v<Args> && ... );
+
+        static void call(NativeCall::FunctionPtr _function, const variant* _args, variant* _result)
+        { call_ex( reinterpret_cast<ResultT(*)(Args...)>(_function), _args, _result, std::index_sequence_for<Args...>() ); }
+
+    private:
+        template<std::size_t... Indices>
+        static inline void call_ex(ResultT(*_function)(Args...), const variant* _args, variant* _result, std::index_sequence<Indices...>)
+        {
+            if constexpr ( std::is_void_v<ResultT> )
+                _function( native_get<Args>(*_args[Indices].data())... );
+            else
+                _result->set( _function( native_get<Args>(*_args[Indices].data())... ) ); // arguments are read before the result is written
+        }
+    };
+
     /** Generic Invokable (works for static only) */
     template<typename FunctionT>
     class InvokableStaticFunction : public IInvokable
@@ -190,6 +253,13 @@ namespace tools
         {
             ASSERT( m_function_pointer );
             m_function_signature.init<FunctionT>(_name);
+            if constexpr ( NativeThunk<FunctionT>::supported )
+            {
+                m_native.thunk      = &NativeThunk<FunctionT>::call;
+                m_native.function   = reinterpret_cast<NativeCall::FunctionPtr>(m_function_pointer);
+                m_native.arg_count  = m_function_signature.arg_count();
+                m_native.has_result = !std::is_void_v<typename FunctionTrait<FunctionT>::result_t>;
+            }
         }
 
         variant invoke(const std::vector<variant *> &_args) const override
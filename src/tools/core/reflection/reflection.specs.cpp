@@ -75,3 +75,33 @@ TEST(Reflection, pass_by_ref)
    f.init<void(double &d)>("function");
    EXPECT_TRUE(f.arg_at(0).pass_by_ref );
 }
+
+static double native_add(double a, double b) { return a + b; }
+static bool   native_greater(i32_t a, i32_t b) { return a > b; }
+static std::string native_concat(std::string a, std::string b) { return a + b; }
+
+TEST(Reflection, native_call)
+{
+    InvokableStaticFunction<double(double, double)> add("add", &native_add);
+    ASSERT_TRUE(add.get_native().valid());
+    EXPECT_EQ(add.get_native().arg_count, 2);
+    EXPECT_TRUE(add.get_native().has_result);
+
+    // arguments are contiguous, the result may replace the first one
+    variant args[2] = { 1.5, 2.0 };
+    add.get_native()(args, &args[0]);
+    EXPECT_EQ((double)args[0], 3.5);
+
+    InvokableStaticFunction<bool(i32_t, i32_t)> greater("greater", &native_greater);
+    variant int_args[2] = { (i32_t)3, (i32_t)2 };
+    variant result;
+    greater.get_native()(int_args, &result);
+    EXPECT_TRUE(result.is_type(type::get<bool>()));
+    EXPECT_TRUE((bool)result);
+}
+
+TEST(Reflection, native_call_requires_qword_types)
+{
+    InvokableStaticFunction<std::string(std::string, std::string)> concat("concat", &native_concat);
+    EXPECT_FALSE(concat.get_native().valid());
+}
@@ -188,17 +188,21 @@ void variant::set(i16_t _value)
 
 void variant::set(i32_t _value)
 {
-    auto* type = type::get<i32_t>();
-    if ( !is_type(type) )
-        change_type(type);
+    if ( m_type != Type_i32 )
+    {
+        change_type(Type_i32); // compare the internal Type enum, faster than is_type()
+        init_mem();
+    }
     m_data.i32 = _value;
 }
 
 void variant::set(bool _value)
 {
-    auto* type = type::get<bool>();
-    if ( !is_type(type) )
-        change_type(type);
+    if ( m_type != Type_bool )
+    {
+        change_type(Type_bool);
+        init_mem();
+    }
     m_data.b = _value;
 }
 
@@ -351,6 +355,21 @@ bool variant::is_type(const tools::TypeDescriptor* _type) const
     return m_type == type_to_enum(_type); // compare the internal Type enum values
 }
 
+void variant::convert(const TypeDescriptor* _type)
+{
+    if ( is_type(_type) )
+    {
+        return;
+    }
+
+    if      ( _type->is<double>() )      set( to<double>() );
+    else if ( _type->is<i32_t>() )       set( to<i32_t>() );
+    else if ( _type->is<i16_t>() )       set( to<i16_t>() );
+    else if ( _type->is<bool>() )        set( to<bool>() );
+    else if ( _type->is<std::string>() ) set( to<std::string>() );
+    // other types (any, pointers) are not converted
+}
+
 bool variant::is_mem_initialized() const
 {
     if ( m_type != Type_string ) // only strings are heap allocated
@@ -363,7 +382,3 @@ const TypeDescriptor* variant::get_type() const
     return enum_to_type(m_type);
 }
 
-const qword *variant::data() const
-{
-    return &m_data;
-}
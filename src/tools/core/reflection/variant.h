@@ -43,9 +43,10 @@ namespace tools
         const TypeDescriptor* get_type()const;
         bool        is_type(const TypeDescriptor*) const;
         void        change_type(const TypeDescriptor* _type);
+        void        convert(const TypeDescriptor* _type); // Convert the value in place to a given type (bool, numbers and string only, other types are left as is)
 
         void        clear_data();
-        const qword*data() const; // get ptr to underlying data (qword)
+        const qword*data() const { return &m_data; } // get ptr to underlying data (qword)
 
         template<typename T>
         T           to()const;